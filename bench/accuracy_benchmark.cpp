@@ -0,0 +1,232 @@
+//
+// Created by Raphael Russo on 12/03/24.
+//
+
+#include "synthetic_motion.h"
+#include "processing/filters/filter_factory.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace imu_viz;
+using namespace imu_viz::bench;
+
+namespace {
+    using FilterType = OrientationFilterFactory::FilterType;
+
+    struct AccuracyResult {
+        std::string key; // scenario/rate/filter, used to match rows against a baseline
+        double tiltRms{0};
+        double tiltMax{0};
+        double attitudeRms{0};
+        double attitudeMax{0};
+        double nsPerSample{0};
+    };
+
+    struct AccuracyOptions {
+        std::vector<double> rates{100.0, 1000.0};
+        double noiseScale{1.0};
+        double duration{30.0};
+        double settle{2.0}; // Seconds ignored at the start while filters converge
+        std::string csvPath;
+        std::string baselinePath;
+        double thresholdPercent{10.0};
+
+        static AccuracyOptions parse(int argc, char* argv[]) {
+            AccuracyOptions options;
+            for (int i = 1; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--rates" && i + 1 < argc) {
+                    options.rates.clear();
+                    std::stringstream ss(argv[++i]);
+                    std::string rate;
+                    while (std::getline(ss, rate, ',')) {
+                        options.rates.push_back(std::atof(rate.c_str()));
+                    }
+                } else if (arg == "--noise" && i + 1 < argc) {
+                    options.noiseScale = std::atof(argv[++i]);
+                } else if (arg == "--duration" && i + 1 < argc) {
+                    options.duration = std::atof(argv[++i]);
+                } else if (arg == "--settle" && i + 1 < argc) {
+                    options.settle = std::atof(argv[++i]);
+                } else if (arg == "--csv" && i + 1 < argc) {
+                    options.csvPath = argv[++i];
+                } else if (arg == "--baseline" && i + 1 < argc) {
+                    options.baselinePath = argv[++i];
+                } else if (arg == "--threshold" && i + 1 < argc) {
+                    options.thresholdPercent = std::atof(argv[++i]);
+                }
+            }
+            return options;
+        }
+    };
+
+    const char* filterName(FilterType type) {
+        switch (type) {
+            case FilterType::COMPLEMENTARY: return "complementary";
+            case FilterType::MADGWICK: return "madgwick";
+            case FilterType::KALMAN: return "kalman";
+        }
+        return "unknown";
+    }
+
+    double radToDeg(double rad) { return rad * 180.0 / M_PI; }
+
+    // Angle between the gravity directions, yaw is unobservable without a magnetometer
+    double tiltError(const Quaterniond& truth, const Quaterniond& estimate) {
+        Vector3d upTruth = truth.conjugate() * Vector3d::UnitZ();
+        Vector3d upEstimate = estimate.conjugate() * Vector3d::UnitZ();
+        return std::atan2(upTruth.cross(upEstimate).norm(), upTruth.dot(upEstimate));
+    }
+
+    double attitudeError(const Quaterniond& truth, const Quaterniond& estimate) {
+        return truth.angularDistance(estimate);
+    }
+
+    AccuracyResult evaluate(FilterType type, const std::vector<SyntheticSample>& samples,
+                            double rate, double settle) {
+        auto filter = OrientationFilterFactory::createFilter(type);
+        std::vector<Quaterniond> estimates(samples.size());
+
+        // Timed pass only runs the filter, errors are computed afterwards
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const auto& s = samples[i];
+            filter->update(s.accel, s.gyro, s.dt);
+            estimates[i] = filter->getOrientation();
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        AccuracyResult result;
+        result.nsPerSample = elapsed / static_cast<double>(samples.size());
+
+        size_t counted = 0;
+        double tiltSq = 0.0;
+        double attitudeSq = 0.0;
+        const size_t first = static_cast<size_t>(settle * rate);
+        for (size_t i = first; i < samples.size(); ++i) {
+            double tilt = tiltError(samples[i].truth, estimates[i]);
+            double attitude = attitudeError(samples[i].truth, estimates[i]);
+            tiltSq += tilt * tilt;
+            attitudeSq += attitude * attitude;
+            result.tiltMax = std::max(result.tiltMax, tilt);
+            result.attitudeMax = std::max(result.attitudeMax, attitude);
+            ++counted;
+        }
+
+        if (counted > 0) {
+            result.tiltRms = radToDeg(std::sqrt(tiltSq / counted));
+            result.attitudeRms = radToDeg(std::sqrt(attitudeSq / counted));
+        }
+        result.tiltMax = radToDeg(result.tiltMax);
+        result.attitudeMax = radToDeg(result.attitudeMax);
+        return result;
+    }
+
+    bool writeCsv(const std::string& path, const std::vector<AccuracyResult>& results) {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "key,tilt_rms_deg,tilt_max_deg,attitude_rms_deg,attitude_max_deg,ns_per_sample\n";
+        for (const auto& r : results) {
+            out << r.key << ',' << r.tiltRms << ',' << r.tiltMax << ','
+                << r.attitudeRms << ',' << r.attitudeMax << ',' << r.nsPerSample << '\n';
+        }
+        return static_cast<bool>(out);
+    }
+
+    // Flags rows whose tilt RMS got worse by more than the threshold, returns the count
+    int compareWithBaseline(const std::string& path, const std::vector<AccuracyResult>& results,
+                            double thresholdPercent) {
+        std::ifstream in(path);
+        if (!in) {
+            std::fprintf(stderr, "Could not open baseline %s\n", path.c_str());
+            return -1;
+        }
+
+        std::map<std::string, std::pair<double, double>> baseline; // tilt rms, ns/sample
+        std::string line;
+        std::getline(in, line);
+        while (std::getline(in, line)) {
+            std::stringstream ss(line);
+            std::vector<std::string> fields;
+            std::string field;
+            while (std::getline(ss, field, ',')) fields.push_back(field);
+            if (fields.size() >= 6) {
+                baseline[fields[0]] = {std::atof(fields[1].c_str()), std::atof(fields[5].c_str())};
+            }
+        }
+
+        // Tiny absolute changes on already-accurate rows are noise, not regressions
+        constexpr double MIN_ABS_DEGREES = 0.05;
+
+        int regressions = 0;
+        std::printf("\n%-40s %10s %10s %10s %10s\n", "key", "tilt base", "tilt now", "ns base", "ns now");
+        for (const auto& r : results) {
+            auto it = baseline.find(r.key);
+            if (it == baseline.end()) continue;
+
+            double base = it->second.first;
+            bool regressed = r.tiltRms - base > MIN_ABS_DEGREES &&
+                             r.tiltRms > base * (1.0 + thresholdPercent / 100.0);
+            regressions += regressed ? 1 : 0;
+            std::printf("%-40s %10.3f %10.3f %10.1f %10.1f%s\n", r.key.c_str(), base, r.tiltRms,
+                        it->second.second, r.nsPerSample, regressed ? "  ACCURACY REGRESSION" : "");
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    AccuracyOptions options = AccuracyOptions::parse(argc, argv);
+    const NoiseModel noise = NoiseModel{}.scaled(options.noiseScale);
+
+    const Scenario scenarios[] = {
+            Scenario::STATIC,
+            Scenario::CONSTANT_RATE,
+            Scenario::FIGURE_EIGHT,
+            Scenario::SHAKING,
+    };
+    const FilterType filters[] = {
+            FilterType::COMPLEMENTARY,
+            FilterType::MADGWICK,
+            FilterType::KALMAN,
+    };
+
+    std::printf("Noise: accel %.3f m/s^2, gyro %.4f rad/s, %.0f s per run, first %.1f s ignored\n\n",
+                noise.accelNoise, noise.gyroNoise, options.duration, options.settle);
+    std::printf("%-14s %7s %-14s %10s %10s %10s %10s %10s\n", "scenario", "rate", "filter",
+                "tilt rms", "tilt max", "att rms", "att max", "ns/sample");
+
+    std::vector<AccuracyResult> results;
+    for (auto scenario : scenarios) {
+        for (double rate : options.rates) {
+            SyntheticMotion motion(scenario, rate, noise);
+            const auto samples = motion.generate(options.duration);
+
+            for (auto type : filters) {
+                AccuracyResult r = evaluate(type, samples, rate, options.settle);
+                r.key = std::string(scenarioName(scenario)) + "/" + std::to_string(static_cast<int>(rate))
+                        + "hz/" + filterName(type);
+                results.push_back(r);
+
+                std::printf("%-14s %7.0f %-14s %10.3f %10.3f %10.3f %10.3f %10.1f\n",
+                            scenarioName(scenario), rate, filterName(type),
+                            r.tiltRms, r.tiltMax, r.attitudeRms, r.attitudeMax, r.nsPerSample);
+            }
+        }
+    }
+    std::printf("\nErrors in degrees. Tilt ignores yaw, attitude includes it.\n");
+
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, results)) {
+        std::fprintf(stderr, "Could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    if (!options.baselinePath.empty()) {
+        return compareWithBaseline(options.baselinePath, results, options.thresholdPercent) != 0 ? 1 : 0;
+    }
+    return 0;
+}
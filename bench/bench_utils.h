@@ -0,0 +1,168 @@
+//
+// Created by Raphael Russo on 12/02/24.
+//
+
+#ifndef IMU_VISUALIZER_BENCH_UTILS_H
+#define IMU_VISUALIZER_BENCH_UTILS_H
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace imu_viz::bench {
+
+    // Keeps the compiler from optimising away work whose result is otherwise unused
+    template<typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    struct BenchResult {
+        std::string name;
+        double nsPerOp{0.0};
+        size_t iterations{0};
+    };
+
+    /**
+     * Times `iterations` calls of fn(i) and returns ns per call.
+     * Runs one untimed warm-up pass, then `repeats` timed passes and keeps the median
+     * so a single scheduler hiccup doesn't show up as a regression.
+     */
+    template<typename Fn>
+    inline BenchResult runBenchmark(const std::string& name, size_t iterations, Fn&& fn, int repeats = 5) {
+        using clock = std::chrono::steady_clock;
+
+        for (size_t i = 0; i < std::min<size_t>(iterations, 1000); ++i) {
+            fn(i);
+        }
+
+        std::vector<double> samples;
+        samples.reserve(repeats);
+        for (int r = 0; r < repeats; ++r) {
+            auto start = clock::now();
+            for (size_t i = 0; i < iterations; ++i) {
+                fn(i);
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            samples.push_back(elapsed / static_cast<double>(iterations));
+        }
+
+        std::sort(samples.begin(), samples.end());
+        return {name, samples[samples.size() / 2], iterations};
+    }
+
+    // Collects results, prints them as a table and compares against a previous CSV run
+    class BenchReport {
+    public:
+        void add(const BenchResult& result) {
+            results.push_back(result);
+            std::printf("%-48s %14.1f ns/op %12zu iters\n",
+                        result.name.c_str(), result.nsPerOp, result.iterations);
+            std::fflush(stdout);
+        }
+
+        const std::vector<BenchResult>& getResults() const { return results; }
+
+        bool writeCsv(const std::string& path) const {
+            std::ofstream out(path);
+            if (!out) return false;
+            out << "name,ns_per_op,iterations\n";
+            for (const auto& r : results) {
+                out << r.name << ',' << r.nsPerOp << ',' << r.iterations << '\n';
+            }
+            return static_cast<bool>(out);
+        }
+
+        /**
+         * Compares against a CSV written by writeCsv on an earlier commit.
+         * Returns the number of benchmarks that got slower by more than thresholdPercent.
+         */
+        int compareWithBaseline(const std::string& path, double thresholdPercent) const {
+            std::ifstream in(path);
+            if (!in) {
+                std::fprintf(stderr, "Could not open baseline %s\n", path.c_str());
+                return -1;
+            }
+
+            std::map<std::string, double> baseline;
+            std::string line;
+            std::getline(in, line); // Header
+            while (std::getline(in, line)) {
+                std::stringstream ss(line);
+                std::string name, ns;
+                if (std::getline(ss, name, ',') && std::getline(ss, ns, ',')) {
+                    baseline[name] = std::atof(ns.c_str());
+                }
+            }
+
+            int regressions = 0;
+            std::printf("\n%-48s %12s %12s %9s\n", "benchmark", "baseline", "current", "delta");
+            for (const auto& r : results) {
+                auto it = baseline.find(r.name);
+                if (it == baseline.end() || it->second <= 0.0) continue;
+
+                double delta = 100.0 * (r.nsPerOp - it->second) / it->second;
+                bool regressed = delta > thresholdPercent;
+                regressions += regressed ? 1 : 0;
+                std::printf("%-48s %12.1f %12.1f %+8.1f%%%s\n", r.name.c_str(),
+                            it->second, r.nsPerOp, delta, regressed ? "  REGRESSION" : "");
+            }
+            return regressions;
+        }
+
+    private:
+        std::vector<BenchResult> results;
+    };
+
+    // Minimal flag parsing shared by the benchmark executables
+    struct BenchOptions {
+        std::string csvPath;
+        std::string baselinePath;
+        double thresholdPercent{10.0};
+        bool quick{false};
+
+        static BenchOptions parse(int argc, char* argv[]) {
+            BenchOptions options;
+            for (int i = 1; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--csv" && i + 1 < argc) {
+                    options.csvPath = argv[++i];
+                } else if (arg == "--baseline" && i + 1 < argc) {
+                    options.baselinePath = argv[++i];
+                } else if (arg == "--threshold" && i + 1 < argc) {
+                    options.thresholdPercent = std::atof(argv[++i]);
+                } else if (arg == "--quick") {
+                    options.quick = true;
+                }
+            }
+            return options;
+        }
+
+        // Writes/compares as requested, returns the process exit code
+        int finish(const BenchReport& report) const {
+            if (!csvPath.empty() && !report.writeCsv(csvPath)) {
+                std::fprintf(stderr, "Could not write %s\n", csvPath.c_str());
+                return 1;
+            }
+            if (!baselinePath.empty()) {
+                int regressions = report.compareWithBaseline(baselinePath, thresholdPercent);
+                if (regressions != 0) return 1;
+            }
+            return 0;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_BENCH_UTILS_H
@@ -0,0 +1,402 @@
+//
+// Created by Raphael Russo on 12/02/24.
+//
+
+#include "bench_utils.h"
+#include "processing/fusion_engine.h"
+#include "processing/filters/filter_factory.h"
+#include "processing/calibration/ellipsoid_calibrator.h"
+#include "processing/calibration/sensor_transform.h"
+#include "processing/timing/resampler.h"
+#include "processing/timing/jitter_buffer.h"
+#include "transport/packet_decoder.h"
+#include "core/minmax_pyramid.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+using namespace imu_viz;
+using namespace imu_viz::bench;
+
+namespace {
+    constexpr size_t STREAM_LENGTH = 4096; // Power of two so the index wraps with a mask
+
+    struct SampleStream {
+        std::vector<Vector3d> accel;
+        std::vector<Vector3d> gyro;
+    };
+
+    // Same figure 8 motion MockTransport produces
+    SampleStream figureEightStream(double dt) {
+        SampleStream stream;
+        stream.accel.reserve(STREAM_LENGTH);
+        stream.gyro.reserve(STREAM_LENGTH);
+        for (size_t i = 0; i < STREAM_LENGTH; ++i) {
+            double t = i * dt;
+            stream.accel.emplace_back(std::sin(2 * t) * 3.0,
+                                      std::sin(t) * std::cos(t) * 3.0,
+                                      9.81 + std::sin(t * 0.5) * 0.5);
+            stream.gyro.emplace_back(std::sin(t * 0.5) * 0.3,
+                                     std::cos(t * 0.5) * 0.3,
+                                     1.0);
+        }
+        return stream;
+    }
+
+    // Device lying still, gyro small enough to take the angle ~ 0 branches
+    SampleStream nearZeroRotationStream() {
+        SampleStream stream;
+        for (size_t i = 0; i < STREAM_LENGTH; ++i) {
+            double wobble = (i % 2 == 0) ? 1e-12 : -1e-12;
+            stream.accel.emplace_back(0.0, 0.0, 9.81);
+            stream.gyro.emplace_back(wobble, -wobble, wobble);
+        }
+        return stream;
+    }
+
+    const char* filterName(OrientationFilterFactory::FilterType type) {
+        switch (type) {
+            case OrientationFilterFactory::FilterType::COMPLEMENTARY: return "complementary";
+            case OrientationFilterFactory::FilterType::MADGWICK: return "madgwick";
+            case OrientationFilterFactory::FilterType::KALMAN: return "kalman";
+        }
+        return "unknown";
+    }
+
+    void benchFilters(BenchReport& report, size_t iterations) {
+        const SampleStream steady = figureEightStream(0.01);      // 100 Hz like MockTransport
+        const SampleStream highRate = figureEightStream(0.0001);  // 10 kHz
+        const SampleStream still = nearZeroRotationStream();
+
+        struct Case {
+            const char* name;
+            const SampleStream* stream;
+            double dt;
+        };
+        const Case cases[] = {
+                {"steady", &steady, 0.01},
+                {"near_zero_rotation", &still, 0.01},
+                {"high_rate", &highRate, 0.0001},
+        };
+
+        const OrientationFilterFactory::FilterType types[] = {
+                OrientationFilterFactory::FilterType::COMPLEMENTARY,
+                OrientationFilterFactory::FilterType::MADGWICK,
+                OrientationFilterFactory::FilterType::KALMAN,
+        };
+
+        for (auto type : types) {
+            for (const auto& c : cases) {
+                auto filter = OrientationFilterFactory::createFilter(type);
+                const auto& stream = *c.stream;
+                std::string name = std::string("filter/") + filterName(type) + "/" + c.name;
+
+                report.add(runBenchmark(name, iterations, [&](size_t i) {
+                    size_t idx = i & (STREAM_LENGTH - 1);
+                    filter->update(stream.accel[idx], stream.gyro[idx], c.dt);
+                    doNotOptimize(filter->getOrientation());
+                }));
+            }
+        }
+    }
+
+    void benchValidation(BenchReport& report, size_t iterations) {
+        IMUData valid{0, Vector3d(0.1, 0.2, 9.81), Vector3d(0.01, 0.02, 0.03)};
+        IMUData outOfRange{0, Vector3d(0.0, 0.0, 80.0), Vector3d::Zero()};
+
+        report.add(runBenchmark("validate/valid", iterations, [&](size_t) {
+            bool ok = FusionEngine::validateIMUData(valid);
+            doNotOptimize(ok);
+        }));
+        report.add(runBenchmark("validate/out_of_range", iterations, [&](size_t) {
+            bool ok = FusionEngine::validateIMUData(outOfRange);
+            doNotOptimize(ok);
+        }));
+    }
+
+    void benchProcessor(BenchReport& report, size_t iterations) {
+        const SampleStream steady = figureEightStream(0.01);
+        FusionEngine processor;
+        uint64_t timestamp = 1;
+
+        report.add(runBenchmark("processor/process_imu_data", iterations, [&](size_t i) {
+            size_t idx = i & (STREAM_LENGTH - 1);
+            timestamp += 10000; // 100 Hz in microseconds
+            processor.processIMUData({timestamp, steady.accel[idx], steady.gyro[idx]});
+        }));
+
+        // Same stream handed over 64 samples at a time, reported per sample
+        constexpr size_t BATCH = 64;
+        std::vector<IMUData> batch(BATCH);
+        BenchResult batched = runBenchmark("processor/process_imu_batch", iterations / BATCH, [&](size_t i) {
+            for (size_t j = 0; j < BATCH; ++j) {
+                size_t idx = (i * BATCH + j) & (STREAM_LENGTH - 1);
+                timestamp += 10000;
+                batch[j] = {timestamp, steady.accel[idx], steady.gyro[idx]};
+            }
+            processor.processIMUBatch(batch.data(), batch.size());
+        });
+        batched.nsPerOp /= BATCH;
+        batched.iterations *= BATCH;
+        report.add(batched);
+
+        // Noisy sensor, every sample rejected and only counted
+        report.add(runBenchmark("processor/process_invalid_sample", iterations, [&](size_t) {
+            timestamp += 10000;
+            processor.processIMUData({timestamp, Vector3d(0.0, 0.0, 80.0), Vector3d::Zero()});
+        }));
+
+        // Host stamped bursts, four samples per timestamp, merged by the resampler
+        report.add(runBenchmark("processor/process_imu_data_burst", iterations, [&](size_t i) {
+            size_t idx = i & (STREAM_LENGTH - 1);
+            if ((i & 3) == 0) timestamp += 40000;
+            processor.processIMUData({timestamp, steady.accel[idx], steady.gyro[idx]});
+        }));
+    }
+
+    void benchResampler(BenchReport& report, size_t iterations) {
+        const SampleStream highRate = figureEightStream(0.0001);
+        Resampler resampler;
+        resampler.setOutputRate(200.0); // 10 kHz in, 200 Hz to the filter
+        uint64_t timestamp = 0;
+        ResampledSample out;
+
+        report.add(runBenchmark("resampler/decimate_10khz_to_200hz", iterations, [&](size_t i) {
+            size_t idx = i & (STREAM_LENGTH - 1);
+            timestamp += 100;
+            doNotOptimize(resampler.add(timestamp, highRate.accel[idx], highRate.gyro[idx], out));
+        }));
+    }
+
+    void benchTransform(BenchReport& report, size_t iterations) {
+        CalibrationData calibration;
+        calibration.accelBias = Vector3d(0.1, -0.2, 0.3);
+        calibration.accelScale << 1.01, 0.02, 0.0,
+                                  0.02, 0.99, 0.01,
+                                  0.0, 0.01, 1.02;
+        const AffineTransform transform = SensorTransforms::build(
+                calibration, Vector3d(-1, 1, 1).asDiagonal(), 0.1, 0.1).accel;
+        const SampleStream steady = figureEightStream(0.01);
+
+        report.add(runBenchmark("transform/apply_single", iterations, [&](size_t i) {
+            size_t idx = i & (STREAM_LENGTH - 1);
+            doNotOptimize(transform.apply(steady.accel[idx]));
+        }));
+
+        std::vector<double> x(STREAM_LENGTH), y(STREAM_LENGTH), z(STREAM_LENGTH);
+        for (size_t i = 0; i < STREAM_LENGTH; ++i) {
+            x[i] = steady.accel[i].x();
+            y[i] = steady.accel[i].y();
+            z[i] = steady.accel[i].z();
+        }
+        BenchResult batched = runBenchmark("transform/apply_batch", iterations / STREAM_LENGTH + 1, [&](size_t) {
+            transform.applyBatch(x.data(), y.data(), z.data(), x.data(), y.data(), z.data(), STREAM_LENGTH);
+            doNotOptimize(x[0]);
+        });
+        batched.nsPerOp /= STREAM_LENGTH;
+        batched.iterations *= STREAM_LENGTH;
+        report.add(batched);
+    }
+
+    // Push then release one sequenced sample, about the steady state of the playout pump
+    void benchJitterBuffer(BenchReport& report, size_t iterations) {
+        const SampleStream steady = figureEightStream(0.01);
+        JitterBuffer buffer;
+        int64_t arrival = 1;
+        IMUData out;
+
+        report.add(runBenchmark("jitter_buffer/push_pop", iterations, [&](size_t i) {
+            size_t idx = i & (STREAM_LENGTH - 1);
+            IMUData data{0, steady.accel[idx], steady.gyro[idx]};
+            data.sequence = static_cast<uint32_t>(i);
+            arrival += 10000000; // 100 Hz in ns
+            buffer.push(data, arrival);
+            doNotOptimize(buffer.pop(arrival + 1000000000, out));
+        }));
+    }
+
+    struct IngestRates {
+        double unbufferedNs{0.0};
+        double sampledNs{0.0};
+    };
+
+    /**
+     * Decode throughput of a TCP style byte stream, 16 timed packets per read.
+     * per_packet_unbuffered_devnull stands in for what the transports did before, a synchronous formatted
+     * line per packet to an unbuffered stream like qDebug's stderr. It writes to /dev/null, so it only
+     * measures the formatting and one write() per packet, a real terminal or pipe costs more on top.
+     * sampled_async is what they do now. Returns ns per packet of both, for the summary after the table.
+     */
+    IngestRates benchIngest(BenchReport& report, size_t iterations) {
+        constexpr size_t PACKETS_PER_READ = 16;
+        const SampleStream steady = figureEightStream(0.01);
+
+        std::vector<char> stream;
+        for (size_t i = 0; i < STREAM_LENGTH; ++i) {
+            const uint32_t sequence = static_cast<uint32_t>(i);
+            const uint32_t deviceTime = sequence * 10000;
+            float values[6];
+            for (int axis = 0; axis < 3; ++axis) {
+                values[axis] = static_cast<float>(steady.accel[i][axis]);
+                values[axis + 3] = static_cast<float>(steady.gyro[i][axis]);
+            }
+            stream.push_back(static_cast<char>(PacketDecoder::PACKET_START_TIMED));
+            stream.insert(stream.end(), reinterpret_cast<const char*>(&sequence), reinterpret_cast<const char*>(&sequence) + 4);
+            stream.insert(stream.end(), reinterpret_cast<const char*>(&deviceTime), reinterpret_cast<const char*>(&deviceTime) + 4);
+            stream.insert(stream.end(), reinterpret_cast<const char*>(values), reinterpret_cast<const char*>(values) + 24);
+            stream.push_back(static_cast<char>(PacketDecoder::PACKET_END));
+        }
+        constexpr size_t READ_SIZE = PACKETS_PER_READ * PacketDecoder::TIMED_PACKET_SIZE;
+        constexpr size_t READS = STREAM_LENGTH / PACKETS_PER_READ;
+
+#ifdef _WIN32
+        std::FILE* console = std::fopen("NUL", "w");
+#else
+        std::FILE* console = std::fopen("/dev/null", "w");
+#endif
+        if (!console) return {};
+        std::setvbuf(console, nullptr, _IONBF, 0);
+
+        // The sampled lines still go through the sink thread, just not to the terminal
+        Logger::setSink([](LogLevel, const std::string&) {});
+
+        auto run = [&](const char* name, auto&& onPacket) {
+            TransportCounters counters;
+            PacketDecoder decoder(counters);
+            BenchResult result = runBenchmark(name, iterations / PACKETS_PER_READ, [&](size_t i) {
+                const char* read = stream.data() + (i % READS) * READ_SIZE;
+                decoder.feed(read, READ_SIZE, steadyNowNs(), onPacket);
+            });
+            result.nsPerOp /= PACKETS_PER_READ;
+            result.iterations *= PACKETS_PER_READ;
+            report.add(result);
+            return result.nsPerOp;
+        };
+
+        const double unbufferedNs = run("ingest/per_packet_unbuffered_devnull", [&](const IMUData& data) {
+            std::fprintf(console, "Received IMU data: Accel: %g %g %g Gyro: %g %g %g\n",
+                         data.acceleration.x(), data.acceleration.y(), data.acceleration.z(),
+                         data.gyroscope.x(), data.gyroscope.y(), data.gyroscope.z());
+        });
+        const double sampledNs = run("ingest/sampled_async", [](const IMUData& data) {
+            doNotOptimize(data.decodeTimeNs);
+        });
+
+        Logger::flush();
+        Logger::setSink(nullptr);
+        std::fclose(console);
+        return {unbufferedNs, sampledNs};
+    }
+
+    // Whole calibration run, reported per sample so the sizes are comparable
+    void benchCalibration(BenchReport& report, size_t samples) {
+        const SampleStream still = nearZeroRotationStream();
+        FusionEngine processor;
+
+        BenchResult result = runBenchmark("calibration/" + std::to_string(samples) + "_samples", 1, [&](size_t) {
+            processor.startCalibration();
+            for (size_t i = 0; i < samples; ++i) {
+                size_t idx = i & (STREAM_LENGTH - 1);
+                processor.updateCalibration({i, still.accel[idx], still.gyro[idx]});
+            }
+            processor.finishCalibration();
+        }, samples >= 10000000 ? 1 : 3);
+
+        result.nsPerOp /= static_cast<double>(samples);
+        result.iterations = samples;
+        report.add(result);
+    }
+
+    // Per sample cost of the multi-pose accumulator and the final ellipsoid solve
+    void benchEllipsoidCalibration(BenchReport& report, size_t iterations) {
+        const SampleStream still = nearZeroRotationStream();
+        EllipsoidCalibrator calibrator;
+        report.add(runBenchmark("calibration/multi_pose_add_sample", iterations, [&](size_t i) {
+            size_t idx = i & (STREAM_LENGTH - 1);
+            doNotOptimize(calibrator.addSample(still.accel[idx], still.gyro[idx]));
+        }));
+
+        // Twelve distinct poses so the full 3x3 fit runs
+        calibrator.reset();
+        for (int pose = 0; pose < 12; ++pose) {
+            Eigen::AngleAxisd tilt(pose * 0.5, Vector3d(std::sin(pose), std::cos(pose), 0.3 * pose).normalized());
+            Vector3d accel = tilt.toRotationMatrix() * Vector3d(0, 0, 9.81);
+            for (int i = 0; i < 300; ++i) calibrator.addSample(accel, Vector3d::Zero());
+            for (int i = 0; i < 5; ++i) calibrator.addSample(Vector3d(3, 3, 3), Vector3d(2, 2, 2));
+        }
+        report.add(runBenchmark("calibration/multi_pose_solve", iterations / 10, [&](size_t) {
+            CalibrationData out;
+            doNotOptimize(calibrator.solve(out).success);
+        }));
+    }
+
+    // Signal plot history: per sample append, and one plot's worth of columns over spans from a second
+    // to the whole hour. The query should cost the same whatever the span
+    void benchPlotHistory(BenchReport& report, size_t iterations) {
+        constexpr int64_t SAMPLE_INTERVAL_NS = 1000000; // 1 kHz
+        constexpr size_t HOUR = 3600 * 1000;
+        constexpr size_t COLUMNS = 1920;
+        const SampleStream stream = figureEightStream(0.001);
+        auto pyramid = std::make_unique<MinMaxPyramid<6>>();
+
+        auto values = [&](size_t i) {
+            const size_t idx = i & (STREAM_LENGTH - 1);
+            return MinMaxPyramid<6>::Values{
+                    static_cast<float>(stream.accel[idx].x()), static_cast<float>(stream.accel[idx].y()),
+                    static_cast<float>(stream.accel[idx].z()), static_cast<float>(stream.gyro[idx].x()),
+                    static_cast<float>(stream.gyro[idx].y()), static_cast<float>(stream.gyro[idx].z())};
+        };
+
+        report.add(runBenchmark("plot_history/append", iterations, [&](size_t i) {
+            pyramid->append(static_cast<int64_t>(i) * SAMPLE_INTERVAL_NS, values(i));
+        }));
+
+        pyramid->clear();
+        for (size_t i = 0; i < HOUR; ++i) {
+            pyramid->append(static_cast<int64_t>(i) * SAMPLE_INTERVAL_NS, values(i));
+        }
+
+        std::vector<MinMaxPyramid<6>::Column> columns(COLUMNS);
+        const int64_t newestNs = static_cast<int64_t>(HOUR) * SAMPLE_INTERVAL_NS;
+        for (int seconds : {1, 60, 3600}) {
+            const int64_t fromNs = newestNs - int64_t{seconds} * 1000000000;
+            report.add(runBenchmark("plot_history/query_" + std::to_string(seconds) + "s_of_1h",
+                                    iterations / 100, [&](size_t) {
+                doNotOptimize(pyramid->query(fromNs, newestNs, columns.data(), COLUMNS));
+            }));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = BenchOptions::parse(argc, argv);
+    const size_t iterations = options.quick ? 20000 : 200000;
+
+    std::printf("%-48s %20s %18s\n", "benchmark", "time", "iterations");
+
+    BenchReport report;
+    benchFilters(report, iterations);
+    benchValidation(report, iterations);
+    benchProcessor(report, iterations);
+    benchTransform(report, iterations);
+    benchResampler(report, iterations);
+    benchJitterBuffer(report, iterations);
+    const IngestRates ingest = benchIngest(report, iterations);
+    benchPlotHistory(report, iterations);
+
+    benchEllipsoidCalibration(report, iterations);
+
+    benchCalibration(report, 1000);
+    benchCalibration(report, 100000);
+    if (!options.quick) {
+        benchCalibration(report, 10000000);
+    }
+
+    if (ingest.unbufferedNs > 0.0) {
+        std::printf("\ningest: %.0f packets/s with an unbuffered line per packet to /dev/null, %.0f packets/s sampled (%.1fx)\n",
+                    1e9 / ingest.unbufferedNs, 1e9 / ingest.sampledNs, ingest.unbufferedNs / ingest.sampledNs);
+    }
+
+    return options.finish(report);
+}
@@ -0,0 +1,170 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+// Frame time for N bodies drawn offscreen, instanced vs one draw call per body.
+// Without a GPU run it on Mesa's software rasteriser under a virtual display:
+//   LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe xvfb-run -a ./render_benchmark
+
+#include "bench_utils.h"
+#include "visualization/body_renderer.h"
+#include "visualization/cube_mesh.h"
+#include "visualization/shaders.h"
+
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <cstdio>
+#include <vector>
+
+using namespace imu_viz;
+using namespace imu_viz::bench;
+
+namespace {
+    constexpr int FRAME_WIDTH = 1280;
+    constexpr int FRAME_HEIGHT = 720;
+
+    struct Scene {
+        QMatrix4x4 projection;
+        QMatrix4x4 view;
+        QVector3D cameraPosition{0.0f, 3.0f, 5.0f};
+        QVector3D lightPos{5.0f, 0.0f, 5.0f};
+        std::vector<BodyInstance> bodies;
+
+        // Every body turns a little each frame so nothing can be cached between frames
+        void advance(size_t frame) {
+            for (size_t i = 0; i < bodies.size(); ++i) {
+                const double angle = 0.01 * static_cast<double>(frame) + 0.1 * static_cast<double>(i);
+                bodies[i].setRotation(Quaterniond(Eigen::AngleAxisd(angle, Vector3d(0.3, 1.0, 0.2).normalized())));
+            }
+        }
+    };
+
+    // What GLWidget does where instancing is unavailable
+    void drawPerBody(QOpenGLFunctions* gl, QOpenGLShaderProgram& program, QOpenGLVertexArrayObject& vao,
+                     const Scene& scene) {
+        program.bind();
+        program.setUniformValue("projection", scene.projection);
+        program.setUniformValue("view", scene.view);
+        program.setUniformValue("viewPos", scene.cameraPosition);
+        program.setUniformValue("lightPos", scene.lightPos);
+        vao.bind();
+        for (const auto& body : scene.bodies) {
+            QMatrix4x4 model;
+            model.translate(body.offset[0], body.offset[1], body.offset[2]);
+            model.rotate(QQuaternion(body.rotation[3], body.rotation[0], body.rotation[1], body.rotation[2]));
+            model.scale(body.scale);
+            program.setUniformValue("model", model);
+            program.setUniformValue("normalMatrix", model.normalMatrix());
+            gl->glDrawArrays(GL_TRIANGLES, 0, CUBE_VERTEX_COUNT);
+        }
+        vao.release();
+        program.release();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = BenchOptions::parse(argc, argv);
+    const size_t frames = options.quick ? 20 : 100;
+
+    QGuiApplication app(argc, argv);
+
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setDepthBufferSize(24);
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::fprintf(stderr, "render_benchmark: no OpenGL 3.3 context\n");
+        return 1;
+    }
+
+    QOpenGLFunctions* gl = context.functions();
+    std::printf("Renderer: %s, %s\n", reinterpret_cast<const char*>(gl->glGetString(GL_RENDERER)),
+                reinterpret_cast<const char*>(gl->glGetString(GL_VERSION)));
+
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+    QOpenGLFramebufferObject fbo(FRAME_WIDTH, FRAME_HEIGHT, fboFormat);
+    fbo.bind();
+    gl->glViewport(0, 0, FRAME_WIDTH, FRAME_HEIGHT);
+    gl->glEnable(GL_DEPTH_TEST);
+    gl->glEnable(GL_CULL_FACE);
+    gl->glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+
+    QOpenGLBuffer mesh(QOpenGLBuffer::VertexBuffer);
+    mesh.create();
+    mesh.bind();
+    mesh.allocate(CUBE_VERTICES, sizeof(CUBE_VERTICES));
+    mesh.release();
+
+    BodyRenderer instanced;
+    if (!instanced.initialize(mesh, CUBE_VERTEX_COUNT)) {
+        std::fprintf(stderr, "render_benchmark: instanced renderer unavailable\n");
+        return 1;
+    }
+
+    QOpenGLShaderProgram perBodyProgram;
+    perBodyProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, shaders::BODY_VERTEX_330);
+    perBodyProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, shaders::BODY_FRAGMENT_330);
+    if (!perBodyProgram.link()) {
+        std::fprintf(stderr, "render_benchmark: %s\n", perBodyProgram.log().toStdString().c_str());
+        return 1;
+    }
+    QOpenGLVertexArrayObject perBodyVao;
+    perBodyVao.create();
+    perBodyVao.bind();
+    mesh.bind();
+    perBodyProgram.enableAttributeArray(0);
+    perBodyProgram.setAttributeBuffer(0, GL_FLOAT, 0, 3, CUBE_VERTEX_STRIDE);
+    perBodyProgram.enableAttributeArray(1);
+    perBodyProgram.setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(float), 3, CUBE_VERTEX_STRIDE);
+    perBodyProgram.enableAttributeArray(2);
+    perBodyProgram.setAttributeBuffer(2, GL_FLOAT, 6 * sizeof(float), 3, CUBE_VERTEX_STRIDE);
+    perBodyVao.release();
+    mesh.release();
+
+    Scene scene;
+    scene.projection.perspective(45.0f, float(FRAME_WIDTH) / FRAME_HEIGHT, 0.1f, 100.0f);
+    scene.view.lookAt(scene.cameraPosition, QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f));
+
+    std::printf("%-48s %20s %18s\n", "benchmark", "time", "iterations");
+    BenchReport report;
+
+    // glFinish per frame, so the time includes rasterisation and not just command submission
+    for (size_t count : {size_t{1}, size_t{100}, size_t{1000}}) {
+        scene.bodies.assign(count, BodyInstance{});
+        BodyRenderer::layoutGrid(scene.bodies.data(), count);
+        const std::string suffix = std::to_string(count) + "_bodies";
+
+        report.add(runBenchmark("render/instanced/" + suffix, frames, [&](size_t frame) {
+            scene.advance(frame);
+            gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            instanced.draw(scene.bodies.data(), scene.bodies.size(), scene.projection, scene.view,
+                           scene.cameraPosition, scene.lightPos);
+            gl->glFinish();
+        }, 3));
+
+        report.add(runBenchmark("render/per_body/" + suffix, frames, [&](size_t frame) {
+            scene.advance(frame);
+            gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            drawPerBody(gl, perBodyProgram, perBodyVao, scene);
+            gl->glFinish();
+        }, 3));
+    }
+
+    instanced.destroy();
+    perBodyVao.destroy();
+    mesh.destroy();
+    fbo.release();
+    context.doneCurrent();
+
+    return options.finish(report);
+}
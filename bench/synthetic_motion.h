@@ -0,0 +1,157 @@
+//
+// Created by Raphael Russo on 12/03/24.
+//
+
+#ifndef IMU_VISUALIZER_SYNTHETIC_MOTION_H
+#define IMU_VISUALIZER_SYNTHETIC_MOTION_H
+#pragma once
+
+#include "imu_visualizer/common.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace imu_viz::bench {
+
+    /**
+     * Ground truth convention used throughout the harness:
+     *  - orientation rotates body frame into world frame, world z is up
+     *  - gyro is the body frame angular rate in rad/s (q_dot = 0.5 * q * w)
+     *  - accel is the body frame specific force in m/s^2, so a device at rest reads +9.81 on the axis pointing up
+     */
+    enum class Scenario {
+        STATIC,
+        CONSTANT_RATE,
+        FIGURE_EIGHT,
+        SHAKING
+    };
+
+    inline const char* scenarioName(Scenario scenario) {
+        switch (scenario) {
+            case Scenario::STATIC: return "static";
+            case Scenario::CONSTANT_RATE: return "constant_rate";
+            case Scenario::FIGURE_EIGHT: return "figure_eight";
+            case Scenario::SHAKING: return "shaking";
+        }
+        return "unknown";
+    }
+
+    struct NoiseModel {
+        double accelNoise{0.05};  // m/s^2, white noise std dev
+        double gyroNoise{0.005};  // rad/s, white noise std dev
+        double gyroBias{0.0};     // rad/s, constant on every axis
+
+        NoiseModel scaled(double factor) const {
+            return {accelNoise * factor, gyroNoise * factor, gyroBias * factor};
+        }
+    };
+
+    struct SyntheticSample {
+        double time;
+        double dt;
+        Vector3d accel;
+        Vector3d gyro;
+        Quaterniond truth;
+    };
+
+    class SyntheticMotion {
+    public:
+        static constexpr double GRAVITY = 9.81;
+
+        SyntheticMotion(Scenario scenario, double rateHz, const NoiseModel& noise, unsigned seed = 42)
+                : scenario(scenario), rateHz(rateHz), noise(noise), rng(seed) {}
+
+        std::vector<SyntheticSample> generate(double durationSeconds) {
+            const size_t count = static_cast<size_t>(durationSeconds * rateHz);
+            const double dt = 1.0 / rateHz;
+            std::normal_distribution<double> unit(0.0, 1.0);
+
+            std::vector<SyntheticSample> samples;
+            samples.reserve(count);
+
+            Quaterniond q = initialOrientation();
+            double t = 0.0;
+            for (size_t k = 0; k < count; ++k) {
+                if (k > 0) {
+                    q = integrate(q, t - dt, dt);
+                }
+
+                Vector3d gyroNoise(unit(rng), unit(rng), unit(rng));
+                Vector3d accelNoise(unit(rng), unit(rng), unit(rng));
+
+                SyntheticSample s;
+                s.time = t;
+                s.dt = k > 0 ? dt : 0.0;
+                s.truth = q;
+                s.gyro = angularVelocity(t) + gyroNoise * noise.gyroNoise
+                         + Vector3d::Constant(noise.gyroBias);
+                s.accel = q.conjugate() * (linearAcceleration(t) + Vector3d(0, 0, GRAVITY))
+                          + accelNoise * noise.accelNoise;
+                samples.push_back(s);
+
+                t += dt;
+            }
+            return samples;
+        }
+
+    private:
+        Scenario scenario;
+        double rateHz;
+        NoiseModel noise;
+        std::mt19937 rng;
+
+        Quaterniond initialOrientation() const {
+            switch (scenario) {
+                case Scenario::STATIC:
+                    // Tilted so the static case exercises more than the identity
+                    return Quaterniond(Eigen::AngleAxisd(0.35, Vector3d(1, 0.5, 0).normalized()));
+                default:
+                    return Quaterniond::Identity();
+            }
+        }
+
+        // Body frame angular velocity in rad/s
+        Vector3d angularVelocity(double t) const {
+            switch (scenario) {
+                case Scenario::STATIC:
+                    return Vector3d::Zero();
+                case Scenario::CONSTANT_RATE:
+                    return Vector3d(0.2, 0.1, 0.5);
+                case Scenario::FIGURE_EIGHT:
+                    // Same gyro profile MockTransport uses
+                    return Vector3d(std::sin(t * 0.5) * 0.3, std::cos(t * 0.5) * 0.3, 1.0);
+                case Scenario::SHAKING:
+                    return Vector3d(3.0 * std::sin(2 * M_PI * 5.0 * t),
+                                    2.0 * std::sin(2 * M_PI * 7.0 * t + 1.0),
+                                    1.0 * std::sin(2 * M_PI * 3.0 * t));
+            }
+            return Vector3d::Zero();
+        }
+
+        // World frame linear acceleration in m/s^2 (excluding gravity)
+        Vector3d linearAcceleration(double t) const {
+            if (scenario == Scenario::SHAKING) {
+                return Vector3d(5.0 * std::sin(2 * M_PI * 8.0 * t),
+                                4.0 * std::sin(2 * M_PI * 6.0 * t + 0.5),
+                                3.0 * std::sin(2 * M_PI * 9.0 * t + 1.5));
+            }
+            return Vector3d::Zero();
+        }
+
+        // Integrates the true rate between samples with sub steps so truth doesn't depend on sample rate
+        Quaterniond integrate(Quaterniond q, double t0, double dt) const {
+            constexpr int SUB_STEPS = 16;
+            const double h = dt / SUB_STEPS;
+            for (int i = 0; i < SUB_STEPS; ++i) {
+                Vector3d w = angularVelocity(t0 + (i + 0.5) * h) * h;
+                double angle = w.norm();
+                if (angle > 0.0) {
+                    q = q * Quaterniond(Eigen::AngleAxisd(angle, w / angle));
+                }
+            }
+            return q.normalized();
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_SYNTHETIC_MOTION_H
@@ -0,0 +1,20 @@
+//
+// Created by Raphael Russo on 12/10/24.
+//
+
+#ifndef IMU_VISUALIZER_CLOCK_H
+#define IMU_VISUALIZER_CLOCK_H
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace imu_viz {
+    // Monotonic host time in ns, the one clock processing and rendering compare against
+    inline int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+#endif //IMU_VISUALIZER_CLOCK_H
@@ -7,12 +7,34 @@
 #pragma once
 
 #include "imu_visualizer/common.h"
+#include <cstdint>
+#include <string>
 
 namespace imu_viz {
     struct IMUData {
+        static constexpr uint32_t NO_SEQUENCE = 0xFFFFFFFFu;
+
         uint64_t timestamp;
         Vector3d acceleration;
         Vector3d gyroscope;
+
+        // Only set when the transport's protocol carries them
+        uint64_t deviceTimestamp{0};     // us on the device clock, 0 if unknown
+        uint32_t sequence{NO_SEQUENCE};  // Packet counter, wraps
+        int64_t arrivalTimeNs{0};        // steadyNowNs() when the transport read the bytes, 0 if unknown
+        int64_t decodeTimeNs{0};         // steadyNowNs() once the packet was decoded, 0 if unknown
+    };
+
+    // Published once per processed sample, enough for the renderer to extrapolate to display time
+    struct OrientationSample {
+        Quaterniond orientation{Quaterniond::Identity()};
+        Vector3d angularVelocity{Vector3d::Zero()}; // Body frame rad/s, the calibrated rate the filter saw
+        uint64_t timestamp{0};                      // Sensor timestamp, us
+        int64_t publishTimeNs{0};                   // Steady clock when the processor emitted it
+        int64_t arrivalTimeNs{0};                   // Newest input sample's transport stamps, 0 if unknown
+        int64_t decodeTimeNs{0};
+        double smoothingLatencyMs{0.0};             // Lag the output smoother added to orientation
+        bool concealed{false};                      // Extrapolated through a gap, not measured
     };
 
     struct CalibrationData {
@@ -24,9 +46,13 @@ namespace imu_viz {
         Eigen::Vector3d gyroBias{0, 0, 0};
         Eigen::Matrix3d gyroScale{Eigen::Matrix3d::Identity()};
 
-        // Save/load calibration, not used currently but could be useful
+        // Fixed size binary profile with a version and CRC, see imu_data.cpp for the layout
         bool saveToFile(const std::string& filename) const;
         bool loadFromFile(const std::string& filename);
+
+        // Human readable copy of the same values, never read back
+        bool exportToText(const std::string& filename, const std::string& sensorId = "") const;
     };
 }
+
 #endif //IMU_VISUALIZER_IMU_DATA_H
@@ -0,0 +1,128 @@
+//
+// Created by Raphael Russo on 12/18/24.
+//
+
+#ifndef IMU_VISUALIZER_LATENCY_HISTOGRAM_H
+#define IMU_VISUALIZER_LATENCY_HISTOGRAM_H
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace imu_viz {
+
+    /**
+     * HDR style latency histogram in ns: exact below 32 ns, then 32 log-linear buckets per power of two
+     * (~3% resolution) up to 2^40 ns. record() is a handful of relaxed atomic ops, any thread may call it,
+     * nothing allocates. Percentiles report the top of their bucket, so they never understate.
+     */
+    class LatencyHistogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 5;
+        static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+        static constexpr int MAX_MAGNITUDE = 40; // Larger values land in the last bucket, max is still exact
+        static constexpr size_t BUCKET_COUNT = static_cast<size_t>(MAX_MAGNITUDE - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+        struct Snapshot {
+            uint64_t count{0};
+            double meanNs{0.0};
+            int64_t maxNs{0};
+            std::array<uint64_t, BUCKET_COUNT> buckets{};
+
+            // p in [0, 100]
+            int64_t percentileNs(double p) const {
+                if (count == 0) return 0;
+                const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * count)));
+                uint64_t seen = 0;
+                for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                    seen += buckets[i];
+                    if (seen >= target) {
+                        return std::min(static_cast<int64_t>(highestEquivalent(i)), maxNs);
+                    }
+                }
+                return maxNs;
+            }
+        };
+
+        void record(int64_t valueNs) {
+            // Stamps from two threads can be a hair out of order, count those as zero
+            const uint64_t value = valueNs > 0 ? static_cast<uint64_t>(valueNs) : 0;
+            buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            sumNs.fetch_add(value, std::memory_order_relaxed);
+
+            uint64_t current = maxNs.load(std::memory_order_relaxed);
+            while (value > current &&
+                   !maxNs.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+
+        // Consistent enough for display while recording continues, exact once it stops
+        Snapshot snapshot() const {
+            Snapshot snapshot;
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+                snapshot.count += snapshot.buckets[i];
+            }
+            if (snapshot.count > 0) {
+                snapshot.meanNs = static_cast<double>(sumNs.load(std::memory_order_relaxed)) / snapshot.count;
+            }
+            snapshot.maxNs = static_cast<int64_t>(maxNs.load(std::memory_order_relaxed));
+            return snapshot;
+        }
+
+        uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+
+        void reset() {
+            for (auto& bucket : buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count.store(0, std::memory_order_relaxed);
+            sumNs.store(0, std::memory_order_relaxed);
+            maxNs.store(0, std::memory_order_relaxed);
+        }
+
+        static size_t bucketIndex(uint64_t value) {
+            if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+
+            const int magnitude = highestBit(value);
+            if (magnitude >= MAX_MAGNITUDE) return BUCKET_COUNT - 1;
+
+            const int shift = magnitude - SUB_BUCKET_BITS;
+            return (static_cast<size_t>(shift + 1) << SUB_BUCKET_BITS) + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+        }
+
+        static uint64_t lowestEquivalent(size_t index) {
+            if (index < SUB_BUCKETS) return index;
+            const int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+            return ((index & (SUB_BUCKETS - 1)) + SUB_BUCKETS) << shift;
+        }
+
+        static uint64_t highestEquivalent(size_t index) {
+            if (index < SUB_BUCKETS) return index;
+            const int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+            return lowestEquivalent(index) + (uint64_t{1} << shift) - 1;
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sumNs{0};
+        std::atomic<uint64_t> maxNs{0};
+
+        static int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(value);
+#else
+            int bit = 0;
+            while (value >>= 1) ++bit;
+            return bit;
+#endif
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_LATENCY_HISTOGRAM_H
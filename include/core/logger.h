@@ -0,0 +1,395 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_LOGGER_H
+#define IMU_VISUALIZER_LOGGER_H
+#pragma once
+
+// Asynchronous logging, formatting and console I/O happen on a background sink thread.
+//
+//   IMU_LOG_DEBUG("Rotation speed set to: {}", speed);
+//   IMU_LOG_EVERY_N(DEBUG, 100, "Received IMU data: {} {} {}", x, y, z);  // 1st, 101st, ...
+//   IMU_LOG_RATE_LIMITED(WARN, 1000, "OpenGL error: {}", err);             // At most once a second
+//
+// Levels below IMU_VIZ_LOG_LEVEL (-DIMU_VIZ_LOG_LEVEL=TRACE..OFF in CMake) are compiled out, arguments
+// included. The call site stores the format pointer and the raw arguments into its thread's ring,
+// so the format string must be a literal. Strings are copied, anything past TEXT_CAPACITY is cut.
+// A full ring drops the record and the sink reports how many were lost.
+
+#include "core/clock.h"
+#include "core/spsc_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#define IMU_VIZ_LOG_LEVEL_TRACE 0
+#define IMU_VIZ_LOG_LEVEL_DEBUG 1
+#define IMU_VIZ_LOG_LEVEL_INFO 2
+#define IMU_VIZ_LOG_LEVEL_WARN 3
+#define IMU_VIZ_LOG_LEVEL_ERROR 4
+#define IMU_VIZ_LOG_LEVEL_OFF 5
+
+#ifndef IMU_VIZ_LOG_LEVEL
+#define IMU_VIZ_LOG_LEVEL IMU_VIZ_LOG_LEVEL_DEBUG
+#endif
+
+#define IMU_LOG_ENABLED(level) (IMU_VIZ_LOG_LEVEL <= IMU_VIZ_LOG_LEVEL_##level)
+
+#define IMU_LOG(level, ...) \
+    do { \
+        if constexpr (IMU_LOG_ENABLED(level)) { \
+            ::imu_viz::Logger::log(::imu_viz::LogLevel::level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+// Counts per thread, so each thread logs its own 1st, (n+1)th, ... call
+#define IMU_LOG_EVERY_N(level, n, ...) \
+    do { \
+        if constexpr (IMU_LOG_ENABLED(level)) { \
+            static thread_local uint64_t imuLogCount = 0; \
+            if (imuLogCount++ % (n) == 0) { \
+                ::imu_viz::Logger::log(::imu_viz::LogLevel::level, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define IMU_LOG_RATE_LIMITED(level, intervalMs, ...) \
+    do { \
+        if constexpr (IMU_LOG_ENABLED(level)) { \
+            static thread_local int64_t imuLogNextNs = 0; \
+            const int64_t imuLogNowNs = ::imu_viz::steadyNowNs(); \
+            if (imuLogNowNs >= imuLogNextNs) { \
+                imuLogNextNs = imuLogNowNs + int64_t{intervalMs} * 1000000; \
+                ::imu_viz::Logger::log(::imu_viz::LogLevel::level, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define IMU_LOG_TRACE(...) IMU_LOG(TRACE, __VA_ARGS__)
+#define IMU_LOG_DEBUG(...) IMU_LOG(DEBUG, __VA_ARGS__)
+#define IMU_LOG_INFO(...) IMU_LOG(INFO, __VA_ARGS__)
+#define IMU_LOG_WARN(...) IMU_LOG(WARN, __VA_ARGS__)
+#define IMU_LOG_ERROR(...) IMU_LOG(ERROR, __VA_ARGS__)
+
+namespace imu_viz {
+
+    enum class LogLevel : uint8_t {
+        TRACE = IMU_VIZ_LOG_LEVEL_TRACE,
+        DEBUG = IMU_VIZ_LOG_LEVEL_DEBUG,
+        INFO = IMU_VIZ_LOG_LEVEL_INFO,
+        WARN = IMU_VIZ_LOG_LEVEL_WARN,
+        ERROR = IMU_VIZ_LOG_LEVEL_ERROR,
+        OFF = IMU_VIZ_LOG_LEVEL_OFF
+    };
+
+    // Formats as 0x.. instead of decimal
+    struct LogHex {
+        uint64_t value;
+    };
+
+    class Logger {
+    public:
+        static constexpr size_t MAX_ARGS = 8;
+        static constexpr size_t TEXT_CAPACITY = 384;                 // String bytes per record
+        static constexpr size_t RECORDS_PER_THREAD = 512;            // Ring size, power of two
+        static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(10);
+
+        // Receives each formatted line without the trailing newline
+        using Sink = std::function<void(LogLevel, const std::string&)>;
+
+        template <typename... Args>
+        static void log(LogLevel level, const char* format, const Args&... args) {
+            static_assert(sizeof...(Args) <= MAX_ARGS, "Too many log arguments");
+            if (level < state().minimumLevel.load(std::memory_order_relaxed)) return;
+
+            ThreadQueue& queue = threadQueue();
+            Record record;
+            record.timeNs = steadyNowNs();
+            record.format = format;
+            record.level = level;
+            (capture(record, args), ...);
+
+            if (!queue.records.tryPush(record)) {
+                queue.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Runtime filter on top of the compiled level
+        static void setLevel(LogLevel level) { state().minimumLevel.store(level, std::memory_order_relaxed); }
+        static LogLevel getLevel() { return state().minimumLevel.load(std::memory_order_relaxed); }
+
+        // Null restores stderr
+        static void setSink(Sink sink) {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.sinkMutex);
+            s.sink = std::move(sink);
+        }
+
+        // Writes everything queued so far before returning
+        static void flush() {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.sinkMutex);
+            drain(s);
+        }
+
+        static uint64_t getDropped() {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.registryMutex);
+            uint64_t total = 0;
+            for (const auto& queue : s.queues) {
+                total += queue->dropped.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        static const char* levelName(LogLevel level) {
+            switch (level) {
+                case LogLevel::TRACE: return "TRACE";
+                case LogLevel::DEBUG: return "DEBUG";
+                case LogLevel::INFO: return "INFO";
+                case LogLevel::WARN: return "WARN";
+                case LogLevel::ERROR: return "ERROR";
+                case LogLevel::OFF: return "OFF";
+            }
+            return "?";
+        }
+
+    private:
+        struct Arg {
+            enum class Type : uint8_t { INT, UINT, DOUBLE, BOOL, HEX, TEXT };
+            Type type{Type::INT};
+            uint16_t textOffset{0};
+            uint16_t textLength{0};
+            union {
+                int64_t i;
+                uint64_t u;
+                double d;
+            } value{};
+        };
+
+        struct Record {
+            int64_t timeNs{0};
+            const char* format{nullptr};
+            LogLevel level{LogLevel::INFO};
+            uint8_t argCount{0};
+            uint16_t textUsed{0};
+            Arg args[MAX_ARGS];
+            char text[TEXT_CAPACITY];
+        };
+
+        struct ThreadQueue {
+            SpscQueue<Record, RECORDS_PER_THREAD> records;
+            std::atomic<uint64_t> dropped{0};
+            uint64_t droppedReported{0}; // Sink side
+            uint32_t threadId{0};
+            bool active{false};          // Guarded by the registry mutex
+        };
+
+        struct State {
+            std::atomic<LogLevel> minimumLevel{LogLevel::TRACE};
+            int64_t epochNs{steadyNowNs()};
+
+            std::mutex registryMutex;
+            std::vector<std::unique_ptr<ThreadQueue>> queues;
+            uint32_t nextThreadId{1};
+
+            std::mutex sinkMutex; // Held while draining, so there is only ever one consumer
+            std::condition_variable wake;
+            bool stopping{false};
+            Sink sink;
+            Record record; // Scratch for the sink, too big for its stack
+            std::string line;
+            std::thread thread;
+
+            State() {
+                thread = std::thread([this]() {
+                    std::unique_lock<std::mutex> lock(sinkMutex);
+                    while (!stopping) {
+                        // Producers never notify, keeping the call site free of syscalls
+                        wake.wait_for(lock, FLUSH_INTERVAL);
+                        drain(*this);
+                    }
+                    drain(*this);
+                });
+            }
+
+            ~State() {
+                {
+                    std::lock_guard<std::mutex> lock(sinkMutex);
+                    stopping = true;
+                }
+                wake.notify_one();
+                thread.join();
+            }
+        };
+
+        static State& state() {
+            static State instance;
+            return instance;
+        }
+
+        // Claims a ring on a thread's first log call and frees it for reuse when the thread exits,
+        // the sink still drains whatever it left behind
+        struct Registration {
+            ThreadQueue* queue{nullptr};
+
+            Registration() {
+                State& s = state();
+                std::lock_guard<std::mutex> lock(s.registryMutex);
+                for (auto& candidate : s.queues) {
+                    if (!candidate->active) {
+                        queue = candidate.get();
+                        break;
+                    }
+                }
+                if (!queue) {
+                    s.queues.push_back(std::make_unique<ThreadQueue>());
+                    queue = s.queues.back().get();
+                }
+                queue->active = true;
+                queue->threadId = s.nextThreadId++;
+            }
+
+            ~Registration() {
+                std::lock_guard<std::mutex> lock(state().registryMutex);
+                queue->active = false;
+            }
+        };
+
+        static ThreadQueue& threadQueue() {
+            thread_local Registration registration;
+            return *registration.queue;
+        }
+
+        template <typename T>
+        static void capture(Record& record, const T& value) {
+            using U = std::decay_t<T>;
+            Arg& arg = record.args[record.argCount++];
+            if constexpr (std::is_same_v<U, bool>) {
+                arg.type = Arg::Type::BOOL;
+                arg.value.u = value ? 1 : 0;
+            } else if constexpr (std::is_same_v<U, LogHex>) {
+                arg.type = Arg::Type::HEX;
+                arg.value.u = value.value;
+            } else if constexpr (std::is_enum_v<U>) {
+                arg.type = Arg::Type::INT;
+                arg.value.i = static_cast<int64_t>(value);
+            } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+                arg.type = Arg::Type::INT;
+                arg.value.i = value;
+            } else if constexpr (std::is_integral_v<U>) {
+                arg.type = Arg::Type::UINT;
+                arg.value.u = value;
+            } else if constexpr (std::is_floating_point_v<U>) {
+                arg.type = Arg::Type::DOUBLE;
+                arg.value.d = value;
+            } else if constexpr (std::is_pointer_v<T> && std::is_convertible_v<T, std::string_view>) {
+                captureText(record, arg, value ? std::string_view(value) : std::string_view("(null)"));
+            } else {
+                static_assert(std::is_convertible_v<const U&, std::string_view>,
+                              "Log arguments must be numbers, bools, LogHex or strings");
+                captureText(record, arg, std::string_view(value));
+            }
+        }
+
+        static void captureText(Record& record, Arg& arg, std::string_view text) {
+            const size_t length = std::min(text.size(), TEXT_CAPACITY - record.textUsed);
+            std::memcpy(record.text + record.textUsed, text.data(), length);
+            arg.type = Arg::Type::TEXT;
+            arg.textOffset = record.textUsed;
+            arg.textLength = static_cast<uint16_t>(length);
+            record.textUsed = static_cast<uint16_t>(record.textUsed + length);
+        }
+
+        // Replaces each {} in the format with the next argument
+        static void format(const State& s, const ThreadQueue& queue, const Record& record, std::string& out) {
+            char number[48];
+            const double seconds = static_cast<double>(record.timeNs - s.epochNs) * 1e-9;
+            std::snprintf(number, sizeof(number), "%12.6f %-5s [%u] ", seconds,
+                          levelName(record.level), queue.threadId);
+            out.assign(number);
+
+            size_t next = 0;
+            for (const char* c = record.format; *c; ++c) {
+                if (c[0] != '{' || c[1] != '}' || next >= record.argCount) {
+                    out += *c;
+                    continue;
+                }
+                const Arg& arg = record.args[next++];
+                ++c;
+                switch (arg.type) {
+                    case Arg::Type::INT:
+                        std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(arg.value.i));
+                        break;
+                    case Arg::Type::UINT:
+                        std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(arg.value.u));
+                        break;
+                    case Arg::Type::DOUBLE:
+                        std::snprintf(number, sizeof(number), "%g", arg.value.d);
+                        break;
+                    case Arg::Type::BOOL:
+                        std::snprintf(number, sizeof(number), "%s", arg.value.u ? "true" : "false");
+                        break;
+                    case Arg::Type::HEX:
+                        std::snprintf(number, sizeof(number), "0x%02llx", static_cast<unsigned long long>(arg.value.u));
+                        break;
+                    case Arg::Type::TEXT:
+                        out.append(record.text + arg.textOffset, arg.textLength);
+                        continue;
+                }
+                out += number;
+            }
+        }
+
+        // Sink mutex held
+        static void drain(State& s) {
+            std::vector<ThreadQueue*> snapshot;
+            {
+                std::lock_guard<std::mutex> lock(s.registryMutex);
+                snapshot.reserve(s.queues.size());
+                for (auto& queue : s.queues) snapshot.push_back(queue.get());
+            }
+
+            for (ThreadQueue* queue : snapshot) {
+                while (queue->records.tryPop(s.record)) {
+                    format(s, *queue, s.record, s.line);
+                    write(s, s.record.level, s.line);
+                }
+
+                const uint64_t dropped = queue->dropped.load(std::memory_order_relaxed);
+                if (dropped != queue->droppedReported) {
+                    s.line = std::to_string(dropped - queue->droppedReported) + " log records dropped on thread "
+                             + std::to_string(queue->threadId) + ", ring full";
+                    queue->droppedReported = dropped;
+                    write(s, LogLevel::WARN, s.line);
+                }
+            }
+            if (!s.sink) std::fflush(stderr);
+        }
+
+        static void write(State& s, LogLevel level, const std::string& line) {
+            if (s.sink) {
+                s.sink(level, line);
+                return;
+            }
+            std::fwrite(line.data(), 1, line.size(), stderr);
+            std::fputc('\n', stderr);
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_LOGGER_H
@@ -0,0 +1,160 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_METRICS_H
+#define IMU_VISUALIZER_METRICS_H
+#pragma once
+
+#include "core/latency_histogram.h"
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace imu_viz {
+
+    /**
+     * Pull style metrics in the Prometheus text format.
+     * Components register collectors that read their own atomic counters when scraped, so the data
+     * path does nothing extra and never waits on a scrape. Series can come and go between scrapes
+     * (pipeline stages after a config change, the transport after a switch).
+     */
+    class MetricsRegistry {
+    public:
+        using Labels = std::vector<std::pair<std::string, std::string>>;
+
+        static constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+        // Collects one scrape, samples of the same family are grouped under one HELP/TYPE header
+        class Writer {
+        public:
+            void counter(const std::string& name, const char* help, const Labels& labels, double value) {
+                line(family(name, help, "counter"), name, labels, value);
+            }
+
+            void gauge(const std::string& name, const char* help, const Labels& labels, double value) {
+                line(family(name, help, "gauge"), name, labels, value);
+            }
+
+            // Histogram in ns exported as seconds, quantiles are over everything recorded since the last reset
+            void summary(const std::string& name, const char* help, const Labels& labels,
+                         const LatencyHistogram::Snapshot& snapshot) {
+                Family& f = family(name, help, "summary");
+                for (double q : QUANTILES) {
+                    Labels withQuantile = labels;
+                    withQuantile.emplace_back("quantile", formatValue(q));
+                    line(f, name, withQuantile, snapshot.percentileNs(q * 100.0) * 1e-9);
+                }
+                line(f, name + "_sum", labels, snapshot.meanNs * static_cast<double>(snapshot.count) * 1e-9);
+                line(f, name + "_count", labels, static_cast<double>(snapshot.count));
+            }
+
+            std::string text() const {
+                std::string out;
+                for (const auto& f : families) {
+                    out += "# HELP " + f.name + " " + f.help + "\n";
+                    out += "# TYPE " + f.name + " " + f.type + "\n";
+                    out += f.samples;
+                }
+                return out;
+            }
+
+        private:
+            struct Family {
+                std::string name;
+                std::string help;
+                std::string type;
+                std::string samples;
+            };
+            std::vector<Family> families;
+
+            Family& family(const std::string& name, const char* help, const char* type) {
+                for (auto& f : families) {
+                    if (f.name == name) return f;
+                }
+                families.push_back({name, help, type, {}});
+                return families.back();
+            }
+
+            static void line(Family& f, const std::string& name, const Labels& labels, double value) {
+                f.samples += name;
+                if (!labels.empty()) {
+                    f.samples += '{';
+                    for (size_t i = 0; i < labels.size(); ++i) {
+                        if (i > 0) f.samples += ',';
+                        f.samples += labels[i].first + "=\"" + escaped(labels[i].second) + '"';
+                    }
+                    f.samples += '}';
+                }
+                f.samples += ' ' + formatValue(value) + '\n';
+            }
+
+            static std::string escaped(const std::string& value) {
+                std::string result;
+                for (char c : value) {
+                    if (c == '\\' || c == '"') result += '\\';
+                    if (c == '\n') {
+                        result += "\\n";
+                        continue;
+                    }
+                    result += c;
+                }
+                return result;
+            }
+        };
+
+        using Collector = std::function<void(Writer&)>;
+
+        // Owner is only a key for removeCollectors
+        void addCollector(const void* owner, Collector collect) {
+            std::lock_guard<std::mutex> lock(mutex);
+            collectors.push_back({owner, std::move(collect)});
+        }
+
+        void removeCollectors(const void* owner) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Entry> kept;
+            for (auto& entry : collectors) {
+                if (entry.owner != owner) kept.push_back(std::move(entry));
+            }
+            collectors = std::move(kept);
+        }
+
+        std::string renderPrometheus() const {
+            Writer writer;
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& entry : collectors) {
+                entry.collect(writer);
+            }
+            return writer.text();
+        }
+
+        static std::string formatValue(double value) {
+            if (std::isnan(value)) return "NaN";
+            if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+            char text[32];
+            // Counters print exactly, everything else with enough digits to be useful
+            if (value == std::floor(value) && std::fabs(value) < 1e15) {
+                std::snprintf(text, sizeof(text), "%.0f", value);
+            } else {
+                std::snprintf(text, sizeof(text), "%.9g", value);
+            }
+            return text;
+        }
+
+    private:
+        struct Entry {
+            const void* owner;
+            Collector collect;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<Entry> collectors;
+    };
+}
+
+#endif //IMU_VISUALIZER_METRICS_H
@@ -0,0 +1,225 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_MINMAX_PYRAMID_H
+#define IMU_VISUALIZER_MINMAX_PYRAMID_H
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace imu_viz {
+
+    /**
+     * Per channel min/max of a sample stream at several resolutions, for plotting long histories.
+     *
+     * Level 0 holds the samples themselves and each level above summarises FANOUT buckets of the one
+     * below. Every level is a ring of LEVEL_CAPACITY buckets, so level k reaches back
+     * LEVEL_CAPACITY * FANOUT^k samples and memory is fixed. Appending is amortised O(1), a bucket is
+     * folded upwards once when it completes. query() picks the finest level that still covers the
+     * range with at most FANOUT buckets per column, so its cost follows the column count, not the
+     * amount of history.
+     */
+    template <size_t Channels>
+    class MinMaxPyramid {
+    public:
+        static constexpr size_t FANOUT = 8;
+        static constexpr size_t LEVELS = 6;                // Coarsest bucket is 32768 samples
+        static constexpr size_t LEVEL_CAPACITY = 1u << 15; // ~33 s of 1 kHz at level 0, ~12 days at the top
+
+        using Values = std::array<float, Channels>;
+
+        struct Bucket {
+            int64_t timeNs{0}; // First sample's, the bucket runs until the next one starts
+            Values min{};
+            Values max{};
+        };
+
+        // One plot column of query()
+        struct Column {
+            bool valid{false}; // Any samples in it
+            Values min{};
+            Values max{};
+        };
+
+        MinMaxPyramid() {
+            for (auto& level : levels) {
+                level.buckets.resize(LEVEL_CAPACITY);
+            }
+        }
+
+        // Times must not go backwards, an earlier one is clamped to the last
+        void append(int64_t timeNs, const Values& values) {
+            timeNs = std::max(timeNs, lastTimeNs);
+            lastTimeNs = timeNs;
+            push(0, Bucket{timeNs, values, values});
+        }
+
+        void clear() {
+            for (auto& level : levels) {
+                level.head = 0;
+                level.size = 0;
+                level.wrapped = false;
+            }
+            for (auto& p : partial) {
+                p.count = 0;
+            }
+            lastTimeNs = INT64_MIN;
+        }
+
+        bool empty() const { return levels[0].size == 0; }
+        int64_t newestTimeNs() const { return lastTimeNs; }
+
+        /**
+         * Splits [fromNs, toNs) into columnCount equal columns and fills each with the min/max of the
+         * samples in it. Work is O(columnCount * FANOUT + log(LEVEL_CAPACITY) * LEVELS). Returns the level
+         * used, 0 when the columns hold raw samples.
+         */
+        size_t query(int64_t fromNs, int64_t toNs, Column* columns, size_t columnCount) const {
+            for (size_t c = 0; c < columnCount; ++c) {
+                columns[c].valid = false;
+            }
+            if (columnCount == 0 || toNs <= fromNs || empty()) return 0;
+
+            // Finest level that reaches back far enough and isn't much denser than the columns
+            size_t level = LEVELS - 1;
+            size_t first = 0;
+            size_t last = 0;
+            for (size_t l = 0; l < LEVELS; ++l) {
+                const Level& candidate = levels[l];
+                first = candidate.size > 0 ? candidate.firstOverlapping(fromNs) : 0;
+                last = candidate.lowerBound(toNs);
+                const bool covers = !candidate.wrapped || candidate.at(0).timeNs <= fromNs;
+                if (l == LEVELS - 1 || (covers && last - first <= FANOUT * columnCount)) {
+                    level = l;
+                    break;
+                }
+            }
+
+            const double columnsPerNs = static_cast<double>(columnCount) / static_cast<double>(toNs - fromNs);
+            auto merge = [&](const Bucket& bucket) {
+                if (bucket.timeNs >= toNs) return;
+                const double position = static_cast<double>(bucket.timeNs - fromNs) * columnsPerNs;
+                const size_t c = position <= 0.0 ? 0 : std::min(columnCount - 1, static_cast<size_t>(position));
+                mergeInto(columns[c], bucket.min, bucket.max);
+            };
+
+            const Level& chosen = levels[level];
+            for (size_t i = first; i < last; ++i) {
+                merge(chosen.at(i));
+            }
+
+            // Samples newer than the level's last complete bucket are still in the partial buckets below it
+            if (level > 0) {
+                Bucket tail;
+                bool any = false;
+                for (size_t l = level; l >= 1; --l) {
+                    const Partial& p = partial[l];
+                    if (p.count == 0) continue;
+                    if (!any) {
+                        tail = p.bucket;
+                        any = true;
+                    } else {
+                        combine(tail, p.bucket);
+                    }
+                }
+                if (any) merge(tail);
+            }
+            return level;
+        }
+
+    private:
+        struct Level {
+            std::vector<Bucket> buckets; // Ring, allocated once
+            size_t head{0};              // Next slot written
+            size_t size{0};
+            bool wrapped{false};         // Oldest buckets have been overwritten
+
+            // Logical index, 0 is the oldest
+            const Bucket& at(size_t i) const {
+                return buckets[(head + LEVEL_CAPACITY - size + i) % LEVEL_CAPACITY];
+            }
+
+            // First bucket starting at or after timeNs
+            size_t lowerBound(int64_t timeNs) const {
+                size_t lo = 0;
+                size_t hi = size;
+                while (lo < hi) {
+                    const size_t mid = lo + (hi - lo) / 2;
+                    if (at(mid).timeNs < timeNs) lo = mid + 1; else hi = mid;
+                }
+                return lo;
+            }
+
+            // Bucket that contains timeNs, or the first after it
+            size_t firstOverlapping(int64_t timeNs) const {
+                const size_t i = lowerBound(timeNs);
+                if (i < size && at(i).timeNs == timeNs) return i;
+                return i > 0 ? i - 1 : 0;
+            }
+
+            void write(const Bucket& bucket) {
+                buckets[head] = bucket;
+                head = (head + 1) % LEVEL_CAPACITY;
+                if (size < LEVEL_CAPACITY) {
+                    ++size;
+                } else {
+                    wrapped = true;
+                }
+            }
+        };
+
+        // Level l bucket being built from completed level l - 1 buckets
+        struct Partial {
+            Bucket bucket;
+            size_t count{0};
+        };
+
+        std::array<Level, LEVELS> levels;
+        std::array<Partial, LEVELS> partial; // [0] unused
+        int64_t lastTimeNs{INT64_MIN};
+
+        void push(size_t level, const Bucket& bucket) {
+            levels[level].write(bucket);
+            if (level + 1 == LEVELS) return;
+
+            Partial& above = partial[level + 1];
+            if (above.count == 0) {
+                above.bucket = bucket;
+            } else {
+                combine(above.bucket, bucket);
+            }
+            if (++above.count == FANOUT) {
+                above.count = 0;
+                push(level + 1, above.bucket);
+            }
+        }
+
+        // Keeps into's start time
+        static void combine(Bucket& into, const Bucket& other) {
+            for (size_t ch = 0; ch < Channels; ++ch) {
+                into.min[ch] = std::min(into.min[ch], other.min[ch]);
+                into.max[ch] = std::max(into.max[ch], other.max[ch]);
+            }
+        }
+
+        static void mergeInto(Column& column, const Values& min, const Values& max) {
+            if (!column.valid) {
+                column.valid = true;
+                column.min = min;
+                column.max = max;
+                return;
+            }
+            for (size_t ch = 0; ch < Channels; ++ch) {
+                column.min[ch] = std::min(column.min[ch], min[ch]);
+                column.max[ch] = std::max(column.max[ch], max[ch]);
+            }
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_MINMAX_PYRAMID_H
@@ -0,0 +1,231 @@
+//
+// Created by Raphael Russo on 12/19/24.
+//
+
+#ifndef IMU_VISUALIZER_PROFILER_H
+#define IMU_VISUALIZER_PROFILER_H
+#pragma once
+
+// Scoped profiling zones, compiled in only with -DIMU_VIZ_PROFILING=ON.
+//
+//   IMU_PROFILE_ZONE("DataProcessor::processIMUData");  // Times the rest of the enclosing scope
+//   IMU_PROFILE_THREAD_NAME("mock transport");          // Label for this thread in the trace
+//
+// Zone names must be string literals, only the pointer is stored. Each thread writes into its own ring,
+// so recording never locks or allocates after the thread's first zone. Profiler::writeChromeTrace
+// exports everything still in the rings as Chrome trace-event JSON (chrome://tracing, Perfetto).
+
+#ifdef IMU_VIZ_PROFILING
+
+#include "core/clock.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define IMU_PROFILE_CONCAT_INNER(a, b) a##b
+#define IMU_PROFILE_CONCAT(a, b) IMU_PROFILE_CONCAT_INNER(a, b)
+#define IMU_PROFILE_ZONE(name) ::imu_viz::ProfileZone IMU_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define IMU_PROFILE_THREAD_NAME(name) ::imu_viz::Profiler::setThreadName(name)
+
+namespace imu_viz {
+
+    class Profiler {
+    public:
+        static constexpr size_t EVENTS_PER_THREAD = size_t{1} << 14; // Oldest are overwritten
+        static constexpr size_t THREAD_NAME_LENGTH = 32;
+
+        // Single writer (the owning thread). Fields are relaxed atomics so the exporter may read
+        // while the owner keeps writing, it drops anything overwritten under it
+        class ThreadBuffer {
+        public:
+            void push(const char* name, int64_t beginNs, int64_t endNs) {
+                const uint64_t n = written.load(std::memory_order_relaxed);
+                Event& event = events[n & (EVENTS_PER_THREAD - 1)];
+                event.name.store(name, std::memory_order_relaxed);
+                event.beginNs.store(beginNs, std::memory_order_relaxed);
+                event.endNs.store(endNs, std::memory_order_relaxed);
+                written.store(n + 1, std::memory_order_release);
+            }
+
+        private:
+            friend class Profiler;
+
+            struct Event {
+                std::atomic<const char*> name{nullptr};
+                std::atomic<int64_t> beginNs{0};
+                std::atomic<int64_t> endNs{0};
+            };
+
+            std::array<Event, EVENTS_PER_THREAD> events;
+            std::atomic<uint64_t> written{0};
+            uint32_t threadId{0};
+            std::array<char, THREAD_NAME_LENGTH> threadName{};
+            bool active{false}; // Guarded by the registry mutex
+        };
+
+        static ThreadBuffer& threadBuffer() {
+            thread_local Registration registration;
+            return *registration.buffer;
+        }
+
+        // Copied, so a std::string's c_str() is fine here
+        static void setThreadName(const char* name) {
+            ThreadBuffer& buffer = threadBuffer();
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            std::strncpy(buffer.threadName.data(), name, THREAD_NAME_LENGTH - 1);
+            buffer.threadName[THREAD_NAME_LENGTH - 1] = '\0';
+        }
+
+        static void writeChromeTrace(std::ostream& out) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+
+            out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+            bool first = true;
+            auto separator = [&out, &first]() {
+                if (!first) out << ",\n";
+                first = false;
+            };
+
+            for (const auto& buffer : reg.buffers) {
+                if (buffer->threadName[0] != '\0') {
+                    separator();
+                    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                        << ",\"args\":{\"name\":\"" << escaped(buffer->threadName.data()) << "\"}}";
+                }
+
+                const uint64_t end = buffer->written.load(std::memory_order_acquire);
+                const uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+                struct Copy { const char* name; int64_t beginNs; int64_t endNs; };
+                std::vector<Copy> copies;
+                copies.reserve(static_cast<size_t>(end - begin));
+                for (uint64_t i = begin; i < end; ++i) {
+                    const auto& event = buffer->events[i & (EVENTS_PER_THREAD - 1)];
+                    copies.push_back({event.name.load(std::memory_order_relaxed),
+                                      event.beginNs.load(std::memory_order_relaxed),
+                                      event.endNs.load(std::memory_order_relaxed)});
+                }
+
+                // Entries the owner lapped while we copied are torn, skip them
+                const uint64_t after = buffer->written.load(std::memory_order_acquire);
+                const uint64_t valid = after > EVENTS_PER_THREAD ? after - EVENTS_PER_THREAD : 0;
+                for (uint64_t i = std::max(begin, valid); i < end; ++i) {
+                    const Copy& event = copies[static_cast<size_t>(i - begin)];
+                    if (!event.name) continue;
+                    separator();
+                    out << "{\"name\":\"" << escaped(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                        << buffer->threadId
+                        << ",\"ts\":" << microseconds(event.beginNs - reg.epochNs)
+                        << ",\"dur\":" << microseconds(event.endNs - event.beginNs) << "}";
+                }
+            }
+            out << "]}\n";
+        }
+
+        static bool dumpChromeTrace(const std::string& path) {
+            std::ofstream out(path);
+            if (!out) return false;
+            writeChromeTrace(out);
+            return static_cast<bool>(out);
+        }
+
+    private:
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            uint32_t nextThreadId{1};
+            int64_t epochNs{steadyNowNs()}; // Trace timestamps start near zero
+        };
+
+        static Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        // Claims a buffer on a thread's first zone and frees it for reuse when the thread exits,
+        // so transports that reconnect don't grow the registry without bound
+        struct Registration {
+            ThreadBuffer* buffer{nullptr};
+
+            Registration() {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                for (auto& candidate : reg.buffers) {
+                    if (!candidate->active) {
+                        buffer = candidate.get();
+                        break;
+                    }
+                }
+                if (!buffer) {
+                    reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+                    buffer = reg.buffers.back().get();
+                }
+                buffer->active = true;
+                buffer->threadId = reg.nextThreadId++;
+                buffer->threadName[0] = '\0';
+                buffer->written.store(0, std::memory_order_release);
+            }
+
+            ~Registration() {
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                buffer->active = false;
+            }
+        };
+
+        static std::string microseconds(int64_t ns) {
+            // Keep ns precision, trace viewers take fractional microseconds
+            const char* sign = ns < 0 ? "-" : "";
+            const uint64_t magnitude = ns < 0 ? static_cast<uint64_t>(-ns) : static_cast<uint64_t>(ns);
+            char text[32];
+            std::snprintf(text, sizeof(text), "%s%llu.%03llu", sign,
+                          static_cast<unsigned long long>(magnitude / 1000),
+                          static_cast<unsigned long long>(magnitude % 1000));
+            return text;
+        }
+
+        static std::string escaped(const char* text) {
+            std::string result;
+            for (const char* c = text; *c; ++c) {
+                if (*c == '"' || *c == '\\') result += '\\';
+                if (static_cast<unsigned char>(*c) >= 0x20) result += *c;
+            }
+            return result;
+        }
+    };
+
+    class ProfileZone {
+    public:
+        explicit ProfileZone(const char* name)
+                : name(name), beginNs(steadyNowNs()) {}
+
+        ~ProfileZone() {
+            Profiler::threadBuffer().push(name, beginNs, steadyNowNs());
+        }
+
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* name;
+        int64_t beginNs;
+    };
+}
+
+#else
+
+#define IMU_PROFILE_ZONE(name) ((void)0)
+#define IMU_PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif // IMU_VIZ_PROFILING
+
+#endif //IMU_VISUALIZER_PROFILER_H
@@ -0,0 +1,61 @@
+//
+// Created by Raphael Russo on 12/14/24.
+//
+
+#ifndef IMU_VISUALIZER_SPSC_QUEUE_H
+#define IMU_VISUALIZER_SPSC_QUEUE_H
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace imu_viz {
+
+    /**
+     * Bounded single producer / single consumer ring, lock free and allocation free.
+     * One slot is kept empty to tell full from empty, so it holds Capacity - 1 items.
+     */
+    template <typename T, size_t Capacity>
+    class SpscQueue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        // Producer side, false when full
+        bool tryPush(const T& item) {
+            const size_t tail = tailIndex.load(std::memory_order_relaxed);
+            const size_t next = (tail + 1) & MASK;
+            if (next == headIndex.load(std::memory_order_acquire)) {
+                return false;
+            }
+            items[tail] = item;
+            tailIndex.store(next, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, false when empty
+        bool tryPop(T& item) {
+            const size_t head = headIndex.load(std::memory_order_relaxed);
+            if (head == tailIndex.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = items[head];
+            headIndex.store((head + 1) & MASK, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr size_t MASK = Capacity - 1;
+
+        // Producer and consumer indices on separate cache lines so they don't false share
+        alignas(64) std::atomic<size_t> headIndex{0};
+        alignas(64) std::atomic<size_t> tailIndex{0};
+        alignas(64) std::array<T, Capacity> items{};
+    };
+}
+
+#endif //IMU_VISUALIZER_SPSC_QUEUE_H
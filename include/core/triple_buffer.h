@@ -0,0 +1,67 @@
+//
+// Created by Raphael Russo on 12/15/24.
+//
+
+#ifndef IMU_VISUALIZER_TRIPLE_BUFFER_H
+#define IMU_VISUALIZER_TRIPLE_BUFFER_H
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace imu_viz {
+
+    /**
+     * Latest value slot for one writer and one reader, wait free on both sides.
+     * The writer fills a back buffer and swaps it into the middle, the reader swaps the middle
+     * out when it is newer than what it holds. Neither side ever sees a half written value and
+     * values the reader never picked up are counted as coalesced.
+     */
+    template <typename T>
+    class TripleBuffer {
+    public:
+        // Writer side
+        void write(const T& value) {
+            buffers[back] = value;
+            const uint8_t previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+            back = previous & INDEX_MASK;
+            if (previous & FRESH) {
+                coalesced.fetch_add(1, std::memory_order_relaxed); // Overwritten before anyone read it
+            }
+        }
+
+        // Reader side, true if out is newer than the last read
+        bool read(T& out) {
+            bool fresh = false;
+            if (middle.load(std::memory_order_relaxed) & FRESH) {
+                const uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+                front = previous & INDEX_MASK;
+                fresh = true;
+            }
+            out = buffers[front];
+            return fresh;
+        }
+
+        // Reader side, true if read would return something new. Cheap enough to poll
+        bool hasFresh() const {
+            return (middle.load(std::memory_order_acquire) & FRESH) != 0;
+        }
+
+        uint64_t getCoalescedCount() const {
+            return coalesced.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr uint8_t INDEX_MASK = 0x3;
+        static constexpr uint8_t FRESH = 0x4;
+
+        std::array<T, 3> buffers{};
+        uint8_t back{0};                     // Writer owned
+        alignas(64) std::atomic<uint8_t> middle{1};
+        alignas(64) uint8_t front{2};        // Reader owned
+        std::atomic<uint64_t> coalesced{0};
+    };
+}
+
+#endif //IMU_VISUALIZER_TRIPLE_BUFFER_H
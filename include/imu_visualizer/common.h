@@ -8,7 +8,6 @@
 #pragma once
 #include <Eigen/Core>
 #include <Eigen/Geometry>
-#include <QMetaType>
 
 namespace imu_viz {
     using Vector3d = Eigen::Vector3d;
@@ -17,8 +16,4 @@ namespace imu_viz {
     using Matrix4d = Eigen::Matrix4d;
 }
 
-Q_DECLARE_METATYPE(imu_viz::Vector3d)
-Q_DECLARE_METATYPE(imu_viz::Quaterniond)
-Q_DECLARE_METATYPE(imu_viz::Matrix3d)
-
 #endif //IMU_VISUALIZER_COMMON_H
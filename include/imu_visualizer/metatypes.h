@@ -0,0 +1,19 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_METATYPES_H
+#define IMU_VISUALIZER_METATYPES_H
+
+#pragma once
+#include "core/imu_data.h"
+#include <QMetaType>
+
+// Kept out of common.h so the core library builds without Qt
+
+Q_DECLARE_METATYPE(imu_viz::Vector3d)
+Q_DECLARE_METATYPE(imu_viz::Quaterniond)
+Q_DECLARE_METATYPE(imu_viz::Matrix3d)
+Q_DECLARE_METATYPE(imu_viz::OrientationSample)
+
+#endif //IMU_VISUALIZER_METATYPES_H
@@ -0,0 +1,161 @@
+//
+// Created by Raphael Russo on 12/07/24.
+//
+
+#include "core/imu_data.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace imu_viz {
+    namespace {
+        /**
+         * Binary profile layout, little endian, always exactly FILE_SIZE bytes:
+         *   0   char[4]    magic "IMUC"
+         *   4   uint32     format version
+         *   8   double[24] accelBias(3), accelScale(9, row major), gyroBias(3), gyroScale(9)
+         *   200 uint32     CRC-32 of bytes 0..199
+         */
+        constexpr char MAGIC[4] = {'I', 'M', 'U', 'C'};
+        constexpr uint32_t FORMAT_VERSION = 1;
+        constexpr size_t VALUE_COUNT = 24;
+        constexpr size_t PAYLOAD_SIZE = 8 + VALUE_COUNT * sizeof(double);
+        constexpr size_t FILE_SIZE = PAYLOAD_SIZE + sizeof(uint32_t);
+
+        uint32_t crc32(const uint8_t* data, size_t length) {
+            uint32_t crc = 0xFFFFFFFFu;
+            for (size_t i = 0; i < length; ++i) {
+                crc ^= data[i];
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+                }
+            }
+            return ~crc;
+        }
+
+        // Byte by byte, so the layout is little endian whatever the host is
+        void storeLE(uint8_t* out, uint64_t value, size_t bytes) {
+            for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+
+        uint64_t loadLE(const uint8_t* in, size_t bytes) {
+            uint64_t value = 0;
+            for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+            return value;
+        }
+
+        void storeDouble(uint8_t* out, double value) {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            storeLE(out, bits, sizeof(bits));
+        }
+
+        double loadDouble(const uint8_t* in) {
+            const uint64_t bits = loadLE(in, sizeof(uint64_t));
+            double value = 0.0;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        std::array<double, VALUE_COUNT> flatten(const CalibrationData& c) {
+            std::array<double, VALUE_COUNT> v{};
+            size_t n = 0;
+            for (int i = 0; i < 3; ++i) v[n++] = c.accelBias(i);
+            for (int r = 0; r < 3; ++r) for (int col = 0; col < 3; ++col) v[n++] = c.accelScale(r, col);
+            for (int i = 0; i < 3; ++i) v[n++] = c.gyroBias(i);
+            for (int r = 0; r < 3; ++r) for (int col = 0; col < 3; ++col) v[n++] = c.gyroScale(r, col);
+            return v;
+        }
+
+        void unflatten(const std::array<double, VALUE_COUNT>& v, CalibrationData& c) {
+            size_t n = 0;
+            for (int i = 0; i < 3; ++i) c.accelBias(i) = v[n++];
+            for (int r = 0; r < 3; ++r) for (int col = 0; col < 3; ++col) c.accelScale(r, col) = v[n++];
+            for (int i = 0; i < 3; ++i) c.gyroBias(i) = v[n++];
+            for (int r = 0; r < 3; ++r) for (int col = 0; col < 3; ++col) c.gyroScale(r, col) = v[n++];
+        }
+    }
+
+    bool CalibrationData::saveToFile(const std::string& filename) const {
+        std::array<uint8_t, FILE_SIZE> buffer{};
+        const auto values = flatten(*this);
+
+        std::memcpy(buffer.data(), MAGIC, sizeof(MAGIC));
+        storeLE(buffer.data() + 4, FORMAT_VERSION, sizeof(FORMAT_VERSION));
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            storeDouble(buffer.data() + 8 + i * sizeof(double), values[i]);
+        }
+        storeLE(buffer.data() + PAYLOAD_SIZE, crc32(buffer.data(), PAYLOAD_SIZE), sizeof(uint32_t));
+
+        // Write next to the target and rename so a crash never leaves half a profile behind
+        const std::string tmp = filename + ".tmp";
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        out.close();
+
+        // A full disk may only show up when the buffer is flushed, never rename a short file over the profile
+        if (!out.good() || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool CalibrationData::loadFromFile(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) return false;
+
+        std::array<uint8_t, FILE_SIZE> buffer{};
+        if (!in.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) {
+            return false; // Truncated
+        }
+
+        const auto version = static_cast<uint32_t>(loadLE(buffer.data() + 4, sizeof(uint32_t)));
+        const auto storedCrc = static_cast<uint32_t>(loadLE(buffer.data() + PAYLOAD_SIZE, sizeof(uint32_t)));
+        if (std::memcmp(buffer.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+            version != FORMAT_VERSION ||
+            storedCrc != crc32(buffer.data(), PAYLOAD_SIZE)) {
+            return false;
+        }
+
+        std::array<double, VALUE_COUNT> values{};
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+            values[i] = loadDouble(buffer.data() + 8 + i * sizeof(double));
+            if (!std::isfinite(values[i])) return false;
+        }
+
+        // Only touch *this once everything checked out
+        unflatten(values, *this);
+        return true;
+    }
+
+    bool CalibrationData::exportToText(const std::string& filename, const std::string& sensorId) const {
+        std::ofstream out(filename, std::ios::trunc);
+        if (!out) return false;
+
+        auto writeVector = [&out](const char* name, const Vector3d& v) {
+            out << name << " = " << v.x() << ' ' << v.y() << ' ' << v.z() << '\n';
+        };
+        auto writeMatrix = [&out](const char* name, const Matrix3d& m) {
+            out << name << " =";
+            for (int r = 0; r < 3; ++r) {
+                out << (r == 0 ? " " : " ; ") << m(r, 0) << ' ' << m(r, 1) << ' ' << m(r, 2);
+            }
+            out << '\n';
+        };
+
+        out.precision(17);
+        out << "# IMU calibration profile, format version " << FORMAT_VERSION << '\n';
+        if (!sensorId.empty()) {
+            out << "sensor = " << sensorId << '\n';
+        }
+        writeVector("accel_bias", accelBias);
+        writeMatrix("accel_scale", accelScale);
+        writeVector("gyro_bias", gyroBias);
+        writeMatrix("gyro_scale", gyroScale);
+        return static_cast<bool>(out);
+    }
+}
@@ -0,0 +1,206 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+// Headless ingest -> fusion -> recording/metrics for machines without a display
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStandardPaths>
+#include <QTimer>
+#include <atomic>
+#include <csignal>
+#include <memory>
+#include "core/logger.h"
+#include "core/metrics.h"
+#include "core/profiler.h"
+#include "processing/fusion_engine.h"
+#include "processing/calibration/calibration_store.h"
+#include "recording/orientation_recorder.h"
+#include "monitoring/engine_metrics.h"
+#include "monitoring/metrics_server.h"
+#include "transport/mock_transport.h"
+#include "transport/tcp_transport.h"
+#include "transport/serial_transport.h"
+
+using namespace imu_viz;
+
+namespace {
+    std::atomic<bool> stopRequested{false};
+
+    void handleSignal(int) {
+        stopRequested.store(true, std::memory_order_relaxed);
+    }
+
+    bool parseFilter(const QString& name, OrientationFilterFactory::FilterType& type) {
+        if (name == "complementary") type = OrientationFilterFactory::FilterType::COMPLEMENTARY;
+        else if (name == "madgwick") type = OrientationFilterFactory::FilterType::MADGWICK;
+        else if (name == "kalman") type = OrientationFilterFactory::FilterType::KALMAN;
+        else return false;
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    // Same name as the GUI so both find the same calibration profiles
+    QCoreApplication::setApplicationName("imu_visualizer");
+    IMU_PROFILE_THREAD_NAME("daemon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs IMU ingest and fusion without a display.");
+    parser.addHelpOption();
+    QCommandLineOption transportOption("transport", "mock, tcp or serial (default mock).", "type", "mock");
+    QCommandLineOption portOption("port", "TCP port to listen on (default 8080) or serial port name.", "port");
+    QCommandLineOption baudOption("baud", "Serial baud rate (default 115200).", "rate", "115200");
+    QCommandLineOption filterOption("filter", "complementary, madgwick or kalman (default kalman).",
+                                    "type", "kalman");
+    QCommandLineOption pipelineOption("pipeline", "Processing stage list, see FusionEngine.", "stages");
+    QCommandLineOption recordOption("record", "Write every published orientation to a CSV file.", "file");
+    QCommandLineOption metricsPortOption("metrics-port",
+                                         "Serve Prometheus metrics on localhost:<port>/metrics (default off).",
+                                         "port");
+    parser.addOptions({transportOption, portOption, baudOption, filterOption, pipelineOption,
+                       recordOption, metricsPortOption});
+    parser.process(app);
+
+    FusionEngine engine;
+    OrientationRecorder recorder;
+    MetricsRegistry metrics;
+    CalibrationStore calibrationStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                                              .append("/calibration").toStdString());
+
+    OrientationFilterFactory::FilterType filterType;
+    if (!parseFilter(parser.value(filterOption), filterType)) {
+        parser.showHelp(1);
+    }
+    engine.setFilterType(filterType);
+
+    FusionEngine::Callbacks callbacks;
+    callbacks.orientation = [&recorder](const OrientationSample& sample) { recorder.record(sample); };
+    callbacks.error = [](const std::string& message) { IMU_LOG_ERROR("{}", message); };
+    callbacks.errorSummary = [](const std::string& summary) { IMU_LOG_WARN("{}", summary); };
+    engine.setCallbacks(std::move(callbacks));
+
+    if (parser.isSet(pipelineOption) && !engine.setPipelineConfig(parser.value(pipelineOption).toStdString())) {
+        return 1;
+    }
+
+    // Transports
+    std::unique_ptr<ITransport> transport;
+    const QString transportName = parser.value(transportOption);
+    if (transportName == "mock") {
+        transport = std::make_unique<MockTransport>();
+    } else if (transportName == "tcp") {
+        auto tcp = std::make_unique<TCPTransport>();
+        if (parser.isSet(portOption)) {
+            bool ok = false;
+            const uint port = parser.value(portOption).toUInt(&ok);
+            if (!ok || port == 0 || port > 65535) {
+                parser.showHelp(1);
+            }
+            tcp->setPort(static_cast<quint16>(port));
+        }
+        transport = std::move(tcp);
+    } else if (transportName == "serial") {
+        auto serial = std::make_unique<SerialTransport>();
+        if (parser.isSet(portOption)) {
+            serial->setPort(parser.value(portOption));
+        }
+        bool ok = false;
+        const qint32 baud = parser.value(baudOption).toInt(&ok);
+        if (!ok || baud <= 0) {
+            parser.showHelp(1);
+        }
+        serial->setBaudRate(baud);
+        transport = std::move(serial);
+    } else {
+        parser.showHelp(1);
+    }
+
+    transport->setDataCallback([&engine](const IMUData& data) {
+        engine.submitIMUData(data);
+    });
+    transport->setErrorCallback([&engine](const std::string& error) {
+        engine.getErrorAggregator().record(ErrorCategory::TRANSPORT, error);
+    });
+    transport->setConnectionCallback([&app, &engine, &calibrationStore](const std::string& sensorId) {
+        // New stream, possibly on a new clock. Locks on its own, so it can run right here
+        engine.resetStream();
+        // May arrive on the transport's thread, the engine is configured from the main thread only
+        QMetaObject::invokeMethod(&app, [&engine, &calibrationStore, sensorId]() {
+            CalibrationData calibration;
+            const bool found = calibrationStore.load(sensorId, calibration);
+            engine.setCalibrationData(calibration);
+            IMU_LOG_INFO("Sensor {} connected, {}", sensorId,
+                         found ? "calibration profile loaded" : "no calibration profile");
+        }, Qt::QueuedConnection);
+    });
+    engine.setAxisMapping(transport->axisMapping());
+    engine.setJitterBufferEnabled(transport->isNetworked());
+
+    if (parser.isSet(recordOption)) {
+        const std::string path = parser.value(recordOption).toStdString();
+        if (!recorder.open(path)) {
+            IMU_LOG_ERROR("Could not open {} for recording", path);
+            return 1;
+        }
+        IMU_LOG_INFO("Recording to {}", path);
+    }
+
+    // Metrics
+    MetricsServer metricsServer(metrics);
+    if (parser.isSet(metricsPortOption)) {
+        bool ok = false;
+        const uint port = parser.value(metricsPortOption).toUInt(&ok);
+        if (!ok || port == 0 || port > 65535) {
+            parser.showHelp(1);
+        }
+
+        const char* kind = transportName == "tcp" ? "tcp" : transportName == "serial" ? "serial" : "mock";
+        metrics.addCollector(&engine, [&, kind](MetricsRegistry::Writer& out) {
+            writeTransportMetrics(out, kind, transport->getCounters());
+            writeEngineMetrics(out, engine);
+            out.counter("imu_viz_recorder_written_total", "Orientations written to the recording",
+                        {}, static_cast<double>(recorder.getWritten()));
+            out.counter("imu_viz_recorder_dropped_total", "Orientations dropped at the recorder's full queue",
+                        {}, static_cast<double>(recorder.getDropped()));
+        });
+
+        if (!metricsServer.start(static_cast<quint16>(port))) {
+            IMU_LOG_ERROR("Metrics server could not listen on port {}: {}", port,
+                          metricsServer.errorString().toStdString());
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    // One loop for every periodic duty, the engine keeps its own schedule
+    QTimer pollTimer;
+    pollTimer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&pollTimer, &QTimer::timeout, [&app, &engine]() {
+        if (stopRequested.load(std::memory_order_relaxed)) {
+            app.quit();
+            return;
+        }
+        engine.poll(steadyNowNs());
+    });
+    pollTimer.start(FusionEngine::INGEST_INTERVAL_MS);
+
+    if (!transport->connect()) {
+        IMU_LOG_ERROR("Could not start the {} transport", transportName.toStdString());
+        return 1;
+    }
+
+    const int result = app.exec();
+
+    // Stop the producers before the recorder writes out what is left
+    transport->disconnect();
+    metrics.removeCollectors(&engine);
+    recorder.close();
+    IMU_LOG_INFO("Stopped, {} orientations recorded, {} dropped", recorder.getWritten(), recorder.getDropped());
+    Logger::flush();
+    return result;
+}
@@ -1,21 +1,42 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include "ui/main_window.h"
+#include "core/profiler.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
+    IMU_PROFILE_THREAD_NAME("gui");
     // Set default surface format
     QSurfaceFormat format;
     format.setVersion(3, 3);
     format.setProfile(QSurfaceFormat::CoreProfile);
     format.setDepthBufferSize(24);
     format.setSamples(4);
+    format.setSwapInterval(1);  // Vsync, GLWidget paces its frames against the swap
     QSurfaceFormat::setDefaultFormat(format);  // Set as default format
     qRegisterMetaType<imu_viz::Quaterniond>("Quaterniond");
     qRegisterMetaType<imu_viz::Vector3d>("Vector3d");
+    qRegisterMetaType<imu_viz::OrientationSample>("OrientationSample");
     qRegisterMetaType<imu_viz::TransportType>();
 
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption metricsPort("metrics-port",
+                                   "Serve Prometheus metrics on localhost:<port>/metrics (default off).",
+                                   "port");
+    parser.addOption(metricsPort);
+    parser.process(app);
+
     imu_viz::MainWindow window;
+    if (parser.isSet(metricsPort)) {
+        bool ok = false;
+        const uint port = parser.value(metricsPort).toUInt(&ok);
+        if (!ok || port == 0 || port > 65535) {
+            parser.showHelp(1);
+        }
+        window.startMetricsServer(static_cast<quint16>(port));
+    }
     window.show();
 
     return app.exec();
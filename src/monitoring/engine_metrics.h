@@ -0,0 +1,70 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_ENGINE_METRICS_H
+#define IMU_VISUALIZER_ENGINE_METRICS_H
+#pragma once
+
+#include "core/metrics.h"
+#include "processing/fusion_engine.h"
+#include "transport/transport_interface.h"
+#include <utility>
+
+namespace imu_viz {
+
+    // Collector bodies shared by the GUI and imu_daemon, both only read counters the data path keeps anyway
+
+    inline void writeTransportMetrics(MetricsRegistry::Writer& out, const char* kind, const TransportCounters& counters) {
+        const MetricsRegistry::Labels labels = {{"transport", kind}};
+        out.counter("imu_viz_transport_packets_total", "Packets decoded, rate() for packets/s",
+                    labels, static_cast<double>(counters.packets.load(std::memory_order_relaxed)));
+        out.counter("imu_viz_transport_bytes_total", "Bytes read, rate() for bytes/s",
+                    labels, static_cast<double>(counters.bytes.load(std::memory_order_relaxed)));
+        out.counter("imu_viz_transport_framing_errors_total", "Packets rejected for a bad end marker",
+                    labels, static_cast<double>(counters.framingErrors.load(std::memory_order_relaxed)));
+        out.counter("imu_viz_transport_resyncs_total", "Times bytes were skipped to find a start marker",
+                    labels, static_cast<double>(counters.resyncs.load(std::memory_order_relaxed)));
+    }
+
+    inline void writeEngineMetrics(MetricsRegistry::Writer& out, FusionEngine& engine) {
+        const ErrorAggregator& errors = engine.getErrorAggregator();
+        const std::pair<const char*, ErrorCategory> rejects[] = {
+                {"non_finite", ErrorCategory::NON_FINITE_SAMPLE},
+                {"accel_out_of_range", ErrorCategory::ACCEL_OUT_OF_RANGE},
+                {"gyro_out_of_range", ErrorCategory::GYRO_OUT_OF_RANGE},
+        };
+        for (const auto& [reason, category] : rejects) {
+            out.counter("imu_viz_validation_rejects_total", "Samples rejected by validation",
+                        {{"reason", reason}}, static_cast<double>(errors.getTotal(category)));
+        }
+        out.counter("imu_viz_ingest_overflows_total", "Samples dropped at the transport to processor hand off",
+                    {}, static_cast<double>(errors.getTotal(ErrorCategory::INGEST_OVERFLOW)));
+
+        // Inline stages have no queue, their depth stays 0. The filter stage's service time is the filter update
+        for (const StageStats& stage : engine.getPipelineStats()) {
+            const MetricsRegistry::Labels labels = {{"stage", stage.name}, {"mode", Pipeline::modeName(stage.mode)}};
+            out.gauge("imu_viz_pipeline_queue_depth", "Frames waiting in the stage's queue",
+                      labels, static_cast<double>(stage.queueDepth));
+            out.counter("imu_viz_pipeline_queue_drops_total", "Frames dropped at the stage's full queue",
+                        labels, static_cast<double>(stage.queueDrops));
+            out.counter("imu_viz_pipeline_processed_total", "Frames the stage ran on, passed on or stopped",
+                        labels, static_cast<double>(stage.processed));
+            out.counter("imu_viz_pipeline_stopped_total", "Frames the stage stopped: rejected, merged or consumed",
+                        labels, static_cast<double>(stage.stopped));
+            out.gauge("imu_viz_pipeline_service_mean_seconds", "Mean time per frame in the stage, sampled",
+                      labels, stage.meanServiceNs * 1e-9);
+            out.gauge("imu_viz_pipeline_service_max_seconds", "Longest sampled time per frame in the stage",
+                      labels, stage.maxServiceNs * 1e-9);
+        }
+
+        const LatencyMonitor& latency = engine.getLatencyMonitor();
+        for (size_t i = 0; i < LatencyMonitor::STAGE_COUNT; ++i) {
+            const auto stage = static_cast<LatencyStage>(i);
+            out.summary("imu_viz_latency_seconds", "Sample latency per segment from transport read to buffer swap",
+                        {{"segment", LatencyMonitor::key(stage)}}, latency.snapshot(stage));
+        }
+    }
+}
+
+#endif //IMU_VISUALIZER_ENGINE_METRICS_H
@@ -0,0 +1,89 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#include "metrics_server.h"
+#include <QHostAddress>
+#include <QTimer>
+#include <memory>
+
+namespace imu_viz {
+
+    MetricsServer::MetricsServer(const MetricsRegistry& registry, QObject* parent)
+            : QObject(parent)
+            , registry(registry)
+            , server(new QTcpServer(this))
+    {
+        QObject::connect(server, &QTcpServer::newConnection,
+                         this, &MetricsServer::handleNewConnection);
+    }
+
+    bool MetricsServer::start(quint16 port) {
+        if (server->isListening()) return true;
+        return server->listen(QHostAddress::LocalHost, port);
+    }
+
+    void MetricsServer::stop() {
+        server->close();
+    }
+
+    void MetricsServer::handleNewConnection() {
+        while (QTcpSocket* socket = server->nextPendingConnection()) {
+            auto request = std::make_shared<QByteArray>();
+
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket, request]() {
+                request->append(socket->readAll());
+                if (request->contains("\r\n\r\n")) {
+                    handleRequest(socket, *request);
+                    request->clear();
+                } else if (request->size() > MAX_REQUEST_BYTES) {
+                    respond(socket, "431 Request Header Fields Too Large", "text/plain", "Request too large\n");
+                }
+            });
+
+            // A client that connects and never finishes its request doesn't get to hold the socket
+            QTimer::singleShot(REQUEST_TIMEOUT_MS, socket, &QTcpSocket::abort);
+        }
+    }
+
+    void MetricsServer::handleRequest(QTcpSocket* socket, const QByteArray& request) {
+        // Only the request line matters, "GET /metrics HTTP/1.1"
+        const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+        if (requestLine.size() < 2) {
+            respond(socket, "400 Bad Request", "text/plain", "Bad request\n");
+            return;
+        }
+
+        const QByteArray& method = requestLine[0];
+        QByteArray path = requestLine[1];
+        const int query = path.indexOf('?');
+        if (query >= 0) path.truncate(query);
+
+        if (method != "GET") {
+            respond(socket, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+        } else if (path == "/metrics") {
+            respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                    QByteArray::fromStdString(registry.renderPrometheus()));
+        } else if (path == "/") {
+            respond(socket, "200 OK", "text/plain", "IMU Visualizer metrics at /metrics\n");
+        } else {
+            respond(socket, "404 Not Found", "text/plain", "Not found\n");
+        }
+    }
+
+    void MetricsServer::respond(QTcpSocket* socket, const char* status, const char* contentType, const QByteArray& body) {
+        QByteArray response;
+        response += "HTTP/1.1 ";
+        response += status;
+        response += "\r\nContent-Type: ";
+        response += contentType;
+        response += "\r\nContent-Length: " + QByteArray::number(body.size());
+        response += "\r\nConnection: close\r\n\r\n";
+        response += body;
+
+        // Close once everything is written, one request per connection keeps this stateless
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_METRICS_SERVER_H
+#define IMU_VISUALIZER_METRICS_SERVER_H
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "core/metrics.h"
+
+namespace imu_viz {
+
+    /**
+     * Minimal HTTP/1.1 server for Prometheus scrapes, GET /metrics renders the registry.
+     * Bound to localhost only, put a reverse proxy in front to expose it further.
+     * Runs on the thread that owns it, a scrape only reads the collectors' atomics.
+     */
+    class MetricsServer : public QObject {
+        Q_OBJECT
+    public:
+        static constexpr quint16 DEFAULT_PORT = 9464;
+        static constexpr int MAX_REQUEST_BYTES = 8192;
+        static constexpr int REQUEST_TIMEOUT_MS = 5000;
+
+        explicit MetricsServer(const MetricsRegistry& registry, QObject* parent = nullptr);
+
+        bool start(quint16 port = DEFAULT_PORT);
+        void stop();
+        bool isListening() const { return server->isListening(); }
+        quint16 serverPort() const { return server->serverPort(); }
+        QString errorString() const { return server->errorString(); }
+
+    private slots:
+        void handleNewConnection();
+
+    private:
+        const MetricsRegistry& registry;
+        QTcpServer* server;
+
+        void handleRequest(QTcpSocket* socket, const QByteArray& request);
+        static void respond(QTcpSocket* socket, const char* status, const char* contentType, const QByteArray& body);
+    };
+}
+
+#endif //IMU_VISUALIZER_METRICS_SERVER_H
@@ -0,0 +1,47 @@
+//
+// Created by Raphael Russo on 12/07/24.
+//
+
+#include "calibration_store.h"
+
+#include <cctype>
+#include <filesystem>
+#include <system_error>
+
+namespace imu_viz {
+    CalibrationStore::CalibrationStore(std::string directory)
+            : directory(std::move(directory)) {}
+
+    bool CalibrationStore::load(const std::string& sensorId, CalibrationData& out) const {
+        return out.loadFromFile(profilePath(sensorId));
+    }
+
+    bool CalibrationStore::save(const std::string& sensorId, const CalibrationData& calibration) const {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) return false;
+
+        if (!calibration.saveToFile(profilePath(sensorId))) {
+            return false;
+        }
+
+        // Export is a convenience, the binary profile is what matters
+        std::filesystem::path text = std::filesystem::path(directory) / (fileStem(sensorId) + ".txt");
+        calibration.exportToText(text.string(), sensorId);
+        return true;
+    }
+
+    std::string CalibrationStore::profilePath(const std::string& sensorId) const {
+        return (std::filesystem::path(directory) / (fileStem(sensorId) + ".cal")).string();
+    }
+
+    std::string CalibrationStore::fileStem(const std::string& sensorId) {
+        std::string stem;
+        stem.reserve(sensorId.size());
+        for (char c : sensorId) {
+            bool safe = std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+            stem += safe ? c : '_';
+        }
+        return stem.empty() ? "default" : stem;
+    }
+}
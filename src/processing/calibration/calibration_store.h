@@ -0,0 +1,37 @@
+//
+// Created by Raphael Russo on 12/07/24.
+//
+
+#ifndef IMU_VISUALIZER_CALIBRATION_STORE_H
+#define IMU_VISUALIZER_CALIBRATION_STORE_H
+#pragma once
+
+#include "core/imu_data.h"
+#include <string>
+
+namespace imu_viz {
+
+    /**
+     * Calibration profiles on disk, one per sensor ID:
+     *   <directory>/<id>.cal  binary profile loaded at connect
+     *   <directory>/<id>.txt  human readable export, written alongside
+     */
+    class CalibrationStore {
+    public:
+        explicit CalibrationStore(std::string directory);
+
+        bool load(const std::string& sensorId, CalibrationData& out) const;
+        bool save(const std::string& sensorId, const CalibrationData& calibration) const;
+
+        std::string profilePath(const std::string& sensorId) const;
+        const std::string& getDirectory() const { return directory; }
+
+    private:
+        std::string directory;
+
+        // Sensor IDs come from addresses/port names, keep them filesystem safe
+        static std::string fileStem(const std::string& sensorId);
+    };
+}
+
+#endif //IMU_VISUALIZER_CALIBRATION_STORE_H
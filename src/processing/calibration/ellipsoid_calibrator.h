@@ -0,0 +1,185 @@
+//
+// Created by Raphael Russo on 12/05/24.
+//
+
+#ifndef IMU_VISUALIZER_ELLIPSOID_CALIBRATOR_H
+#define IMU_VISUALIZER_ELLIPSOID_CALIBRATOR_H
+#pragma once
+
+#include "core/imu_data.h"
+#include "running_statistics.h"
+#include "stationary_detector.h"
+#include <Eigen/Dense>
+#include <array>
+
+namespace imu_viz {
+
+    /**
+     * Multi-orientation accelerometer calibration.
+     *
+     * The operator holds the device still in a number of different orientations. Each stationary
+     * pose is averaged online and its mean is added to the least squares normal equations of the quadric
+     *   a x^2 + b y^2 + c z^2 + 2f yz + 2g xz + 2h xy + 2p x + 2q y + 2r z = 1
+     * so every sample is O(1) and no raw samples are kept. solve() turns the quadric into
+     * accelBias and a full 3x3 scale/misalignment matrix with |accelScale * (raw - accelBias)| = g.
+     * With fewer than FULL_FIT_POSES poses the cross terms aren't observable, so it falls back to
+     * an axis aligned ellipsoid (per axis scale only).
+     */
+    class EllipsoidCalibrator {
+    public:
+        static constexpr int AXIS_ALIGNED_POSES = 6;
+        static constexpr int FULL_FIT_POSES = 9;
+        static constexpr int MAX_POSES = 32;
+        static constexpr uint64_t MIN_POSE_SAMPLES = 100;
+        static constexpr double GRAVITY = 9.81;
+
+        // Poses closer than this to one already captured don't add information
+        static constexpr double MIN_POSE_SEPARATION_DEG = 20.0;
+
+        struct Result {
+            bool success{false};
+            bool fullFit{false};
+            double rmsResidual{0.0}; // m/s^2, | |calibrated pose mean| - g | over the captured poses
+        };
+
+        void reset() {
+            detector.reset();
+            poseStats.reset();
+            gyroStats.reset();
+            normalMatrix.setZero();
+            normalVector.setZero();
+            poseCount = 0;
+        }
+
+        // Returns true when this sample closed a new pose
+        bool addSample(const Vector3d& accel, const Vector3d& gyro) {
+            if (detector.update(accel, gyro)) {
+                poseStats.add(accel);
+                gyroStats.add(gyro);
+                return false;
+            }
+            return closePose();
+        }
+
+        // Also called from finish so a pose held until the operator stops still counts
+        bool closePose() {
+            if (poseStats.count() < MIN_POSE_SAMPLES) {
+                poseStats.reset();
+                return false;
+            }
+
+            Vector3d mean = poseStats.getMean();
+            poseStats.reset();
+            if (poseCount >= MAX_POSES || !isNewPose(mean)) {
+                return false;
+            }
+
+            poses[poseCount++] = mean;
+            Vector9 d = designRow(mean / GRAVITY);
+            normalMatrix.noalias() += d * d.transpose();
+            normalVector += d;
+            return true;
+        }
+
+        int getPoseCount() const { return poseCount; }
+        bool isStationary() const { return detector.isStationary(); }
+
+        Result solve(CalibrationData& out) const {
+            Result result;
+            if (poseCount < AXIS_ALIGNED_POSES) return result;
+
+            Vector9 theta = Vector9::Zero();
+            if (poseCount >= FULL_FIT_POSES) {
+                theta = normalMatrix.ldlt().solve(normalVector);
+                result.fullFit = true;
+            } else {
+                // Only x^2, y^2, z^2 and the linear terms
+                const int idx[6] = {0, 1, 2, 6, 7, 8};
+                Eigen::Matrix<double, 6, 6> n;
+                Eigen::Matrix<double, 6, 1> r;
+                for (int i = 0; i < 6; ++i) {
+                    r(i) = normalVector(idx[i]);
+                    for (int j = 0; j < 6; ++j) {
+                        n(i, j) = normalMatrix(idx[i], idx[j]);
+                    }
+                }
+                Eigen::Matrix<double, 6, 1> sub = n.ldlt().solve(r);
+                for (int i = 0; i < 6; ++i) {
+                    theta(idx[i]) = sub(i);
+                }
+            }
+            if (!theta.allFinite()) return result;
+
+            Matrix3d m;
+            m << theta(0), theta(5), theta(4),
+                 theta(5), theta(1), theta(3),
+                 theta(4), theta(3), theta(2);
+            Vector3d v(theta(6), theta(7), theta(8));
+
+            // Complete the square: (x - c)^T M (x - c) = 1 + c^T M c
+            Vector3d center = -m.ldlt().solve(v);
+            double k = 1.0 + center.dot(m * center);
+            if (!(k > 0.0)) return result;
+
+            Eigen::SelfAdjointEigenSolver<Matrix3d> eigen(m / k);
+            if (eigen.info() != Eigen::Success || eigen.eigenvalues().minCoeff() <= 0.0) {
+                return result; // Not an ellipsoid, poses were probably too similar
+            }
+
+            // Symmetric square root maps the ellipsoid onto the unit sphere without adding a rotation
+            Matrix3d scale = eigen.eigenvectors() *
+                             eigen.eigenvalues().cwiseSqrt().asDiagonal() *
+                             eigen.eigenvectors().transpose();
+
+            out.accelBias = center * GRAVITY;
+            out.accelScale = scale;
+            out.gyroBias = gyroStats.getMean();
+            out.gyroScale = Matrix3d::Identity();
+
+            double residualSq = 0.0;
+            for (int i = 0; i < poseCount; ++i) {
+                double err = (scale * (poses[i] - out.accelBias)).norm() - GRAVITY;
+                residualSq += err * err;
+            }
+            result.rmsResidual = std::sqrt(residualSq / poseCount);
+            result.success = true;
+            return result;
+        }
+
+    private:
+        using Vector9 = Eigen::Matrix<double, 9, 1>;
+        using Matrix9 = Eigen::Matrix<double, 9, 9>;
+
+        StationaryDetector detector;
+        RunningStatistics poseStats;
+        RunningStatistics gyroStats; // Every stationary sample, gives the gyro bias for free
+
+        Matrix9 normalMatrix{Matrix9::Zero()};
+        Vector9 normalVector{Vector9::Zero()};
+
+        // Pose means are kept only to reject duplicates and report the residual
+        std::array<Vector3d, MAX_POSES> poses;
+        int poseCount{0};
+
+        static Vector9 designRow(const Vector3d& p) {
+            Vector9 d;
+            d << p.x() * p.x(), p.y() * p.y(), p.z() * p.z(),
+                 2 * p.y() * p.z(), 2 * p.x() * p.z(), 2 * p.x() * p.y(),
+                 2 * p.x(), 2 * p.y(), 2 * p.z();
+            return d;
+        }
+
+        bool isNewPose(const Vector3d& mean) const {
+            const double minCos = std::cos(MIN_POSE_SEPARATION_DEG * M_PI / 180.0);
+            Vector3d direction = mean.normalized();
+            for (int i = 0; i < poseCount; ++i) {
+                if (direction.dot(poses[i].normalized()) > minCos) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_ELLIPSOID_CALIBRATOR_H
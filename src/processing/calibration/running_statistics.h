@@ -0,0 +1,61 @@
+//
+// Created by Raphael Russo on 12/04/24.
+//
+
+#ifndef IMU_VISUALIZER_RUNNING_STATISTICS_H
+#define IMU_VISUALIZER_RUNNING_STATISTICS_H
+#pragma once
+
+#include "imu_visualizer/common.h"
+#include <cstdint>
+#include <limits>
+
+namespace imu_viz {
+
+    /**
+     * Streaming mean and covariance of 3D samples (Welford's algorithm).
+     * O(1) memory and numerically stable for millions of samples, unlike summing x and x^2.
+     */
+    class RunningStatistics {
+    public:
+        void add(const Vector3d& x) {
+            ++n;
+            Vector3d delta = x - mean;
+            mean += delta / static_cast<double>(n);
+            // Uses the updated mean on one side, this is what keeps it stable
+            m2.noalias() += delta * (x - mean).transpose();
+        }
+
+        void reset() {
+            n = 0;
+            mean.setZero();
+            m2.setZero();
+        }
+
+        uint64_t count() const { return n; }
+        const Vector3d& getMean() const { return mean; }
+
+        // Unbiased sample covariance
+        Matrix3d covariance() const {
+            if (n < 2) return Matrix3d::Zero();
+            return m2 / static_cast<double>(n - 1);
+        }
+
+        Vector3d variance() const {
+            return covariance().diagonal();
+        }
+
+        // Standard error of the mean per axis, shrinks as 1/sqrt(n) for a stationary signal
+        Vector3d standardError() const {
+            if (n < 2) return Vector3d::Constant(std::numeric_limits<double>::infinity());
+            return (variance() / static_cast<double>(n)).cwiseSqrt();
+        }
+
+    private:
+        uint64_t n{0};
+        Vector3d mean{Vector3d::Zero()};
+        Matrix3d m2{Matrix3d::Zero()};
+    };
+}
+
+#endif //IMU_VISUALIZER_RUNNING_STATISTICS_H
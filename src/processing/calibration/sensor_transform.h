@@ -0,0 +1,85 @@
+//
+// Created by Raphael Russo on 12/06/24.
+//
+
+#ifndef IMU_VISUALIZER_SENSOR_TRANSFORM_H
+#define IMU_VISUALIZER_SENSOR_TRANSFORM_H
+#pragma once
+
+#include "core/imu_data.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstddef>
+
+namespace imu_viz {
+
+    /**
+     * y = linear * x + offset
+     * Bias, scale/misalignment, axis remapping and unit scaling all fold into one of these,
+     * so the hot path is a single 3x3 multiply-add per sensor whatever the calibration is.
+     */
+    struct AffineTransform {
+        Matrix3d linear{Matrix3d::Identity()};
+        Vector3d offset{Vector3d::Zero()};
+
+        Vector3d apply(const Vector3d& x) const {
+            return linear * x + offset;
+        }
+
+        /**
+         * Applies the transform to `count` samples stored as separate x/y/z arrays (may alias the outputs).
+         * Each output lane is a plain multiply-add over contiguous doubles, which Eigen vectorises.
+         */
+        void applyBatch(const double* x, const double* y, const double* z,
+                        double* outX, double* outY, double* outZ, size_t count) const {
+            // Chunked through fixed capacity temporaries so aliasing is safe and nothing touches the heap
+            constexpr Eigen::Index CHUNK = 64;
+            using Chunk = Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, CHUNK, 1>;
+            using ConstMap = Eigen::Map<const Eigen::ArrayXd>;
+            using Map = Eigen::Map<Eigen::ArrayXd>;
+
+            for (size_t start = 0; start < count; start += CHUNK) {
+                const Eigen::Index n = static_cast<Eigen::Index>(std::min<size_t>(CHUNK, count - start));
+                ConstMap inX(x + start, n), inY(y + start, n), inZ(z + start, n);
+
+                Chunk rx = linear(0, 0) * inX + linear(0, 1) * inY + linear(0, 2) * inZ + offset(0);
+                Chunk ry = linear(1, 0) * inX + linear(1, 1) * inY + linear(1, 2) * inZ + offset(1);
+                Chunk rz = linear(2, 0) * inX + linear(2, 1) * inY + linear(2, 2) * inZ + offset(2);
+
+                Map(outX + start, n) = rx;
+                Map(outY + start, n) = ry;
+                Map(outZ + start, n) = rz;
+            }
+        }
+
+        /**
+         * Builds unitScale * axisMapping * scale * (raw - bias).
+         * Calibration is estimated on the raw sensor frame, so bias and scale apply before the remap.
+         */
+        static AffineTransform compose(const Vector3d& bias, const Matrix3d& scale,
+                                       const Matrix3d& axisMapping, double unitScale) {
+            AffineTransform t;
+            t.linear = unitScale * axisMapping * scale;
+            t.offset = -(t.linear * bias);
+            return t;
+        }
+    };
+
+    // One transform per sensor, rebuilt only when calibration or mapping changes
+    struct SensorTransforms {
+        AffineTransform accel;
+        AffineTransform gyro;
+
+        static SensorTransforms build(const CalibrationData& calibration, const Matrix3d& axisMapping,
+                                      double accelUnitScale, double gyroUnitScale) {
+            SensorTransforms t;
+            t.accel = AffineTransform::compose(calibration.accelBias, calibration.accelScale,
+                                               axisMapping, accelUnitScale);
+            t.gyro = AffineTransform::compose(calibration.gyroBias, calibration.gyroScale,
+                                              axisMapping, gyroUnitScale);
+            return t;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_SENSOR_TRANSFORM_H
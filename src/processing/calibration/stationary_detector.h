@@ -0,0 +1,70 @@
+//
+// Created by Raphael Russo on 12/05/24.
+//
+
+#ifndef IMU_VISUALIZER_STATIONARY_DETECTOR_H
+#define IMU_VISUALIZER_STATIONARY_DETECTOR_H
+#pragma once
+
+#include "imu_visualizer/common.h"
+#include <cstdint>
+
+namespace imu_viz {
+
+    /**
+     * Decides whether the device is being held still, O(1) per sample.
+     * Tracks an exponential moving mean/variance of the accelerometer and the gyro magnitude,
+     * and only reports stationary once both have been quiet for holdSamples in a row.
+     */
+    class StationaryDetector {
+    public:
+        explicit StationaryDetector(double accelStdThreshold = 0.15,  // m/s^2
+                                    double gyroThreshold = 0.05,      // rad/s
+                                    uint32_t holdSamples = 50,
+                                    double smoothing = 0.1)
+                : accelStdThreshold(accelStdThreshold)
+                , gyroThreshold(gyroThreshold)
+                , holdSamples(holdSamples)
+                , smoothing(smoothing) {}
+
+        bool update(const Vector3d& accel, const Vector3d& gyro) {
+            if (!initialized) {
+                accelMean = accel;
+                accelVariance = 0.0;
+                gyroMagnitude = gyro.norm();
+                initialized = true;
+            } else {
+                Vector3d delta = accel - accelMean;
+                accelMean += smoothing * delta;
+                accelVariance = (1.0 - smoothing) * (accelVariance + smoothing * delta.squaredNorm());
+                gyroMagnitude += smoothing * (gyro.norm() - gyroMagnitude);
+            }
+
+            bool quiet = accelVariance < accelStdThreshold * accelStdThreshold &&
+                         gyroMagnitude < gyroThreshold;
+            quietSamples = quiet ? quietSamples + 1 : 0;
+            return isStationary();
+        }
+
+        bool isStationary() const { return quietSamples >= holdSamples; }
+
+        void reset() {
+            initialized = false;
+            quietSamples = 0;
+        }
+
+    private:
+        double accelStdThreshold;
+        double gyroThreshold;
+        uint32_t holdSamples;
+        double smoothing;
+
+        bool initialized{false};
+        Vector3d accelMean{Vector3d::Zero()};
+        double accelVariance{0.0};
+        double gyroMagnitude{0.0};
+        uint32_t quietSamples{0};
+    };
+}
+
+#endif //IMU_VISUALIZER_STATIONARY_DETECTOR_H
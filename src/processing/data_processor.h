@@ -6,15 +6,20 @@
 #define IMU_VISUALIZER_DATA_PROCESSOR_H
 
 #pragma once
-#include "core/imu_data.h"
+#include "fusion_engine.h"
+#include "imu_visualizer/metatypes.h"
 #include <QObject>
-#include <deque>
-#include "filters/orientation_filter.h"
-#include "filters/filter_factory.h"
+#include <QString>
+
+class QTimer;
 
 namespace imu_viz {
 
-    class DataProcessor : public QObject {
+    /**
+     * FusionEngine on the Qt event loop: its periodic work runs on QTimers and its callbacks are
+     * re-emitted as signals. Everything else is the engine's own API.
+     */
+    class DataProcessor : public QObject, public FusionEngine {
     Q_OBJECT
 
     public:
@@ -23,44 +28,20 @@ namespace imu_viz {
         ~DataProcessor() override = default;
         DataProcessor(const DataProcessor&) = delete;
 
-
-        void setFilterType(OrientationFilterFactory::FilterType type);
-        void setCalibrationData(const CalibrationData &calibration);
-
-    public slots:
-        void processIMUData(const IMUData &data);
-        void startCalibration();
-        void finishCalibration();
-        void resetOrientation();
-        void updateCalibration(const IMUData& data);
-
     signals:
-        Q_SIGNAL void newOrientation(const Quaterniond &orientation);
+        Q_SIGNAL void newOrientation(const OrientationSample &sample);
         Q_SIGNAL void newCalibrationData(const CalibrationData &calibration);
+        Q_SIGNAL void calibrationProgress(quint64 samples, double accelStdError, double gyroStdError, bool converged);
+        Q_SIGNAL void calibrationPoseProgress(int poses, int requiredPoses, bool stationary);
+        Q_SIGNAL void calibrationFitQuality(double rmsResidual, bool fullFit);
         Q_SIGNAL void errorOccurred(const QString &error);
+        Q_SIGNAL void errorSummary(const QString &summary);
 
     private:
-        static constexpr size_t CALIBRATION_SAMPLES = 1000;
-        static constexpr double MIN_TIMESTAMP_DELTA = 0.001; // 1ms minimum between samples
-
-        std::unique_ptr<IOrientationFilter> filter;
-        CalibrationData calibration;
-        bool isCalibrating{false};
-        uint64_t lastTimestamp{0};
-
-        // Mutex for thread safety
-        mutable std::mutex dataMutex;
-
-        // Calibration buffers
-        std::deque<Vector3d> accelBuffer;
-        std::deque<Vector3d> gyroBuffer;
-
-        Vector3d applyCalibration(const Vector3d &raw,
-                                  const Vector3d &bias,
-                                  const Matrix3d &scale) const;
-
-        bool validateIMUData(const IMUData& data) const;
-        void updateOrientation(const Vector3d& accel, const Vector3d& gyro, double deltaTime);
+        QTimer* playoutTimer;
+        QTimer* concealmentTimer;
+        QTimer* ingestTimer;
+        QTimer* errorReportTimer;
     };
 }
 
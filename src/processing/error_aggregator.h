@@ -0,0 +1,103 @@
+//
+// Created by Raphael Russo on 12/16/24.
+//
+
+#ifndef IMU_VISUALIZER_ERROR_AGGREGATOR_H
+#define IMU_VISUALIZER_ERROR_AGGREGATOR_H
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace imu_viz {
+
+    enum class ErrorCategory {
+        NON_FINITE_SAMPLE,
+        ACCEL_OUT_OF_RANGE,
+        GYRO_OUT_OF_RANGE,
+        FILTER_EXCEPTION,
+        INGEST_OVERFLOW,
+        TRANSPORT,
+        COUNT
+    };
+
+    /**
+     * Counts faults where they happen and reports them in batches.
+     * record() is a relaxed atomic increment so the data path never waits on, allocates for, or
+     * signals about an error; whoever owns the report interval calls takeSummary() to turn the
+     * counts since the last call into "1532 out-of-range accel samples" style lines.
+     */
+    class ErrorAggregator {
+    public:
+        struct Entry {
+            ErrorCategory category;
+            uint64_t count;
+            std::string detail; // Latest message for categories that carry one
+        };
+
+        void record(ErrorCategory category) {
+            window[index(category)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // For rare faults with a message worth showing, keeps the latest one
+        void record(ErrorCategory category, const std::string& detail) {
+            {
+                std::lock_guard<std::mutex> lock(detailMutex);
+                details[index(category)] = detail;
+            }
+            record(category);
+        }
+
+        // Counts since the last call, non-zero categories only
+        std::vector<Entry> takeSummary() {
+            std::vector<Entry> summary;
+            for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+                const uint64_t count = window[i].exchange(0, std::memory_order_relaxed);
+                if (count == 0) continue;
+                totals[i].fetch_add(count, std::memory_order_relaxed);
+
+                std::lock_guard<std::mutex> lock(detailMutex);
+                summary.push_back({static_cast<ErrorCategory>(i), count, details[i]});
+            }
+            return summary;
+        }
+
+        // Everything recorded so far, reported or not
+        uint64_t getTotal(ErrorCategory category) const {
+            const size_t i = index(category);
+            return totals[i].load(std::memory_order_relaxed) + window[i].load(std::memory_order_relaxed);
+        }
+
+        static const char* describe(ErrorCategory category) {
+            switch (category) {
+                case ErrorCategory::NON_FINITE_SAMPLE: return "non-finite samples";
+                case ErrorCategory::ACCEL_OUT_OF_RANGE: return "out-of-range accel samples";
+                case ErrorCategory::GYRO_OUT_OF_RANGE: return "out-of-range gyro samples";
+                case ErrorCategory::FILTER_EXCEPTION: return "orientation update errors";
+                case ErrorCategory::INGEST_OVERFLOW: return "samples dropped at hand off";
+                case ErrorCategory::TRANSPORT: return "transport errors";
+                default: return "errors";
+            }
+        }
+
+    private:
+        static constexpr size_t CATEGORY_COUNT = static_cast<size_t>(ErrorCategory::COUNT);
+
+        std::array<std::atomic<uint64_t>, CATEGORY_COUNT> window{};
+        std::array<std::atomic<uint64_t>, CATEGORY_COUNT> totals{};
+
+        std::mutex detailMutex;
+        std::array<std::string, CATEGORY_COUNT> details;
+
+        static size_t index(ErrorCategory category) {
+            return static_cast<size_t>(category);
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_ERROR_AGGREGATOR_H
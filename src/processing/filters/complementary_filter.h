@@ -13,6 +13,8 @@ namespace imu_viz {
                 : accelweight(accelWeight), currentOrientation(Quaterniond::Identity()) {}
 
         void update(const Vector3d &accel, const Vector3d &gyro, double dt) override {
+            IMU_PROFILE_ZONE("ComplementaryFilter::update");
+
             // Gyroscope integration
             Vector3d gyroRad = gyro * dt;
             double angle = gyroRad.norm();
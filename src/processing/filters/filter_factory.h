@@ -7,6 +7,8 @@
 #include "complementary_filter.h"
 #include "madgwick_filter.h"
 #include "kalman_filter.h"
+#include <memory>
+#include <stdexcept>
 namespace imu_viz {
     class OrientationFilterFactory {
     public:
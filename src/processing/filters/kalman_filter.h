@@ -17,6 +17,7 @@ namespace imu_viz {
         }
 
         void update(const Vector3d& accel, const Vector3d& gyro, double dt) override {
+            IMU_PROFILE_ZONE("KalmanFilter::update");
             predict(gyro, dt);
             correct(accel);
         }
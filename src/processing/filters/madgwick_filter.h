@@ -13,6 +13,7 @@ namespace imu_viz {
                 : beta(beta), currentOrientation(Quaterniond::Identity()) {}
 
         void update(const Vector3d &accel, const Vector3d &gyro, double dt) override {
+            IMU_PROFILE_ZONE("MadgwickFilter::update");
             double q0 = currentOrientation.w();
             double q1 = currentOrientation.x();
             double q2 = currentOrientation.y();
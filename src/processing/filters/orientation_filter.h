@@ -7,6 +7,7 @@
 #pragma once
 #include <Eigen/Geometry>
 #include "imu_visualizer/common.h"
+#include "core/profiler.h"
 
 namespace imu_viz {
 
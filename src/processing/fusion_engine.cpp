@@ -0,0 +1,634 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#include "fusion_engine.h"
+#include "core/clock.h"
+#include "core/profiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <stdexcept>
+
+namespace imu_viz {
+    FusionEngine::FusionEngine()
+            : filter(OrientationFilterFactory::createFilter(
+                    OrientationFilterFactory::FilterType::KALMAN))
+            , smoother(OutputSmootherFactory::createSmoother(
+                    OutputSmootherFactory::SmootherType::FIXED_SLERP))
+    {
+        if (!filter) {
+            throw std::runtime_error("Failed to create orientation filter");
+        }
+        rebuildTransforms();
+
+        if (!setPipelineConfig(DEFAULT_PIPELINE_CONFIG)) {
+            throw std::runtime_error("Failed to build the default processing pipeline");
+        }
+    }
+
+    bool FusionEngine::setPipelineConfig(const std::string& config) {
+        std::unique_ptr<Pipeline> next;
+        try {
+            next = buildPipeline(config);
+        } catch (const std::exception& e) {
+            // Malformed, or the queues couldn't be allocated. Either way the running pipeline stays
+            notify(callbacks.error, std::string("Pipeline config: ") + e.what());
+            return false;
+        }
+
+        // Let the old workers finish their queued frames first, two pipelines must never share the filter.
+        // Not under dataMutex, the workers take it
+        if (pipeline) {
+            pipeline->stop();
+        }
+        next->start();
+        pipeline = std::move(next);
+        pipelineConfig = config;
+        return true;
+    }
+
+    std::string FusionEngine::getPipelineConfig() const {
+        return pipelineConfig;
+    }
+
+    std::vector<StageStats> FusionEngine::getPipelineStats() const {
+        return pipeline->getStats();
+    }
+
+    std::unique_ptr<Pipeline> FusionEngine::buildPipeline(const std::string& config) {
+        // Each stage reads what the one before it wrote, so these keep their order
+        static constexpr std::array<const char*, 6> CORE_ORDER = {
+                "validate", "calibrate", "resample", "filter", "smooth", "publish"};
+        static constexpr std::array<const char*, 4> REQUIRED = {"calibrate", "resample", "filter", "publish"};
+
+        const std::vector<StageSpec> specs = Pipeline::parseConfig(config);
+        auto next = std::make_unique<Pipeline>(&dataMutex);
+
+        int lastCore = -1;
+        for (const auto& spec : specs) {
+            const auto core = std::find_if(CORE_ORDER.begin(), CORE_ORDER.end(),
+                                           [&spec](const char* name) { return spec.name == name; });
+            if (core != CORE_ORDER.end()) {
+                const int position = static_cast<int>(core - CORE_ORDER.begin());
+                if (position < lastCore) {
+                    throw std::invalid_argument("Stage '" + spec.name + "' is out of order");
+                }
+                lastCore = position;
+            }
+
+            bool usesSharedState = false;
+            auto stage = createStage(spec.name, usesSharedState);
+            if (!stage) {
+                throw std::invalid_argument("Unknown stage '" + spec.name + "'");
+            }
+            next->addStage(std::move(stage), spec.mode, spec.capacity, usesSharedState);
+        }
+
+        for (const char* name : REQUIRED) {
+            if (next->findStage(name) < 0) {
+                throw std::invalid_argument(std::string("Missing stage '") + name + "'");
+            }
+        }
+        return next;
+    }
+
+    std::unique_ptr<IStage> FusionEngine::createStage(const std::string& name, bool& usesSharedState) {
+        // Only validate and metrics can run without dataMutex, the rest read or write processor state
+        usesSharedState = true;
+        if (name == "validate") {
+            usesSharedState = false;
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) {
+                ErrorCategory fault;
+                if (!validateIMUData(frame.sample, fault)) {
+                    errors.record(fault);
+                    return false;
+                }
+                return true;
+            });
+        }
+        if (name == "calibrate") {
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) { return calibrateStage(frame); });
+        }
+        if (name == "resample") {
+            // Samples it holds back are merged into a later window, never dropped
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) {
+                return resampler.add(frame.sample.timestamp, frame.sample.acceleration,
+                                     frame.sample.gyroscope, frame.window);
+            });
+        }
+        if (name == "filter") {
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) { return filterStage(frame); });
+        }
+        if (name == "smooth") {
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) { return smoothStage(frame); });
+        }
+        if (name == "publish") {
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) { return publishStage(frame); });
+        }
+        if (name == "metrics") {
+            usesSharedState = false;
+            return std::make_unique<FunctionStage>(name, [this](PipelineFrame& frame) { return metricsStage(frame); });
+        }
+        return nullptr;
+    }
+
+    void FusionEngine::setFilterType(OrientationFilterFactory::FilterType type) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        auto newFilter = OrientationFilterFactory::createFilter(type);
+        if (!newFilter) {
+            notify(callbacks.error, std::string("Failed to create new filter"));
+            return;
+        }
+        filter = std::move(newFilter);
+
+        // Don't blend the old filter's estimate into the new one
+        smoother->reset();
+    }
+
+    void FusionEngine::setSmootherType(OutputSmootherFactory::SmootherType type) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        smoother = OutputSmootherFactory::createSmoother(type);
+    }
+
+    double FusionEngine::smoothingLatencyMs() const {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return smoother->addedLatencyMs();
+    }
+
+
+    void FusionEngine::submitIMUData(const IMUData& data) {
+        if (!submitted.tryPush(data)) {
+            errors.record(ErrorCategory::INGEST_OVERFLOW);
+        }
+    }
+
+    void FusionEngine::drainSubmitted() {
+        std::array<IMUData, BATCH_CAPACITY> chunk;
+        for (;;) {
+            // Checked per chunk, the buffer can be switched on while the ring is being drained
+            if (jitterBufferEnabled.load(std::memory_order_relaxed)) {
+                IMUData data;
+                while (submitted.tryPop(data)) {
+                    processIMUData(data);
+                }
+                return;
+            }
+
+            size_t n = 0;
+            while (n < chunk.size() && submitted.tryPop(chunk[n])) ++n;
+            if (n == 0) return;
+            processIMUBatch(chunk.data(), n);
+        }
+    }
+
+    void FusionEngine::processIMUData(const IMUData& data) {
+        IMU_PROFILE_ZONE("FusionEngine::processIMUData");
+        if (jitterBufferEnabled.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(dataMutex);
+            jitterBuffer.push(data, data.arrivalTimeNs != 0 ? data.arrivalTimeNs : steadyNowNs());
+            return; // releaseBufferedSamples picks it up at its playout time
+        }
+        ingest(data);
+    }
+
+    void FusionEngine::ingest(const IMUData& data) {
+        // Without dataMutex, the pipeline takes it for the stages that need it
+        PipelineFrame frame;
+        frame.sample = data;
+        pipeline->push(frame);
+
+        if (historyEnabled[static_cast<size_t>(HistoryTap::PLOT)].load(std::memory_order_relaxed)) {
+            sampleHistory.tryPush(data);
+        }
+    }
+
+    void FusionEngine::releaseBufferedSamples() {
+        if (!jitterBufferEnabled.load(std::memory_order_relaxed)) return;
+
+        playOut(steadyNowNs());
+    }
+
+    void FusionEngine::playOut(int64_t nowNs) {
+        std::array<IMUData, BATCH_CAPACITY> chunk;
+        for (;;) {
+            size_t n = 0;
+            {
+                std::lock_guard<std::mutex> lock(dataMutex);
+                while (n < chunk.size() && jitterBuffer.pop(nowNs, chunk[n])) ++n;
+            }
+            if (n == 0) return;
+            processIMUBatch(chunk.data(), n);
+        }
+    }
+
+    void FusionEngine::setJitterBufferEnabled(bool enabled) {
+        if (enabled == jitterBufferEnabled.load()) return;
+
+        if (enabled) {
+            {
+                std::lock_guard<std::mutex> lock(dataMutex);
+                jitterBuffer.reset();
+            }
+            jitterBufferEnabled = true;
+        } else {
+            jitterBufferEnabled = false;
+            // Play out whatever is still held rather than lose it
+            playOut(INT64_MAX);
+        }
+    }
+
+    void FusionEngine::concealGap() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        // Samples still queued at the disconnect may publish after it, they don't start a gap
+        if (streamStopped) return;
+
+        OrientationSample sample;
+        if (gapConcealer.conceal(steadyNowNs(), sample)) {
+            publish(sample);
+        }
+    }
+
+    GapConcealer::Stats FusionEngine::getGapStats() const {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return gapConcealer.getStats();
+    }
+
+    JitterBuffer::Stats FusionEngine::getJitterBufferStats() const {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return jitterBuffer.getStats();
+    }
+
+    void FusionEngine::processIMUBatch(const IMUData* samples, size_t count) {
+        // Validation and calibration are done here for the whole batch, frames join the pipeline after them.
+        // Any other stage ahead of resample would be skipped, so such a config takes the per sample path
+        const int entry = pipeline->findStage("resample");
+        if (pipeline->findStage("validate") != 0 || pipeline->findStage("calibrate") != 1 || entry != 2) {
+            for (size_t i = 0; i < count; ++i) {
+                ingest(samples[i]);
+            }
+            return;
+        }
+        std::array<PipelineFrame, BATCH_CAPACITY> frames;
+
+        for (size_t start = 0; start < count; start += BATCH_CAPACITY) {
+            const size_t end = std::min(count, start + BATCH_CAPACITY);
+
+            // Same raw tap as ingest(), before validation and calibration
+            if (historyEnabled[static_cast<size_t>(HistoryTap::PLOT)].load(std::memory_order_relaxed)) {
+                for (size_t i = start; i < end; ++i) {
+                    sampleHistory.tryPush(samples[i]);
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(dataMutex);
+
+            // Gather valid samples into x/y/z lanes
+            size_t n = 0;
+            for (size_t i = start; i < end; ++i) {
+                const IMUData& data = samples[i];
+                ErrorCategory fault;
+                if (!validateIMUData(data, fault)) {
+                    errors.record(fault);
+                    continue;
+                }
+                accumulateCalibration(data);
+
+                // The array is reused across chunks: the whole sample with its own stamps, and no output
+                // or step left from an earlier frame. window is written by resample before anything reads it
+                frames[n].sample = data;
+                frames[n].deltaTime = 0.0;
+                frames[n].output = OrientationSample{};
+                batch.ax[n] = data.acceleration.x();
+                batch.ay[n] = data.acceleration.y();
+                batch.az[n] = data.acceleration.z();
+                batch.gx[n] = data.gyroscope.x();
+                batch.gy[n] = data.gyroscope.y();
+                batch.gz[n] = data.gyroscope.z();
+                ++n;
+            }
+
+            // Calibrate the whole batch in place
+            transforms.accel.applyBatch(batch.ax.data(), batch.ay.data(), batch.az.data(),
+                                        batch.ax.data(), batch.ay.data(), batch.az.data(), n);
+            transforms.gyro.applyBatch(batch.gx.data(), batch.gy.data(), batch.gz.data(),
+                                       batch.gx.data(), batch.gy.data(), batch.gz.data(), n);
+
+            for (size_t i = 0; i < n; ++i) {
+                frames[i].sample.acceleration = Vector3d(batch.ax[i], batch.ay[i], batch.az[i]);
+                frames[i].sample.gyroscope = Vector3d(batch.gx[i], batch.gy[i], batch.gz[i]);
+            }
+            lock.unlock();
+
+            for (size_t i = 0; i < n; ++i) {
+                pipeline->push(frames[i], static_cast<size_t>(entry));
+            }
+        }
+    }
+
+    bool FusionEngine::calibrateStage(PipelineFrame& frame) {
+        // Calibration sees the raw stream while the operator holds the device still
+        accumulateCalibration(frame.sample);
+
+        frame.sample.acceleration = transforms.accel.apply(frame.sample.acceleration);
+        frame.sample.gyroscope = transforms.gyro.apply(frame.sample.gyroscope);
+        return true;
+    }
+
+    bool FusionEngine::filterStage(PipelineFrame& frame) {
+        if (!filter) return false;
+
+        try {
+            // After a dropout only integrate a few periods, the motion in the gap is unknown
+            frame.deltaTime = gapConcealer.clampDeltaTime(frame.window.deltaTime);
+
+            // Update orientation using calibrated, scaled values
+            filter->update(frame.window.acceleration, frame.window.gyroscope, frame.deltaTime);
+        } catch (const std::exception& e) {
+            errors.record(ErrorCategory::FILTER_EXCEPTION, e.what());
+            return false;
+        }
+
+        frame.output.orientation = filter->getOrientation();
+        frame.output.angularVelocity = frame.window.gyroscope;
+        frame.output.timestamp = frame.window.timestamp;
+        frame.output.arrivalTimeNs = frame.sample.arrivalTimeNs;
+        frame.output.decodeTimeNs = frame.sample.decodeTimeNs;
+        frame.output.smoothingLatencyMs = 0.0;
+        return true;
+    }
+
+    bool FusionEngine::smoothStage(PipelineFrame& frame) {
+        // Smooth the filtered orientation for display, the renderer extrapolates from here
+        frame.output.orientation = smoother->update(frame.output.orientation, frame.deltaTime);
+        frame.output.smoothingLatencyMs = smoother->addedLatencyMs();
+        return true;
+    }
+
+    bool FusionEngine::publishStage(PipelineFrame& frame) {
+        frame.output.publishTimeNs = steadyNowNs();
+        publish(gapConcealer.onSample(frame.output, frame.window.deltaTime));
+        return true;
+    }
+
+    bool FusionEngine::metricsStage(PipelineFrame& frame) {
+        const IMUData& sample = frame.sample;
+        if (sample.arrivalTimeNs == 0 || sample.decodeTimeNs == 0) return true; // Batch or replay, no transport stamps
+
+        latency.record(LatencyStage::DECODE, sample.decodeTimeNs - sample.arrivalTimeNs);
+
+        // Placed before publish there is no publish time yet
+        if (frame.output.publishTimeNs != 0) {
+            latency.record(LatencyStage::PROCESS, frame.output.publishTimeNs - sample.decodeTimeNs);
+        }
+        return true;
+    }
+
+    void FusionEngine::setFilterRate(double hz) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        resampler.setOutputRate(hz);
+    }
+
+    ResamplerStats FusionEngine::getResamplerStats() const {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return resampler.getStats();
+    }
+
+    void FusionEngine::publish(const OrientationSample& sample) {
+        // The renderer picks up the newest once per frame, the callback is for everything else
+        latestOrientation.write(sample);
+        for (size_t tap = 0; tap < HISTORY_TAP_COUNT; ++tap) {
+            if (historyEnabled[tap].load(std::memory_order_relaxed)) orientationHistory[tap].tryPush(sample);
+        }
+        notify(callbacks.orientation, sample);
+    }
+
+    void FusionEngine::setAxisMapping(const Matrix3d& mapping) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        axisMapping = mapping;
+        rebuildTransforms();
+    }
+
+    void FusionEngine::rebuildTransforms() {
+        transforms = SensorTransforms::build(calibration, axisMapping, ACCEL_UNIT_SCALE, GYRO_UNIT_SCALE);
+    }
+
+    void FusionEngine::startCalibration() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        isCalibrating = true;
+        accelStats.reset();
+        gyroStats.reset();
+        ellipsoidCalibrator.reset();
+        wasStationary = false;
+    }
+
+    void FusionEngine::setCalibrationMode(CalibrationMode mode) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        calibrationMode = mode;
+    }
+
+    void FusionEngine::updateCalibration(const IMUData& data) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        accumulateCalibration(data);
+    }
+
+    void FusionEngine::accumulateCalibration(const IMUData& data) {
+        if (!isCalibrating) return;
+
+        if (calibrationMode == CalibrationMode::MULTI_POSE) {
+            bool newPose = ellipsoidCalibrator.addSample(data.acceleration, data.gyroscope);
+            bool stationary = ellipsoidCalibrator.isStationary();
+            if (newPose || stationary != wasStationary) {
+                wasStationary = stationary;
+                notify(callbacks.calibrationPoseProgress, ellipsoidCalibrator.getPoseCount(),
+                       EllipsoidCalibrator::FULL_FIT_POSES, stationary);
+            }
+            return;
+        }
+
+        accelStats.add(data.acceleration);
+        gyroStats.add(data.gyroscope);
+
+        // Report convergence so the operator knows when the window is long enough
+        const uint64_t samples = accelStats.count();
+        if (samples % CALIBRATION_PROGRESS_INTERVAL == 0) {
+            const double accelError = accelStats.standardError().maxCoeff();
+            const double gyroError = gyroStats.standardError().maxCoeff();
+            const bool converged = samples >= MIN_CALIBRATION_SAMPLES &&
+                                   accelError < ACCEL_CONVERGED_STD_ERROR &&
+                                   gyroError < GYRO_CONVERGED_STD_ERROR;
+            notify(callbacks.calibrationProgress, samples, accelError, gyroError, converged);
+        }
+    }
+
+    void FusionEngine::finishCalibration() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+
+        if (calibrationMode == CalibrationMode::MULTI_POSE) {
+            finishMultiPoseCalibration();
+        } else {
+            finishStationaryCalibration();
+        }
+
+        // Reset state
+        isCalibrating = false;
+        accelStats.reset();
+        gyroStats.reset();
+        ellipsoidCalibrator.reset();
+    }
+
+    void FusionEngine::finishStationaryCalibration() {
+        if (accelStats.count() < MIN_CALIBRATION_SAMPLES ||
+            gyroStats.count() < MIN_CALIBRATION_SAMPLES) {
+            notify(callbacks.error, std::string("Not enough samples for calibration"));
+            return;
+        }
+
+        try {
+            const Vector3d accelMean = accelStats.getMean();
+            const Matrix3d accelCovariance = accelStats.covariance();
+            const Vector3d gyroMean = gyroStats.getMean();
+            const Matrix3d gyroCovariance = gyroStats.covariance();
+
+            // Update calibration
+            CalibrationData newCalibration;
+
+            // For accelerometer assuming device is stationary and experiencing 1g
+            newCalibration.accelBias = accelMean - Vector3d(0, 0, 9.81);
+
+            // For gyroscope also assume stationary
+            newCalibration.gyroBias = gyroMean;
+
+            Vector3d accelScaleDiag = Vector3d::Ones() + 0.5 * accelCovariance.diagonal();
+            newCalibration.accelScale = accelScaleDiag.asDiagonal();
+
+            // For gyroscope scaling
+            Vector3d gyroScaleDiag = Vector3d::Ones() + 0.5 * gyroCovariance.diagonal();
+            newCalibration.gyroScale = gyroScaleDiag.asDiagonal();
+
+            calibration = newCalibration;
+            rebuildTransforms();
+            notify(callbacks.calibration, calibration);
+
+        } catch (const std::exception& e) {
+            notify(callbacks.error, std::string("Calibration calculation error: ") + e.what());
+        }
+    }
+
+    void FusionEngine::finishMultiPoseCalibration() {
+        // The pose the operator is holding when they stop still counts
+        ellipsoidCalibrator.closePose();
+
+        CalibrationData newCalibration;
+        auto result = ellipsoidCalibrator.solve(newCalibration);
+        if (!result.success) {
+            notify(callbacks.error, "Multi-pose calibration needs at least "
+                                    + std::to_string(EllipsoidCalibrator::AXIS_ALIGNED_POSES)
+                                    + " distinct still poses, got " + std::to_string(ellipsoidCalibrator.getPoseCount()));
+            return;
+        }
+
+        calibration = newCalibration;
+        rebuildTransforms();
+        notify(callbacks.calibration, calibration);
+        notify(callbacks.calibrationFitQuality, result.rmsResidual, result.fullFit);
+    }
+
+    void FusionEngine::resetOrientation() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (filter) {
+            filter->reset();
+        }
+        smoother->reset();
+        gapConcealer.reset();
+    }
+
+    void FusionEngine::resetStream() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        resetStreamState();
+        streamStopped = false;
+    }
+
+    void FusionEngine::stopStream() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        resetStreamState();
+        streamStopped = true;
+    }
+
+    void FusionEngine::resetStreamState() {
+        resampler.reset();
+        jitterBuffer.restart();
+        gapConcealer.reset();
+        smoother->reset();
+    }
+
+    void FusionEngine::setCalibrationData(const CalibrationData& newCalibration) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        calibration = newCalibration;
+        rebuildTransforms();
+    }
+
+    bool FusionEngine::validateIMUData(const IMUData& data) {
+        ErrorCategory fault;
+        return validateIMUData(data, fault);
+    }
+
+    bool FusionEngine::validateIMUData(const IMUData& data, ErrorCategory& fault) {
+        for (int i = 0; i < 3; ++i) {
+            if (!std::isfinite(data.acceleration[i]) || !std::isfinite(data.gyroscope[i])) {
+                fault = ErrorCategory::NON_FINITE_SAMPLE;
+                return false;
+            }
+        }
+
+        // Check for acceleration
+        const double accelMagnitude = data.acceleration.norm();
+        if (accelMagnitude < 0.981 || accelMagnitude > 39.24) {
+            fault = ErrorCategory::ACCEL_OUT_OF_RANGE;
+            return false;
+        }
+
+        // Gyroscrope/ angular magnitude check
+        const double gyroMagnitude = data.gyroscope.norm();
+        if (gyroMagnitude > 8.726) { // 500 deg/s in rad/s
+            fault = ErrorCategory::GYRO_OUT_OF_RANGE;
+            return false;
+        }
+
+        return true;
+    }
+
+    void FusionEngine::reportErrors() {
+        // Summarised once per interval, however many times each fault fired
+        for (const auto& entry : errors.takeSummary()) {
+            char text[128];
+            std::snprintf(text, sizeof(text), "%" PRIu64 " %s in last %g s", entry.count,
+                          ErrorAggregator::describe(entry.category), ERROR_REPORT_INTERVAL_MS / 1000.0);
+            std::string summary = text;
+            if (!entry.detail.empty()) {
+                summary += " (latest: " + entry.detail + ")";
+            }
+            notify(callbacks.errorSummary, summary);
+        }
+    }
+
+    void FusionEngine::poll(int64_t nowNs) {
+        drainSubmitted();
+
+        if (nowNs >= nextPlayoutNs) {
+            nextPlayoutNs = nowNs + PLAYOUT_INTERVAL_MS * 1000000LL;
+            releaseBufferedSamples();
+        }
+        if (nowNs >= nextConcealNs) {
+            nextConcealNs = nowNs + CONCEALMENT_INTERVAL_MS * 1000000LL;
+            concealGap();
+        }
+        if (nextErrorReportNs == 0) {
+            nextErrorReportNs = nowNs + ERROR_REPORT_INTERVAL_MS * 1000000LL; // First summary a full interval in
+        } else if (nowNs >= nextErrorReportNs) {
+            nextErrorReportNs = nowNs + ERROR_REPORT_INTERVAL_MS * 1000000LL;
+            reportErrors();
+        }
+    }
+}
\ No newline at end of file
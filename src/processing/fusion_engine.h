@@ -0,0 +1,255 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_FUSION_ENGINE_H
+#define IMU_VISUALIZER_FUSION_ENGINE_H
+
+#pragma once
+#include "core/imu_data.h"
+#include <mutex>
+#include "filters/orientation_filter.h"
+#include "filters/filter_factory.h"
+#include "calibration/running_statistics.h"
+#include "calibration/ellipsoid_calibrator.h"
+#include "calibration/sensor_transform.h"
+#include "smoothing/smoother_factory.h"
+#include "timing/resampler.h"
+#include "timing/jitter_buffer.h"
+#include "timing/gap_concealer.h"
+#include "core/spsc_queue.h"
+#include "core/triple_buffer.h"
+#include "error_aggregator.h"
+#include "latency_monitor.h"
+#include "pipeline/pipeline.h"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <string>
+
+namespace imu_viz {
+
+    /**
+     * Calibration, resampling, fusion and smoothing with no Qt dependency, results go out through
+     * plain callbacks. Whoever hosts it drives the periodic work: call poll() every INGEST_INTERVAL_MS
+     * from one thread, or the individual drainSubmitted/releaseBufferedSamples/concealGap/reportErrors
+     * from timers at their intervals. DataProcessor wraps it for the GUI, imu_daemon runs it headless.
+     */
+    class FusionEngine {
+    public:
+        enum class CalibrationMode {
+            STATIONARY, // Device flat and still, bias only
+            MULTI_POSE  // Device held still in several orientations, full ellipsoid fit
+        };
+
+        // Any of these may be empty. orientation runs on whichever thread publishes (the pipeline's
+        // publish stage or the poll thread), so keep it short. Set before samples flow
+        struct Callbacks {
+            std::function<void(const OrientationSample&)> orientation;
+            std::function<void(const CalibrationData&)> calibration;
+            std::function<void(uint64_t samples, double accelStdError, double gyroStdError, bool converged)> calibrationProgress;
+            std::function<void(int poses, int requiredPoses, bool stationary)> calibrationPoseProgress;
+            std::function<void(double rmsResidual, bool fullFit)> calibrationFitQuality;
+            std::function<void(const std::string&)> error;
+            std::function<void(const std::string&)> errorSummary;
+        };
+
+        static constexpr int PLAYOUT_INTERVAL_MS = 2; // Jitter buffer release granularity
+        static constexpr int CONCEALMENT_INTERVAL_MS = 10; // Output cadence while a gap is concealed
+        static constexpr int INGEST_INTERVAL_MS = 1;
+        static constexpr int ERROR_REPORT_INTERVAL_MS = 1000;
+
+        FusionEngine();
+
+        ~FusionEngine() = default;
+        FusionEngine(const FusionEngine&) = delete;
+
+        void setCallbacks(Callbacks newCallbacks) { callbacks = std::move(newCallbacks); }
+
+        void setFilterType(OrientationFilterFactory::FilterType type);
+        void setCalibrationData(const CalibrationData &calibration);
+        void setCalibrationMode(CalibrationMode mode);
+        void setSmootherType(OutputSmootherFactory::SmootherType type);
+
+        // Lag the output smoother currently adds on top of the filter
+        double smoothingLatencyMs() const;
+
+        // Fixed filter rate for fast sensors, inputs are averaged down to it. 0 runs on every new timestamp
+        void setFilterRate(double hz);
+        ResamplerStats getResamplerStats() const;
+
+        // Networked streams: hold samples back and release them at an even cadence
+        void setJitterBufferEnabled(bool enabled);
+        JitterBuffer::Stats getJitterBufferStats() const;
+
+        GapConcealer::Stats getGapStats() const;
+
+        // Fixed remap from the sensor frame to the body frame, e.g. TCPTransport's inverted x
+        void setAxisMapping(const Matrix3d& mapping);
+
+        // Hand off from the transport thread: lock free, never allocates. Drained on the polling thread
+        void submitIMUData(const IMUData& data);
+        uint64_t getSubmitOverflows() const { return errors.getTotal(ErrorCategory::INGEST_OVERFLOW); }
+
+        // Hot path faults are counted here and reported once per ERROR_REPORT_INTERVAL_MS via errorSummary.
+        // Thread safe, so transports can record their own errors too
+        ErrorAggregator& getErrorAggregator() { return errors; }
+
+        // Newest published orientation, read by the renderer once per frame instead of per sample
+        TripleBuffer<OrientationSample>& getLatestOrientation() { return latestOrientation; }
+
+        // Every published orientation in order, for consumers that need the history rather than the
+        // newest: the renderer's trail and the signal plots. One single consumer queue per tap, each off
+        // until enabled, and while on a full queue drops new samples
+        enum class HistoryTap { TRAIL, PLOT };
+        static constexpr size_t HISTORY_TAP_COUNT = 2;
+        static constexpr size_t HISTORY_CAPACITY = 1024;
+        using OrientationHistory = SpscQueue<OrientationSample, HISTORY_CAPACITY>;
+        using SampleHistory = SpscQueue<IMUData, HISTORY_CAPACITY>;
+        void setHistoryEnabled(HistoryTap tap, bool enabled) {
+            historyEnabled[static_cast<size_t>(tap)].store(enabled, std::memory_order_relaxed);
+        }
+        OrientationHistory& getOrientationHistory(HistoryTap tap) {
+            return orientationHistory[static_cast<size_t>(tap)];
+        }
+
+        // Raw samples as they enter the pipeline, before calibration. Filled while the PLOT tap is on
+        SampleHistory& getSampleHistory() { return sampleHistory; }
+
+        // Per sample work as a stage list, e.g. "validate,calibrate,resample,filter@thread/64,smooth,publish".
+        // calibrate, resample, filter and publish are required and the core stages keep their relative order,
+        // metrics can go anywhere. A bad config is reported through the error callback and the old one kept
+        static constexpr const char* DEFAULT_PIPELINE_CONFIG = "validate,calibrate,resample,filter,smooth,publish,metrics";
+        bool setPipelineConfig(const std::string& config);
+        std::string getPipelineConfig() const;
+        std::vector<StageStats> getPipelineStats() const;
+
+        // Read -> decode -> publish are recorded by the metrics stage, the renderer adds the rest
+        LatencyMonitor& getLatencyMonitor() { return latency; }
+
+        // Same as processIMUData per sample minus the jitter buffer, but validates and calibrates the whole
+        // batch in one vectorised pass and enters the pipeline at resample. Their stage stats don't count
+        // batched samples. Used unless a stage other than validate,calibrate comes before resample
+        // (e.g. metrics first), then each sample runs the full pipeline
+        void processIMUBatch(const IMUData* samples, size_t count);
+
+        // Stateless sanity check, public so the benchmarks can time it on its own
+        static bool validateIMUData(const IMUData& data);
+        static bool validateIMUData(const IMUData& data, ErrorCategory& fault);
+
+        void processIMUData(const IMUData &data);
+        void startCalibration();
+        void finishCalibration();
+        void resetOrientation();
+
+        // A sensor (re)connected or the transport changed: drops the timing state tied to the old
+        // stream's clock (resampler window, jitter buffer, gap concealment, smoother history)
+        void resetStream();
+
+        // Deliberate disconnect: same reset, and the silence that follows is not a gap to conceal.
+        // Concealment resumes with the next resetStream()
+        void stopStream();
+        void updateCalibration(const IMUData& data);
+
+        // Periodic work, each safe to call more often than its interval
+        void drainSubmitted();
+        void releaseBufferedSamples();
+        void concealGap();
+        void reportErrors();
+
+        // All of the above that are due at nowNs, for hosts with a single loop instead of timers
+        void poll(int64_t nowNs);
+
+    private:
+        static constexpr uint64_t MIN_CALIBRATION_SAMPLES = 1000;
+        static constexpr uint64_t CALIBRATION_PROGRESS_INTERVAL = 100; // Samples between progress callbacks
+
+        // Calibration is converged once the standard error of the mean drops below these
+        static constexpr double ACCEL_CONVERGED_STD_ERROR = 0.002; // m/s^2
+        static constexpr double GYRO_CONVERGED_STD_ERROR = 0.0002; // rad/s
+        static constexpr size_t BATCH_CAPACITY = 64;
+        static constexpr size_t SUBMIT_CAPACITY = 1024; // ~1 s at 1 kHz before samples are dropped
+
+        // Scale down the raw values, reduces sensitivity
+        static constexpr double ACCEL_UNIT_SCALE = 0.1;
+        static constexpr double GYRO_UNIT_SCALE = 0.1;
+
+        Callbacks callbacks;
+
+        std::unique_ptr<IOrientationFilter> filter;
+        std::unique_ptr<IOutputSmoother> smoother;
+        CalibrationData calibration;
+        bool isCalibrating{false};
+        CalibrationMode calibrationMode{CalibrationMode::STATIONARY};
+        Resampler resampler;
+        JitterBuffer jitterBuffer;
+        std::atomic<bool> jitterBufferEnabled{false};
+        GapConcealer gapConcealer;
+        bool streamStopped{false}; // Under dataMutex, no concealment after stopStream()
+
+        // Transport thread -> polling thread, replaces a queued invokeMethod (one heap event) per sample
+        SpscQueue<IMUData, SUBMIT_CAPACITY> submitted;
+
+        ErrorAggregator errors;
+
+        // poll() bookkeeping, next due time per duty
+        int64_t nextPlayoutNs{0};
+        int64_t nextConcealNs{0};
+        int64_t nextErrorReportNs{0};
+
+        TripleBuffer<OrientationSample> latestOrientation;
+        std::array<OrientationHistory, HISTORY_TAP_COUNT> orientationHistory;
+        std::array<std::atomic<bool>, HISTORY_TAP_COUNT> historyEnabled{};
+        SampleHistory sampleHistory;
+
+        // Mutex for thread safety
+        mutable std::mutex dataMutex;
+
+        // Calibration statistics, accumulated online so the window can be any length
+        RunningStatistics accelStats;
+        RunningStatistics gyroStats;
+        EllipsoidCalibrator ellipsoidCalibrator;
+        bool wasStationary{false};
+
+        void accumulateCalibration(const IMUData& data);
+        void finishStationaryCalibration();
+        void finishMultiPoseCalibration();
+
+        // Calibration, axis mapping and unit scaling folded together, see rebuildTransforms
+        Matrix3d axisMapping{Matrix3d::Identity()};
+        SensorTransforms transforms;
+
+        // x/y/z lanes for processIMUBatch
+        struct BatchScratch {
+            std::array<double, BATCH_CAPACITY> ax, ay, az;
+            std::array<double, BATCH_CAPACITY> gx, gy, gz;
+        };
+        BatchScratch batch;
+
+        LatencyMonitor latency;
+
+        template <typename Callback, typename... Args>
+        static void notify(const Callback& callback, Args&&... args) {
+            if (callback) callback(std::forward<Args>(args)...);
+        }
+
+        void rebuildTransforms();
+        std::unique_ptr<Pipeline> buildPipeline(const std::string& config);
+        std::unique_ptr<IStage> createStage(const std::string& name, bool& usesSharedState);
+        bool calibrateStage(PipelineFrame& frame);
+        bool filterStage(PipelineFrame& frame);
+        bool smoothStage(PipelineFrame& frame);
+        bool publishStage(PipelineFrame& frame);
+        bool metricsStage(PipelineFrame& frame);
+        void ingest(const IMUData& data);
+        void playOut(int64_t nowNs); // Releases the jitter buffer's due samples in batches
+        void publish(const OrientationSample& sample);
+        void resetStreamState(); // dataMutex held
+
+        // Last member: destroyed first, so its workers are joined while the state they use still exists
+        std::string pipelineConfig;
+        std::unique_ptr<Pipeline> pipeline;
+    };
+}
+
+#endif //IMU_VISUALIZER_FUSION_ENGINE_H
@@ -0,0 +1,117 @@
+//
+// Created by Raphael Russo on 12/18/24.
+//
+
+#ifndef IMU_VISUALIZER_LATENCY_MONITOR_H
+#define IMU_VISUALIZER_LATENCY_MONITOR_H
+#pragma once
+
+#include "core/latency_histogram.h"
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+namespace imu_viz {
+
+    // Segments between the stamps a sample picks up on its way to the screen
+    enum class LatencyStage {
+        DECODE,      // Transport read -> packet decoded
+        PROCESS,     // Decoded -> published by the pipeline (hand off, jitter buffer, filter, smoothing)
+        RENDER_WAIT, // Published -> picked up by paintGL
+        PRESENT,     // paintGL -> buffer swap done
+        END_TO_END,  // Transport read -> buffer swap done
+        COUNT
+    };
+
+    /**
+     * One LatencyHistogram per segment. Only samples from a real transport are recorded (no replay,
+     * no concealment), and the render segments only count a sample the first frame it is drawn.
+     */
+    class LatencyMonitor {
+    public:
+        static constexpr size_t STAGE_COUNT = static_cast<size_t>(LatencyStage::COUNT);
+
+        void record(LatencyStage stage, int64_t ns) {
+            histograms[static_cast<size_t>(stage)].record(ns);
+        }
+
+        LatencyHistogram::Snapshot snapshot(LatencyStage stage) const {
+            return histograms[static_cast<size_t>(stage)].snapshot();
+        }
+
+        void reset() {
+            for (auto& histogram : histograms) {
+                histogram.reset();
+            }
+        }
+
+        // Label for exported metrics
+        static const char* key(LatencyStage stage) {
+            switch (stage) {
+                case LatencyStage::DECODE: return "decode";
+                case LatencyStage::PROCESS: return "process";
+                case LatencyStage::RENDER_WAIT: return "render_wait";
+                case LatencyStage::PRESENT: return "present";
+                case LatencyStage::END_TO_END: return "end_to_end";
+                default: return "unknown";
+            }
+        }
+
+        static const char* describe(LatencyStage stage) {
+            switch (stage) {
+                case LatencyStage::DECODE: return "read -> decode";
+                case LatencyStage::PROCESS: return "decode -> publish";
+                case LatencyStage::RENDER_WAIT: return "publish -> paint";
+                case LatencyStage::PRESENT: return "paint -> swap";
+                case LatencyStage::END_TO_END: return "read -> swap";
+                default: return "unknown";
+            }
+        }
+
+        // Summary table, then each segment's percentile ladder, all in microseconds
+        void writeReport(std::ostream& out) const {
+            static constexpr std::array<double, 9> LADDER = {0.0, 50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0};
+
+            out << std::fixed << std::setprecision(1);
+            out << std::left << std::setw(20) << "segment" << std::right
+                << std::setw(12) << "samples" << std::setw(12) << "mean us" << std::setw(12) << "p50 us"
+                << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us" << std::setw(12) << "max us" << '\n';
+
+            std::array<LatencyHistogram::Snapshot, STAGE_COUNT> snapshots;
+            for (size_t i = 0; i < STAGE_COUNT; ++i) {
+                snapshots[i] = histograms[i].snapshot();
+                const auto& s = snapshots[i];
+                out << std::left << std::setw(20) << describe(static_cast<LatencyStage>(i)) << std::right
+                    << std::setw(12) << s.count << std::setw(12) << s.meanNs * 1e-3
+                    << std::setw(12) << s.percentileNs(50.0) * 1e-3 << std::setw(12) << s.percentileNs(99.0) * 1e-3
+                    << std::setw(12) << s.percentileNs(99.9) * 1e-3 << std::setw(12) << s.maxNs * 1e-3 << '\n';
+            }
+
+            for (size_t i = 0; i < STAGE_COUNT; ++i) {
+                const auto& s = snapshots[i];
+                if (s.count == 0) continue;
+                out << '\n' << describe(static_cast<LatencyStage>(i)) << '\n';
+                out << std::setw(12) << "percentile" << std::setw(14) << "value us" << '\n';
+                for (double p : LADDER) {
+                    out << std::setw(12) << std::setprecision(3) << p
+                        << std::setw(14) << std::setprecision(1) << s.percentileNs(p) * 1e-3 << '\n';
+                }
+            }
+        }
+
+        bool dumpToFile(const std::string& path) const {
+            std::ofstream out(path);
+            if (!out) return false;
+            writeReport(out);
+            return static_cast<bool>(out);
+        }
+
+    private:
+        std::array<LatencyHistogram, STAGE_COUNT> histograms;
+    };
+}
+
+#endif //IMU_VISUALIZER_LATENCY_MONITOR_H
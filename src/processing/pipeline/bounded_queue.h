@@ -0,0 +1,87 @@
+//
+// Created by Raphael Russo on 12/17/24.
+//
+
+#ifndef IMU_VISUALIZER_BOUNDED_QUEUE_H
+#define IMU_VISUALIZER_BOUNDED_QUEUE_H
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace imu_viz {
+
+    /**
+     * Fixed capacity FIFO for any number of producers and consumers.
+     * Storage is allocated once up front. Producers never block, a full queue rejects the item
+     * so a slow stage sheds load instead of stalling the ones before it.
+     */
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity)
+                : items(capacity > 0 ? capacity : 1) {}
+
+        bool tryPush(const T& item) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (count == items.size() || stopped) return false;
+                items[(head + count) % items.size()] = item;
+                ++count;
+                depth.store(count, std::memory_order_relaxed);
+            }
+            available.notify_one();
+            return true;
+        }
+
+        bool tryPop(T& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return popLocked(item);
+        }
+
+        // Blocks until an item arrives, false once stopped and empty
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return count > 0 || stopped; });
+            return popLocked(item);
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            available.notify_all();
+        }
+
+        // Lock free so monitoring never contends with the producers and consumers
+        size_t size() const {
+            return depth.load(std::memory_order_relaxed);
+        }
+
+        size_t capacity() const { return items.size(); }
+
+    private:
+        mutable std::mutex mutex;
+        std::condition_variable available;
+        std::vector<T> items;
+        size_t head{0};
+        size_t count{0};
+        std::atomic<size_t> depth{0}; // Mirrors count
+        bool stopped{false};
+
+        bool popLocked(T& item) {
+            if (count == 0) return false;
+            item = items[head];
+            head = (head + 1) % items.size();
+            --count;
+            depth.store(count, std::memory_order_relaxed);
+            return true;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_BOUNDED_QUEUE_H
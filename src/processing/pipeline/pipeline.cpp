@@ -0,0 +1,304 @@
+//
+// Created by Raphael Russo on 12/17/24.
+//
+
+#include "pipeline.h"
+#include "core/clock.h"
+#include "core/profiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+
+namespace imu_viz {
+    namespace {
+        constexpr size_t POOL_BATCH = 32; // Frames a pool thread takes from one stage before moving on
+
+        std::string trimmed(const std::string& text) {
+            size_t begin = 0;
+            size_t end = text.size();
+            while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) ++begin;
+            while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+            return text.substr(begin, end - begin);
+        }
+
+        // A stage runs on one thread at a time, so its counters have one writer and skip the locked RMW.
+        // Readers only ever see a slightly stale value
+        void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        template <typename T>
+        void raiseMax(std::atomic<T>& target, T value) {
+            T current = target.load(std::memory_order_relaxed);
+            while (value > current &&
+                   !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+    }
+
+    Pipeline::Pipeline(std::mutex* sharedState)
+            : sharedState(sharedState) {}
+
+    Pipeline::~Pipeline() {
+        stop();
+    }
+
+    void Pipeline::addStage(std::unique_ptr<IStage> stage, StageMode mode, size_t capacity, bool usesSharedState) {
+        if (running) {
+            throw std::logic_error("Pipeline stages can't change while it runs");
+        }
+        auto slot = std::make_unique<Slot>();
+        slot->stage = std::move(stage);
+        slot->mode = mode;
+        slot->usesSharedState = usesSharedState;
+        if (mode != StageMode::INLINE) {
+            slot->queue = std::make_unique<BoundedQueue<PipelineFrame>>(
+                    capacity > 0 ? capacity : DEFAULT_QUEUE_CAPACITY);
+        }
+        stages.push_back(std::move(slot));
+    }
+
+    void Pipeline::start() {
+        if (running) return;
+        running = true;
+
+        bool pooled = false;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (stages[i]->mode == StageMode::THREAD) {
+                stages[i]->worker = std::thread(&Pipeline::threadLoop, this, i);
+            }
+            pooled = pooled || stages[i]->mode == StageMode::POOL;
+        }
+
+        if (pooled) {
+            poolTasks = std::make_unique<BoundedQueue<size_t>>(stages.size());
+            const unsigned threads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+            for (unsigned i = 0; i < threads; ++i) {
+                poolWorkers.emplace_back(&Pipeline::poolLoop, this);
+            }
+        }
+    }
+
+    void Pipeline::stop() {
+        if (!running) return;
+
+        // Workers finish what is already queued, anything pushed from here on is counted as dropped
+        for (auto& slot : stages) {
+            if (slot->queue) slot->queue->stop();
+        }
+        for (auto& slot : stages) {
+            if (slot->worker.joinable()) slot->worker.join();
+        }
+        if (poolTasks) poolTasks->stop();
+        for (auto& worker : poolWorkers) {
+            worker.join();
+        }
+        poolWorkers.clear();
+        poolTasks.reset();
+        running = false;
+    }
+
+    void Pipeline::push(PipelineFrame& frame, size_t first) {
+        if (first >= stages.size()) return;
+
+        if (stages[first]->mode == StageMode::INLINE) {
+            run(first, frame);
+        } else {
+            enqueue(first, frame);
+        }
+    }
+
+    void Pipeline::run(size_t index, PipelineFrame& frame) {
+        std::unique_lock<std::mutex> lock;
+
+        for (size_t i = index; i < stages.size(); ++i) {
+            Slot& slot = *stages[i];
+
+            // Segment ends where the next queue starts
+            if (i != index && slot.mode != StageMode::INLINE) {
+                if (lock.owns_lock()) lock.unlock();
+                enqueue(i, frame);
+                return;
+            }
+
+            if (slot.usesSharedState && sharedState && !lock.owns_lock()) {
+                lock = std::unique_lock<std::mutex>(*sharedState);
+            }
+            if (!execute(slot, frame)) return;
+        }
+    }
+
+    bool Pipeline::execute(Slot& slot, PipelineFrame& frame) {
+        const uint64_t count = slot.processed.load(std::memory_order_relaxed);
+        bump(slot.processed);
+
+        bool passed;
+        if (count % TIMING_STRIDE == 0) {
+            const int64_t begin = steadyNowNs();
+            passed = slot.stage->process(frame);
+            const auto elapsed = static_cast<uint64_t>(steadyNowNs() - begin);
+            bump(slot.timedFrames);
+            bump(slot.timedNs, elapsed);
+            raiseMax(slot.maxServiceNs, elapsed);
+        } else {
+            passed = slot.stage->process(frame);
+        }
+
+        if (!passed) {
+            bump(slot.stopped);
+        }
+        return passed;
+    }
+
+    void Pipeline::enqueue(size_t index, const PipelineFrame& frame) {
+        Slot& slot = *stages[index];
+        if (!slot.queue->tryPush(frame)) {
+            slot.queueDrops.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        raiseMax(slot.maxQueueDepth, slot.queue->size());
+
+        if (slot.mode == StageMode::POOL) {
+            schedule(index);
+        }
+    }
+
+    void Pipeline::schedule(size_t index) {
+        // One pool thread per stage at a time keeps the stage's frames in order
+        if (!stages[index]->scheduled.exchange(true)) {
+            poolTasks->tryPush(index);
+        }
+    }
+
+    void Pipeline::threadLoop(size_t index) {
+        Slot& slot = *stages[index];
+        IMU_PROFILE_THREAD_NAME(("stage " + slot.stage->name()).c_str());
+        PipelineFrame frame;
+        while (slot.queue->pop(frame)) {
+            run(index, frame);
+        }
+    }
+
+    void Pipeline::poolLoop() {
+        IMU_PROFILE_THREAD_NAME("pipeline pool");
+        size_t index;
+        PipelineFrame frame;
+        while (poolTasks->pop(index)) {
+            Slot& slot = *stages[index];
+            for (size_t i = 0; i < POOL_BATCH && slot.queue->tryPop(frame); ++i) {
+                run(index, frame);
+            }
+
+            // A producer that pushed while we held the flag didn't reschedule, so check again
+            slot.scheduled.store(false);
+            if (slot.queue->size() > 0) {
+                schedule(index);
+            }
+        }
+    }
+
+    int Pipeline::findStage(const std::string& name) const {
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (stages[i]->stage->name() == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    std::vector<StageStats> Pipeline::getStats() const {
+        std::vector<StageStats> result;
+        result.reserve(stages.size());
+        for (const auto& slot : stages) {
+            StageStats stats;
+            stats.name = slot->stage->name();
+            stats.mode = slot->mode;
+            if (slot->queue) {
+                stats.queueDepth = slot->queue->size();
+                stats.queueCapacity = slot->queue->capacity();
+            }
+            stats.maxQueueDepth = slot->maxQueueDepth.load(std::memory_order_relaxed);
+            stats.processed = slot->processed.load(std::memory_order_relaxed);
+            stats.stopped = slot->stopped.load(std::memory_order_relaxed);
+            stats.queueDrops = slot->queueDrops.load(std::memory_order_relaxed);
+
+            const uint64_t timed = slot->timedFrames.load(std::memory_order_relaxed);
+            if (timed > 0) {
+                stats.meanServiceNs = static_cast<double>(slot->timedNs.load(std::memory_order_relaxed)) / timed;
+            }
+            stats.maxServiceNs = static_cast<double>(slot->maxServiceNs.load(std::memory_order_relaxed));
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+    std::vector<StageSpec> Pipeline::parseConfig(const std::string& config) {
+        std::vector<StageSpec> specs;
+
+        size_t begin = 0;
+        while (begin <= config.size()) {
+            size_t end = config.find(',', begin);
+            if (end == std::string::npos) end = config.size();
+            std::string entry = trimmed(config.substr(begin, end - begin));
+            begin = end + 1;
+            if (entry.empty()) {
+                if (end == config.size()) break;
+                throw std::invalid_argument("Empty stage in pipeline config");
+            }
+
+            StageSpec spec;
+            const size_t slash = entry.find('/');
+            if (slash != std::string::npos) {
+                const std::string capacity = trimmed(entry.substr(slash + 1));
+                const char* last = capacity.data() + capacity.size();
+                const auto [ptr, ec] = std::from_chars(capacity.data(), last, spec.capacity);
+                if (capacity.empty() || ptr != last || ec == std::errc::invalid_argument) {
+                    throw std::invalid_argument("Bad queue capacity in '" + entry + "'");
+                }
+                if (ec == std::errc::result_out_of_range || spec.capacity > MAX_QUEUE_CAPACITY) {
+                    throw std::invalid_argument("Queue capacity above " + std::to_string(MAX_QUEUE_CAPACITY) +
+                                                " in '" + entry + "'");
+                }
+                if (spec.capacity == 0) {
+                    throw std::invalid_argument("Queue capacity must be positive in '" + entry + "'");
+                }
+                entry = trimmed(entry.substr(0, slash));
+            }
+
+            const size_t at = entry.find('@');
+            if (at != std::string::npos) {
+                const std::string mode = trimmed(entry.substr(at + 1));
+                if (mode == "inline") {
+                    spec.mode = StageMode::INLINE;
+                } else if (mode == "thread") {
+                    spec.mode = StageMode::THREAD;
+                } else if (mode == "pool") {
+                    spec.mode = StageMode::POOL;
+                } else {
+                    throw std::invalid_argument("Unknown stage mode '" + mode + "'");
+                }
+                entry = trimmed(entry.substr(0, at));
+            }
+
+            if (entry.empty()) {
+                throw std::invalid_argument("Stage without a name in pipeline config");
+            }
+            for (const auto& existing : specs) {
+                if (existing.name == entry) {
+                    throw std::invalid_argument("Stage '" + entry + "' appears twice");
+                }
+            }
+            spec.name = entry;
+            specs.push_back(spec);
+        }
+        return specs;
+    }
+
+    const char* Pipeline::modeName(StageMode mode) {
+        switch (mode) {
+            case StageMode::INLINE: return "inline";
+            case StageMode::THREAD: return "thread";
+            case StageMode::POOL: return "pool";
+        }
+        return "unknown";
+    }
+}
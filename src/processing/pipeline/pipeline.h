@@ -0,0 +1,115 @@
+//
+// Created by Raphael Russo on 12/17/24.
+//
+
+#ifndef IMU_VISUALIZER_PIPELINE_H
+#define IMU_VISUALIZER_PIPELINE_H
+#pragma once
+
+#include "stage.h"
+#include "bounded_queue.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace imu_viz {
+
+    enum class StageMode {
+        INLINE, // Runs on whichever thread finished the stage before it
+        THREAD, // Own queue and worker thread
+        POOL    // Own queue, drained by the shared pool one batch at a time so order is kept
+    };
+
+    struct StageSpec {
+        std::string name;
+        StageMode mode{StageMode::INLINE};
+        size_t capacity{0}; // 0 picks Pipeline::DEFAULT_QUEUE_CAPACITY
+    };
+
+    struct StageStats {
+        std::string name;
+        StageMode mode{StageMode::INLINE};
+        size_t queueDepth{0};
+        size_t maxQueueDepth{0};
+        size_t queueCapacity{0};
+        uint64_t processed{0};
+        uint64_t stopped{0};     // process() returned false
+        uint64_t queueDrops{0};  // Queue was full
+        double meanServiceNs{0.0};
+        double maxServiceNs{0.0};
+    };
+
+    /**
+     * Linear dataflow graph: each frame visits the stages in order.
+     * Consecutive inline stages run back to back on one thread, a THREAD or POOL stage starts a new
+     * segment behind a bounded queue. Stages that touch shared state are run with the shared mutex
+     * held, taken once per segment rather than per stage.
+     */
+    class Pipeline {
+    public:
+        static constexpr size_t DEFAULT_QUEUE_CAPACITY = 256;
+        static constexpr size_t MAX_QUEUE_CAPACITY = 65536; // Frames are ~0.5 KB, a config typo mustn't allocate GBs
+        static constexpr uint64_t TIMING_STRIDE = 32; // Every 32nd frame is timed, two clock reads cost more than most stages
+
+        explicit Pipeline(std::mutex* sharedState = nullptr);
+        ~Pipeline();
+        Pipeline(const Pipeline&) = delete;
+        Pipeline& operator=(const Pipeline&) = delete;
+
+        // Only before start()
+        void addStage(std::unique_ptr<IStage> stage, StageMode mode, size_t capacity, bool usesSharedState);
+
+        void start();
+        void stop(); // Joins the workers, frames still queued are dropped
+
+        // Runs the frame from stage `first` on, inline stages work on it in place. Never blocks on a full queue
+        void push(PipelineFrame& frame, size_t first = 0);
+
+        int findStage(const std::string& name) const;
+        size_t size() const { return stages.size(); }
+        std::vector<StageStats> getStats() const;
+
+        // "validate,calibrate,resample,filter@thread/64,smooth,publish@pool"
+        // Throws std::invalid_argument on a malformed entry or a capacity above MAX_QUEUE_CAPACITY
+        static std::vector<StageSpec> parseConfig(const std::string& config);
+        static const char* modeName(StageMode mode);
+
+    private:
+        struct Slot {
+            std::unique_ptr<IStage> stage;
+            StageMode mode{StageMode::INLINE};
+            bool usesSharedState{false};
+            std::unique_ptr<BoundedQueue<PipelineFrame>> queue;
+            std::thread worker;
+            std::atomic<bool> scheduled{false}; // POOL: already waiting for or running on a pool thread
+
+            std::atomic<uint64_t> processed{0};
+            std::atomic<uint64_t> stopped{0};
+            std::atomic<uint64_t> queueDrops{0};
+            std::atomic<size_t> maxQueueDepth{0};
+            std::atomic<uint64_t> timedFrames{0};
+            std::atomic<uint64_t> timedNs{0};
+            std::atomic<uint64_t> maxServiceNs{0};
+        };
+
+        std::mutex* sharedState;
+        std::vector<std::unique_ptr<Slot>> stages;
+        bool running{false};
+
+        // POOL stages are scheduled here by index, each at most once at a time
+        std::unique_ptr<BoundedQueue<size_t>> poolTasks;
+        std::vector<std::thread> poolWorkers;
+
+        void run(size_t index, PipelineFrame& frame);
+        bool execute(Slot& slot, PipelineFrame& frame);
+        void enqueue(size_t index, const PipelineFrame& frame);
+        void schedule(size_t index);
+        void threadLoop(size_t index);
+        void poolLoop();
+    };
+}
+
+#endif //IMU_VISUALIZER_PIPELINE_H
@@ -0,0 +1,51 @@
+//
+// Created by Raphael Russo on 12/17/24.
+//
+
+#ifndef IMU_VISUALIZER_STAGE_H
+#define IMU_VISUALIZER_STAGE_H
+#pragma once
+
+#include "core/imu_data.h"
+#include "processing/timing/resampler.h"
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace imu_viz {
+
+    // Everything a sample accumulates on its way through the stages, copied by value between queues
+    struct PipelineFrame {
+        IMUData sample{};              // Raw in, calibrated in place by the calibrate stage
+        ResampledSample window{};      // Set by resample
+        double deltaTime{0.0};         // Step the filter actually took
+        OrientationSample output;      // Set by filter, refined by smooth
+    };
+
+    class IStage {
+    public:
+        virtual ~IStage() = default;
+        virtual const std::string& name() const = 0;
+
+        // False stops the frame here: rejected, merged into a later one, or consumed
+        virtual bool process(PipelineFrame& frame) = 0;
+    };
+
+    // Most stages are a few lines over state someone else owns
+    class FunctionStage : public IStage {
+    public:
+        using Function = std::function<bool(PipelineFrame&)>;
+
+        FunctionStage(std::string name, Function function)
+                : stageName(std::move(name)), function(std::move(function)) {}
+
+        const std::string& name() const override { return stageName; }
+        bool process(PipelineFrame& frame) override { return function(frame); }
+
+    private:
+        std::string stageName;
+        Function function;
+    };
+}
+
+#endif //IMU_VISUALIZER_STAGE_H
@@ -0,0 +1,74 @@
+//
+// Created by Raphael Russo on 12/09/24.
+//
+
+#ifndef IMU_VISUALIZER_CRITICALLY_DAMPED_SMOOTHER_H
+#define IMU_VISUALIZER_CRITICALLY_DAMPED_SMOOTHER_H
+#include "output_smoother.h"
+#include <cmath>
+
+namespace imu_viz {
+    /**
+     * Critically damped spring pulling the output towards the filter orientation.
+     * Second order, so it follows a constant rotation rate with a fixed lag and never overshoots.
+     */
+    class CriticallyDampedSmoother : public IOutputSmoother {
+    public:
+        explicit CriticallyDampedSmoother(double omega = 40.0) // rad/s, stiffness of the spring
+                : omega(omega) {}
+
+        Quaterniond update(const Quaterniond &orientation, double dt) override {
+            if (!initialized) {
+                current = orientation;
+                velocity.setZero();
+                initialized = true;
+                return current;
+            }
+            if (dt <= 0.0) return current;
+            samplePeriod += 0.05 * (dt - samplePeriod);
+
+            // Body frame rotation vector from the target to the output
+            Eigen::AngleAxisd error(orientation.conjugate() * current);
+            const Vector3d e = error.axis() * wrapAngle(error.angle());
+
+            // Exact solution of x'' = -omega^2 x - 2 omega x' over dt with the target held,
+            // stable at any sample rate unlike stepping the spring explicitly
+            const double decay = std::exp(-omega * dt);
+            const Vector3d k = velocity + omega * e;
+            const Vector3d offset = (e + k * dt) * decay;
+            velocity = (velocity - omega * k * dt) * decay;
+
+            current = orientation * rotationFromVector(offset);
+            current.normalize();
+            return current;
+        }
+
+        void reset() override {
+            initialized = false;
+        }
+
+        // 2 / omega for the continuous spring, less half a sample since each target is held until the next
+        double addedLatencyMs() const override {
+            return 1000.0 * (2.0 / omega - 0.5 * samplePeriod);
+        }
+
+    private:
+        double omega;
+        bool initialized{false};
+        Quaterniond current{Quaterniond::Identity()};
+        Vector3d velocity{Vector3d::Zero()};
+        double samplePeriod{0.01};
+
+        static Quaterniond rotationFromVector(const Vector3d &v) {
+            const double angle = v.norm();
+            if (angle < 1e-12) return Quaterniond::Identity();
+            return Quaterniond(Eigen::AngleAxisd(angle, v / angle));
+        }
+
+        // Shortest way round, q and -q are the same rotation
+        static double wrapAngle(double angle) {
+            return angle > M_PI ? angle - 2.0 * M_PI : angle;
+        }
+    };
+}
+#endif //IMU_VISUALIZER_CRITICALLY_DAMPED_SMOOTHER_H
@@ -0,0 +1,71 @@
+//
+// Created by Raphael Russo on 12/09/24.
+//
+
+#ifndef IMU_VISUALIZER_ONE_EURO_SMOOTHER_H
+#define IMU_VISUALIZER_ONE_EURO_SMOOTHER_H
+#include "output_smoother.h"
+#include <cmath>
+
+namespace imu_viz {
+    /**
+     * One Euro filter (Casiez et al. 2012) on SO(3).
+     * The cutoff rises with angular speed: heavy smoothing when the device is nearly still
+     * where jitter is visible, little lag when it moves fast.
+     */
+    class OneEuroSmoother : public IOutputSmoother {
+    public:
+        OneEuroSmoother(double minCutoff = 1.0,        // Hz
+                        double beta = 0.5,             // Hz per rad/s
+                        double derivativeCutoff = 1.0) // Hz
+                : minCutoff(minCutoff), beta(beta), derivativeCutoff(derivativeCutoff) {}
+
+        Quaterniond update(const Quaterniond &orientation, double dt) override {
+            if (!initialized || dt <= 0.0) {
+                if (!initialized) {
+                    lastRaw = orientation;
+                    last = orientation;
+                    initialized = true;
+                }
+                return last;
+            }
+
+            // Speed from the raw input, low passed so noise doesn't open the cutoff
+            double rawSpeed = lastRaw.angularDistance(orientation) / dt;
+            lastRaw = orientation;
+            speed += alpha(derivativeCutoff, dt) * (rawSpeed - speed);
+
+            cutoff = minCutoff + beta * speed;
+            last = last.slerp(alpha(cutoff, dt), orientation);
+            return last;
+        }
+
+        void reset() override {
+            initialized = false;
+            speed = 0.0;
+            cutoff = minCutoff;
+        }
+
+        // Time constant of the current cutoff
+        double addedLatencyMs() const override {
+            return 1000.0 / (2.0 * M_PI * cutoff);
+        }
+
+    private:
+        double minCutoff;
+        double beta;
+        double derivativeCutoff;
+
+        bool initialized{false};
+        Quaterniond lastRaw{Quaterniond::Identity()};
+        Quaterniond last{Quaterniond::Identity()};
+        double speed{0.0};
+        double cutoff{minCutoff};
+
+        static double alpha(double cutoffHz, double dt) {
+            double tau = 1.0 / (2.0 * M_PI * cutoffHz);
+            return 1.0 / (1.0 + tau / dt);
+        }
+    };
+}
+#endif //IMU_VISUALIZER_ONE_EURO_SMOOTHER_H
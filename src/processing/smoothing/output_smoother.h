@@ -0,0 +1,40 @@
+//
+// Created by Raphael Russo on 12/09/24.
+//
+
+#ifndef IMU_VISUALIZER_OUTPUT_SMOOTHER_H
+#define IMU_VISUALIZER_OUTPUT_SMOOTHER_H
+#pragma once
+#include <Eigen/Geometry>
+#include "imu_visualizer/common.h"
+
+namespace imu_viz {
+
+    // Post filter smoothing of the published orientation, trades jitter for lag
+    class IOutputSmoother {
+    public:
+        virtual ~IOutputSmoother() = default;
+
+        // dt in seconds since the previous sample, <= 0 on the first sample
+        virtual Quaterniond update(const Quaterniond &orientation, double dt) = 0;
+
+        virtual void reset() = 0;
+
+        // Lag this stage currently adds to a steadily rotating input, in milliseconds
+        virtual double addedLatencyMs() const = 0;
+    };
+
+    class PassthroughSmoother : public IOutputSmoother {
+    public:
+        Quaterniond update(const Quaterniond &orientation, double) override {
+            return orientation;
+        }
+
+        void reset() override {}
+
+        double addedLatencyMs() const override {
+            return 0.0;
+        }
+    };
+}
+#endif //IMU_VISUALIZER_OUTPUT_SMOOTHER_H
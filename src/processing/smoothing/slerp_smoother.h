@@ -0,0 +1,49 @@
+//
+// Created by Raphael Russo on 12/09/24.
+//
+
+#ifndef IMU_VISUALIZER_SLERP_SMOOTHER_H
+#define IMU_VISUALIZER_SLERP_SMOOTHER_H
+#include "output_smoother.h"
+
+namespace imu_viz {
+    /**
+     * Exponential smoothing on the sphere, out = slerp(out, in, factor).
+     * This is what processIMUData always did with factor 0.7.
+     */
+    class SlerpSmoother : public IOutputSmoother {
+    public:
+        explicit SlerpSmoother(double factor = 0.7)
+                : factor(factor) {}
+
+        Quaterniond update(const Quaterniond &orientation, double dt) override {
+            if (!initialized) {
+                last = orientation;
+                initialized = true;
+                return last;
+            }
+
+            if (dt > 0.0) {
+                samplePeriod += 0.05 * (dt - samplePeriod);
+            }
+            last = last.slerp(factor, orientation);
+            return last;
+        }
+
+        void reset() override {
+            initialized = false;
+        }
+
+        // Group delay of a first order EMA is T * (1 - a) / a
+        double addedLatencyMs() const override {
+            return 1000.0 * samplePeriod * (1.0 - factor) / factor;
+        }
+
+    private:
+        double factor;
+        bool initialized{false};
+        Quaterniond last{Quaterniond::Identity()};
+        double samplePeriod{0.01}; // Tracked since the lag depends on the input rate
+    };
+}
+#endif //IMU_VISUALIZER_SLERP_SMOOTHER_H
@@ -0,0 +1,39 @@
+//
+// Created by Raphael Russo on 12/09/24.
+//
+
+#ifndef IMU_VISUALIZER_SMOOTHER_FACTORY_H
+#define IMU_VISUALIZER_SMOOTHER_FACTORY_H
+#include "output_smoother.h"
+#include "slerp_smoother.h"
+#include "one_euro_smoother.h"
+#include "critically_damped_smoother.h"
+#include <memory>
+#include <stdexcept>
+namespace imu_viz {
+    class OutputSmootherFactory {
+    public:
+        enum class SmootherType {
+            NONE,
+            FIXED_SLERP,
+            ONE_EURO,
+            CRITICALLY_DAMPED
+        };
+
+        static std::unique_ptr<IOutputSmoother> createSmoother(SmootherType type) {
+            switch (type) {
+                case SmootherType::NONE:
+                    return std::make_unique<PassthroughSmoother>();
+                case SmootherType::FIXED_SLERP:
+                    return std::make_unique<SlerpSmoother>();
+                case SmootherType::ONE_EURO:
+                    return std::make_unique<OneEuroSmoother>();
+                case SmootherType::CRITICALLY_DAMPED:
+                    return std::make_unique<CriticallyDampedSmoother>();
+                default:
+                    throw std::runtime_error("Unknown smoother type");
+            }
+        }
+    };
+}
+#endif //IMU_VISUALIZER_SMOOTHER_FACTORY_H
@@ -0,0 +1,135 @@
+//
+// Created by Raphael Russo on 12/13/24.
+//
+
+#ifndef IMU_VISUALIZER_GAP_CONCEALER_H
+#define IMU_VISUALIZER_GAP_CONCEALER_H
+#pragma once
+
+#include "core/imu_data.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace imu_viz {
+
+    /**
+     * Keeps the output moving through short link dropouts.
+     *
+     * While samples are missing, orientation is extrapolated from the last published one with its
+     * angular velocity clamped and decaying, so a dropout mid turn coasts to a stop instead of
+     * freezing, and a long one doesn't spin forever. Those samples are tagged concealed.
+     * When data resumes the filter step is capped (nothing is known about the motion in the gap)
+     * and the difference between the concealed and the real orientation is blended out over
+     * RECONCILE_TIME rather than jumped.
+     * Only meant for unexpected gaps, hosts reset() it and stop calling conceal() on a deliberate disconnect.
+     */
+    class GapConcealer {
+    public:
+        static constexpr double GAP_PERIODS = 3.0;          // Missing this many sample periods is a gap
+        static constexpr double MIN_GAP_MS = 30.0;
+        static constexpr double MAX_CONCEALMENT_MS = 1000.0; // Hold after this, it's an outage not a gap
+        static constexpr double MAX_RATE = 2.0 * M_PI;      // rad/s, clamp on the extrapolated rate
+        static constexpr double RATE_DECAY_TIME = 0.15;     // s, time constant of the coasting rate
+        static constexpr double RECONCILE_TIME = 0.1;       // s, time constant of the blend back
+
+        struct Stats {
+            uint64_t gaps{0};
+            uint64_t concealedSamples{0};
+            bool concealing{false};
+        };
+
+        // Longest step the filter should integrate
+        double clampDeltaTime(double dt) const {
+            return std::min(dt, GAP_PERIODS * periodSeconds);
+        }
+
+        // A real sample about to be published, returns it with any post-gap correction applied
+        OrientationSample onSample(const OrientationSample& sample, double dt) {
+            if (hasSample && dt > 0.0 && dt * 1000.0 < gapThresholdMs()) {
+                periodSeconds += PERIOD_SMOOTHING * (dt - periodSeconds);
+            }
+
+            if (stats.concealing) {
+                // Start from where concealment left the output
+                stats.concealing = false;
+                correction = lastConcealed.orientation * sample.orientation.conjugate();
+                correction.normalize();
+            }
+
+            OrientationSample out = sample;
+            out.orientation = (correction * sample.orientation).normalized();
+            if (dt > 0.0) {
+                const double step = clampDeltaTime(dt);
+                correction = Quaterniond::Identity().slerp(std::exp(-step / RECONCILE_TIME), correction);
+            }
+
+            last = out;
+            hasSample = true;
+            return out;
+        }
+
+        // Called on a host timer, true with out filled while a gap is being concealed
+        bool conceal(int64_t nowNs, OrientationSample& out) {
+            if (!hasSample) return false;
+
+            const double elapsedMs = static_cast<double>(nowNs - last.publishTimeNs) * 1e-6;
+            if (elapsedMs < gapThresholdMs() || elapsedMs > MAX_CONCEALMENT_MS) {
+                return false;
+            }
+
+            if (!stats.concealing) {
+                stats.concealing = true;
+                ++stats.gaps;
+                rate = last.angularVelocity;
+                if (rate.norm() > MAX_RATE) {
+                    rate *= MAX_RATE / rate.norm();
+                }
+            }
+
+            // Integral of rate * exp(-t / T) from 0 to t
+            const double t = elapsedMs * 1e-3;
+            const double decay = std::exp(-t / RATE_DECAY_TIME);
+            const Vector3d rotation = rate * RATE_DECAY_TIME * (1.0 - decay);
+
+            out = last;
+            const double angle = rotation.norm();
+            if (angle > 1e-12) {
+                out.orientation = (last.orientation * Quaterniond(Eigen::AngleAxisd(angle, rotation / angle))).normalized();
+            }
+            out.angularVelocity = rate * decay;
+            out.timestamp = last.timestamp + static_cast<uint64_t>(t * 1e6);
+            out.publishTimeNs = nowNs;
+            out.concealed = true;
+
+            lastConcealed = out;
+            ++stats.concealedSamples;
+            return true;
+        }
+
+        const Stats& getStats() const { return stats; }
+
+        void reset() {
+            hasSample = false;
+            stats.concealing = false;
+            correction = Quaterniond::Identity();
+        }
+
+    private:
+        static constexpr double PERIOD_SMOOTHING = 0.05;
+
+        bool hasSample{false};
+        OrientationSample last;
+        OrientationSample lastConcealed;
+        Vector3d rate{Vector3d::Zero()};
+        Quaterniond correction{Quaterniond::Identity()};
+        double periodSeconds{0.01};
+        Stats stats;
+
+        double gapThresholdMs() const {
+            return std::max(MIN_GAP_MS, GAP_PERIODS * periodSeconds * 1000.0);
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_GAP_CONCEALER_H
@@ -0,0 +1,228 @@
+//
+// Created by Raphael Russo on 12/12/24.
+//
+
+#ifndef IMU_VISUALIZER_JITTER_BUFFER_H
+#define IMU_VISUALIZER_JITTER_BUFFER_H
+#pragma once
+
+#include "core/imu_data.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace imu_viz {
+
+    /**
+     * Adaptive playout buffer for networked streams.
+     *
+     * Each sample gets a source time on a smooth timeline:
+     *   - the device timestamp when the packet carries one,
+     *   - else its sequence number times the nominal period,
+     *   - else the previous sample's source time plus the nominal period.
+     * The nominal period comes from long run arrival statistics, so clumps average out.
+     *
+     * Samples are kept sorted by source time and released at source + clock offset + target delay,
+     * the offset being the least delayed arrival seen (leaking upward to follow clock drift) and the
+     * target delay following the measured jitter: fast attack, slow release.
+     * Released samples are restamped on the source timeline so the filters see an even dt.
+     */
+    class JitterBuffer {
+    public:
+        static constexpr size_t CAPACITY = 256;
+        static constexpr double MIN_DELAY_MS = 2.0;
+        static constexpr double MAX_DELAY_MS = 200.0;
+
+        struct Stats {
+            double targetDelayMs{0.0};
+            double jitterMs{0.0};
+            double nominalPeriodMs{0.0};
+            size_t buffered{0};
+            uint64_t released{0};
+            uint64_t reordered{0};     // Arrived after a sample that came later in the stream
+            uint64_t lateDrops{0};     // Arrived after its slot had already played out
+            uint64_t duplicateDrops{0};
+            uint64_t overflowDrops{0};
+            uint64_t restartDrops{0};  // Still held when a new stream started
+        };
+
+        void push(const IMUData& sample, int64_t arrivalNs) {
+            // Long silence or a device clock going backwards means a new stream, start over
+            if (started && (arrivalNs - lastArrivalNs > RESTART_GAP_NS ||
+                            (sample.deviceTimestamp != 0 &&
+                             static_cast<int64_t>(sample.deviceTimestamp) * 1000 < lastDeviceNs - RESTART_GAP_NS))) {
+                restart();
+            }
+
+            updatePeriod(arrivalNs);
+            const int64_t sourceNs = sourceTime(sample);
+
+            if (!started) {
+                started = true;
+                offsetNs = arrivalNs - sourceNs;
+                baseOffsetNs = offsetNs;
+                releasedAny = false;
+            }
+            lastArrivalNs = arrivalNs;
+
+            // Least delayed arrival defines the offset, the leak lets it follow drift between the clocks
+            offsetNs = std::min(offsetNs + static_cast<int64_t>(periodNs * OFFSET_LEAK), arrivalNs - sourceNs);
+
+            // Lateness of this sample relative to the best case drives the target delay
+            const double lateness = static_cast<double>(arrivalNs - sourceNs - offsetNs);
+            jitterNs += (lateness > jitterNs ? JITTER_ATTACK : JITTER_RELEASE) * (lateness - jitterNs);
+            targetDelayNs = std::clamp(JITTER_MARGIN * jitterNs, MIN_DELAY_MS * 1e6, MAX_DELAY_MS * 1e6);
+
+            if (releasedAny && sourceNs <= lastReleasedNs) {
+                ++stats.lateDrops;
+                return;
+            }
+            insert(sample, sourceNs);
+        }
+
+        // Releases at most one sample whose playout time has come
+        bool pop(int64_t nowNs, IMUData& out) {
+            if (count == 0) return false;
+
+            const Entry& front = entries[head];
+            if (front.sourceNs + offsetNs + static_cast<int64_t>(targetDelayNs) > nowNs) {
+                return false;
+            }
+
+            out = front.data;
+            out.timestamp = static_cast<uint64_t>((front.sourceNs + baseOffsetNs) / 1000);
+            lastReleasedNs = front.sourceNs;
+            releasedAny = true;
+            head = (head + 1) % CAPACITY;
+            --count;
+            ++stats.released;
+            return true;
+        }
+
+        Stats getStats() const {
+            Stats s = stats;
+            s.targetDelayMs = targetDelayNs * 1e-6;
+            s.jitterMs = jitterNs * 1e-6;
+            s.nominalPeriodMs = periodNs * 1e-6;
+            s.buffered = count;
+            return s;
+        }
+
+        // New stream: drop what is held and re-anchor on its clock, the rate and jitter estimates carry on
+        void restart() {
+            stats.restartDrops += count;
+            started = false;
+            head = 0;
+            count = 0;
+            lastSequence = IMUData::NO_SEQUENCE;
+        }
+
+        void reset() {
+            restart();
+            stats = Stats{};
+            periodNs = DEFAULT_PERIOD_NS;
+            jitterNs = 0.0;
+            targetDelayNs = MIN_DELAY_MS * 1e6;
+        }
+
+    private:
+        static constexpr int64_t RESTART_GAP_NS = 1000000000;   // 1 s
+        static constexpr double DEFAULT_PERIOD_NS = 10000000.0; // 100 Hz until measured
+        static constexpr double PERIOD_SMOOTHING = 0.01;
+        static constexpr double OFFSET_LEAK = 0.001;            // Fraction of a period per sample
+        static constexpr double JITTER_ATTACK = 0.2;
+        static constexpr double JITTER_RELEASE = 0.002;
+        static constexpr double JITTER_MARGIN = 1.5;
+
+        struct Entry {
+            IMUData data;
+            int64_t sourceNs;
+        };
+
+        // Ring of entries sorted by source time, oldest at head
+        std::array<Entry, CAPACITY> entries{};
+        size_t head{0};
+        size_t count{0};
+
+        bool started{false};
+        bool releasedAny{false};
+        int64_t lastArrivalNs{0};
+        int64_t lastDeviceNs{0};
+        int64_t lastSourceNs{0};
+        uint32_t lastSequence{IMUData::NO_SEQUENCE};
+        int64_t lastSequenceSourceNs{0};
+        int64_t lastReleasedNs{0};
+        int64_t offsetNs{0};
+        int64_t baseOffsetNs{0};
+
+        double periodNs{DEFAULT_PERIOD_NS};
+        double jitterNs{0.0};
+        double targetDelayNs{MIN_DELAY_MS * 1e6};
+        Stats stats;
+
+        void updatePeriod(int64_t arrivalNs) {
+            if (!started) return;
+            // Mean inter arrival time, bursts of zeros and the long gap after them average out
+            const double interval = static_cast<double>(arrivalNs - lastArrivalNs);
+            periodNs += PERIOD_SMOOTHING * (interval - periodNs);
+            periodNs = std::max(periodNs, 1000.0);
+        }
+
+        int64_t sourceTime(const IMUData& sample) {
+            int64_t sourceNs;
+            if (sample.deviceTimestamp != 0) {
+                sourceNs = static_cast<int64_t>(sample.deviceTimestamp) * 1000;
+                lastDeviceNs = sourceNs;
+            } else if (sample.sequence != IMUData::NO_SEQUENCE) {
+                if (lastSequence == IMUData::NO_SEQUENCE) {
+                    sourceNs = started ? lastSourceNs + static_cast<int64_t>(periodNs) : 0;
+                } else {
+                    // Signed difference so wraparound and reordering both work
+                    const auto steps = static_cast<int32_t>(sample.sequence - lastSequence);
+                    sourceNs = lastSequenceSourceNs + static_cast<int64_t>(steps * periodNs);
+                }
+                if (lastSequence == IMUData::NO_SEQUENCE ||
+                    static_cast<int32_t>(sample.sequence - lastSequence) > 0) {
+                    lastSequence = sample.sequence;
+                    lastSequenceSourceNs = sourceNs;
+                }
+            } else {
+                sourceNs = started ? lastSourceNs + static_cast<int64_t>(periodNs) : 0;
+            }
+            lastSourceNs = std::max(lastSourceNs, sourceNs);
+            return sourceNs;
+        }
+
+        void insert(const IMUData& sample, int64_t sourceNs) {
+            if (count == CAPACITY) {
+                // Consumer stalled, the oldest sample is the least useful one
+                head = (head + 1) % CAPACITY;
+                --count;
+                ++stats.overflowDrops;
+            }
+
+            // Walk back from the tail, almost always zero steps
+            size_t pos = count;
+            while (pos > 0) {
+                const Entry& prev = entries[(head + pos - 1) % CAPACITY];
+                if (prev.sourceNs < sourceNs) break;
+                if (prev.sourceNs == sourceNs) {
+                    ++stats.duplicateDrops;
+                    return;
+                }
+                --pos;
+            }
+            if (pos != count) {
+                ++stats.reordered;
+                for (size_t i = count; i > pos; --i) {
+                    entries[(head + i) % CAPACITY] = entries[(head + i - 1) % CAPACITY];
+                }
+            }
+            entries[(head + pos) % CAPACITY] = Entry{sample, sourceNs};
+            ++count;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_JITTER_BUFFER_H
@@ -0,0 +1,133 @@
+//
+// Created by Raphael Russo on 12/11/24.
+//
+
+#ifndef IMU_VISUALIZER_RESAMPLER_H
+#define IMU_VISUALIZER_RESAMPLER_H
+#pragma once
+
+#include "imu_visualizer/common.h"
+#include <cstdint>
+
+namespace imu_viz {
+
+    struct ResampledSample {
+        uint64_t timestamp;
+        Vector3d acceleration; // Mean over the window
+        Vector3d gyroscope;    // Mean over the window, times dt gives the whole window's rotation
+        double deltaTime;      // Seconds covered by the window
+        uint32_t sourceCount;  // Input samples folded into this one
+    };
+
+    struct ResamplerStats {
+        uint64_t inputSamples{0};
+        uint64_t outputSamples{0};
+        uint64_t mergedSamples{0}; // Folded into a neighbour instead of reaching the filter on their own
+        uint64_t restarts{0};      // Source clock jumped back, e.g. a reconnect or a different transport
+        uint64_t discardedSamples{0}; // Still held when reset() was called
+    };
+
+    /**
+     * Turns an input stream of any rate into filter updates without throwing samples away.
+     * Samples accumulate into a window, the window's mean accel/gyro go to the filter with the
+     * window's full duration as dt, so every gyro reading still contributes to the integration.
+     *
+     * Output rate 0: a window closes on every timestamp advance. Samples sharing a timestamp
+     *                (host stamped bursts) merge into the next window rather than getting dt = 0.
+     * Output rate > 0: a window closes once it spans at least 1 / rate, decimating fast sensors
+     *                  down to a fixed filter rate.
+     *
+     * A timestamp more than RESTART_THRESHOLD_US behind the window start is a new stream on a new
+     * clock (the mock transport counts from 0, TCP uses the system clock) and re-anchors like the
+     * first sample did. Smaller steps back are reordering and merge into the open window. Hosts
+     * should still reset() on connect, a restart within the threshold would hold samples until the
+     * new clock catches up.
+     */
+    class Resampler {
+    public:
+        static constexpr uint64_t RESTART_THRESHOLD_US = 100000; // 100 ms, far more than any reordering
+
+        void setOutputRate(double hz) {
+            outputPeriodUs = hz > 0.0 ? static_cast<uint64_t>(1e6 / hz) : 0;
+        }
+
+        double getOutputRate() const {
+            return outputPeriodUs > 0 ? 1e6 / static_cast<double>(outputPeriodUs) : 0.0;
+        }
+
+        // Returns true and fills out when a window closes
+        bool add(uint64_t timestamp, const Vector3d& accel, const Vector3d& gyro, ResampledSample& out) {
+            ++stats.inputSamples;
+            accelSum += accel;
+            gyroSum += gyro;
+            ++windowCount;
+
+            // First sample only anchors the clock
+            if (!started) {
+                started = true;
+                windowStart = timestamp;
+                return emitWindow(timestamp, 0.0, out);
+            }
+
+            // New source clock, nothing to integrate across the jump. Held samples go out with it
+            if (timestamp + RESTART_THRESHOLD_US < windowStart) {
+                ++stats.restarts;
+                windowStart = timestamp;
+                return emitWindow(timestamp, 0.0, out);
+            }
+
+            // Clock went backwards a little or stood still, nothing to integrate over yet
+            if (timestamp <= windowStart) {
+                return false;
+            }
+
+            const uint64_t span = timestamp - windowStart;
+            if (span < outputPeriodUs) {
+                return false;
+            }
+
+            windowStart = timestamp;
+            return emitWindow(timestamp, static_cast<double>(span) * 1e-6, out);
+        }
+
+        const ResamplerStats& getStats() const { return stats; }
+
+        // Forget the window and the clock, the next sample anchors again. Stats carry on, the held
+        // samples count as discarded so inputSamples == outputSamples + mergedSamples + discardedSamples
+        void reset() {
+            stats.discardedSamples += windowCount;
+            started = false;
+            accelSum.setZero();
+            gyroSum.setZero();
+            windowCount = 0;
+        }
+
+    private:
+        uint64_t outputPeriodUs{0};
+        bool started{false};
+        uint64_t windowStart{0};
+        Vector3d accelSum{Vector3d::Zero()};
+        Vector3d gyroSum{Vector3d::Zero()};
+        uint32_t windowCount{0};
+        ResamplerStats stats;
+
+        bool emitWindow(uint64_t timestamp, double dt, ResampledSample& out) {
+            const double inv = 1.0 / windowCount;
+            out.timestamp = timestamp;
+            out.acceleration = accelSum * inv;
+            out.gyroscope = gyroSum * inv;
+            out.deltaTime = dt;
+            out.sourceCount = windowCount;
+
+            ++stats.outputSamples;
+            stats.mergedSamples += windowCount - 1;
+
+            accelSum.setZero();
+            gyroSum.setZero();
+            windowCount = 0;
+            return true;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_RESAMPLER_H
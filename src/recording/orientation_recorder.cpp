@@ -0,0 +1,71 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#include "orientation_recorder.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace imu_viz {
+    bool OrientationRecorder::open(const std::string& path) {
+        close();
+
+        file.open(path, std::ios::out | std::ios::trunc);
+        if (!file) return false;
+        file << "timestamp_us,qw,qx,qy,qz,wx,wy,wz,concealed\n";
+
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopRequested = false;
+        }
+        running.store(true, std::memory_order_relaxed);
+        writer = std::thread([this]() { writeLoop(); });
+        return true;
+    }
+
+    void OrientationRecorder::close() {
+        if (!writer.joinable()) return;
+
+        running.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopRequested = true;
+        }
+        wake.notify_one();
+        writer.join();
+
+        file.close();
+    }
+
+    void OrientationRecorder::writeLoop() {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        while (!stopRequested) {
+            wake.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_MS));
+            lock.unlock();
+            drain();
+            file.flush();
+            lock.lock();
+        }
+        lock.unlock();
+
+        // Producer has stopped, pick up anything pushed before it saw running go false
+        drain();
+        file.flush();
+    }
+
+    void OrientationRecorder::drain() {
+        OrientationSample sample;
+        char line[192];
+        while (queue.tryPop(sample)) {
+            const Quaterniond& q = sample.orientation;
+            const Vector3d& w = sample.angularVelocity;
+            const int length = std::snprintf(line, sizeof(line), "%llu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d\n",
+                                             static_cast<unsigned long long>(sample.timestamp),
+                                             q.w(), q.x(), q.y(), q.z(), w.x(), w.y(), w.z(),
+                                             sample.concealed ? 1 : 0);
+            file.write(line, length);
+            written.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
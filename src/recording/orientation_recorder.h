@@ -0,0 +1,74 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_ORIENTATION_RECORDER_H
+#define IMU_VISUALIZER_ORIENTATION_RECORDER_H
+#pragma once
+
+#include "core/imu_data.h"
+#include "core/spsc_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace imu_viz {
+
+    /**
+     * Writes published orientations to a CSV file:
+     * timestamp_us,qw,qx,qy,qz,wx,wy,wz,concealed
+     * record() only copies into a ring, formatting and file I/O run on a writer thread so a slow
+     * disk never holds up fusion. Samples arriving while the ring is full are dropped and counted.
+     */
+    class OrientationRecorder {
+    public:
+        static constexpr size_t QUEUE_CAPACITY = 4096; // ~4 s at 1 kHz
+        static constexpr int WRITE_INTERVAL_MS = 50;
+
+        OrientationRecorder() = default;
+        ~OrientationRecorder() { close(); }
+        OrientationRecorder(const OrientationRecorder&) = delete;
+        OrientationRecorder& operator=(const OrientationRecorder&) = delete;
+
+        // Truncates path and starts the writer, false if the file can't be opened
+        bool open(const std::string& path);
+
+        // Writes whatever is still queued, then stops the writer
+        void close();
+
+        bool isOpen() const { return running.load(std::memory_order_relaxed); }
+
+        // Single producer: call from the thread publishing orientations only
+        void record(const OrientationSample& sample) {
+            if (!running.load(std::memory_order_relaxed)) return;
+            if (!queue.tryPush(sample)) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        uint64_t getWritten() const { return written.load(std::memory_order_relaxed); }
+        uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        SpscQueue<OrientationSample, QUEUE_CAPACITY> queue;
+        std::ofstream file;
+        std::thread writer;
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> written{0};
+        std::atomic<uint64_t> dropped{0};
+
+        // Only used to cut the writer's sleep short on close
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        bool stopRequested{false};
+
+        void writeLoop();
+        void drain();
+    };
+}
+
+#endif //IMU_VISUALIZER_ORIENTATION_RECORDER_H
@@ -15,6 +15,10 @@ namespace imu_viz {
 
         running = true;
         mockThread = std::thread(&MockTransport::mockDataLoop, this);
+
+        if (connectionCallback) {
+            connectionCallback(sensorId());
+        }
         return true;
     }
 
@@ -35,6 +39,7 @@ namespace imu_viz {
 
     void MockTransport::mockDataLoop() {
         using namespace std::chrono;
+        IMU_PROFILE_THREAD_NAME("mock transport");
         auto start = high_resolution_clock ::now();
 
         while (running) {
@@ -43,6 +48,8 @@ namespace imu_viz {
 
             IMUData data;
             data.timestamp = timestamp;
+            data.arrivalTimeNs = steadyNowNs();
+            data.decodeTimeNs = data.arrivalTimeNs; // Nothing to decode
 
             double t = timestamp * 1e-6;
             // Simple Motion
@@ -69,11 +76,12 @@ namespace imu_viz {
 
 
 
+            TransportCounters::bump(counters.packets);
             if (dataCallback) {
                 dataCallback(data);
             }
 
-            std::this_thread::sleep_for(milliseconds(10));
+            std::this_thread::sleep_for(period);
         }
     }
 }
@@ -9,6 +9,7 @@
 #include "transport_interface.h"
 #include <thread>
 #include <atomic>
+#include <chrono>
 
 namespace imu_viz {
     class MockTransport : public ITransport {
@@ -19,10 +20,15 @@ namespace imu_viz {
         bool connect() override;
         bool disconnect() override;
         bool isConnected() const override;
+        std::string sensorId() const override { return "mock"; }
+
+        // Takes effect on the next connect
+        void setSampleRate(double hz) { period = std::chrono::microseconds(static_cast<int64_t>(1e6 / hz)); }
 
     private:
         std::atomic<bool> running{false};
         std::thread mockThread;
+        std::chrono::microseconds period{10000}; // 100 Hz
         void mockDataLoop();
     };
 }
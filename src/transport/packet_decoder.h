@@ -0,0 +1,163 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_PACKET_DECODER_H
+#define IMU_VISUALIZER_PACKET_DECODER_H
+#pragma once
+
+#include "transport_interface.h"
+#include "core/imu_data.h"
+#include "core/clock.h"
+#include "core/logger.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace imu_viz {
+
+    /**
+     * Reassembles the board's binary packets from a byte stream, shared by the serial and TCP transports.
+     *
+     * Packets
+     * 0: start marker, 0xAA or 0xAB for firmware that stamps its samples
+     * 0xAB only: 4 byte sequence, 4 byte device time (us)
+     * then 3 floats from the accelerometer, 3 floats from the gyroscope
+     * last: end marker
+     */
+    class PacketDecoder {
+    public:
+        static constexpr uint8_t PACKET_START = 0xAA;
+        static constexpr uint8_t PACKET_START_TIMED = 0xAB;
+        static constexpr uint8_t PACKET_END = 0x55;
+        static constexpr size_t PACKET_SIZE = 26;        // 1 start + 24 data + 1 end
+        static constexpr size_t TIMED_PACKET_SIZE = 34;  // 1 start + 4 sequence + 4 device time + 24 data + 1 end
+
+        // Counts into the owning transport's counters
+        explicit PacketDecoder(TransportCounters& counters, bool acceptTimed = true)
+                : counters(counters), acceptTimed(acceptTimed) {}
+
+        /**
+         * Appends one read and calls onPacket(const IMUData&) for every complete packet in it.
+         * Every packet in the read shares readTimeNs as its arrival time. The consumed bytes are
+         * dropped once per read rather than once per packet.
+         */
+        template <typename Callback>
+        void feed(const char* data, size_t size, int64_t readTimeNs, Callback&& onPacket) {
+            TransportCounters::bump(counters.bytes, size);
+            buffer.insert(buffer.end(), data, data + size);
+
+            size_t offset = 0;
+            while (buffer.size() - offset >= PACKET_SIZE) {
+                const size_t start = findPacketStart(offset);
+                if (start != offset) TransportCounters::bump(counters.resyncs);
+                offset = start;
+                if (offset == buffer.size()) break;
+
+                const bool timed = static_cast<uint8_t>(buffer[offset]) == PACKET_START_TIMED;
+                const size_t packetSize = timed ? TIMED_PACKET_SIZE : PACKET_SIZE;
+                if (buffer.size() - offset < packetSize) {
+                    break; // Wait for the rest
+                }
+
+                IMUData sample;
+                if (decode(buffer.data() + offset, timed, readTimeNs, sample)) {
+                    offset += packetSize;
+                    TransportCounters::bump(counters.packets);
+                    onPacket(sample);
+                } else {
+                    ++offset;
+                }
+            }
+
+            buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+        }
+
+        // New connection, the device clock may have restarted
+        void reset() {
+            buffer.clear();
+            deviceTimeInitialized = false;
+        }
+
+    private:
+        TransportCounters& counters;
+        bool acceptTimed;
+        std::vector<char> buffer; // Grows to the largest read once, then reused
+
+        // The device clock is 32 bit us and wraps every ~71 minutes, unwrapped here
+        bool deviceTimeInitialized{false};
+        uint32_t lastDeviceTime{0};
+        uint64_t unwrappedDeviceTime{0};
+
+        size_t findPacketStart(size_t from) const {
+            for (size_t i = from; i < buffer.size(); ++i) {
+                const auto byte = static_cast<uint8_t>(buffer[i]);
+                if (byte == PACKET_START || (acceptTimed && byte == PACKET_START_TIMED)) return i;
+            }
+            return buffer.size();
+        }
+
+        uint64_t unwrapDeviceTime(uint32_t deviceTime) {
+            if (!deviceTimeInitialized) {
+                // Offset so it can never be 0, which means "no device time"
+                unwrappedDeviceTime = (uint64_t{1} << 32) + deviceTime;
+                deviceTimeInitialized = true;
+            } else {
+                // Signed step so a reordered packet steps back instead of wrapping forward
+                unwrappedDeviceTime += static_cast<int32_t>(deviceTime - lastDeviceTime);
+            }
+            lastDeviceTime = deviceTime;
+            return unwrappedDeviceTime;
+        }
+
+        bool decode(const char* packet, bool timed, int64_t readTimeNs, IMUData& data) {
+            const size_t size = timed ? TIMED_PACKET_SIZE : PACKET_SIZE;
+
+            // Verify packet markers, a start byte inside the payload lands here and we resync one byte on
+            if (static_cast<uint8_t>(packet[size - 1]) != PACKET_END) {
+                TransportCounters::bump(counters.framingErrors);
+                IMU_LOG_RATE_LIMITED(WARN, 1000, "Invalid packet markers: {} {} ({} rejected so far)",
+                                     LogHex{static_cast<uint8_t>(packet[0])},
+                                     LogHex{static_cast<uint8_t>(packet[size - 1])},
+                                     counters.framingErrors.load(std::memory_order_relaxed));
+                return false;
+            }
+
+            data.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+            data.arrivalTimeNs = readTimeNs;
+
+            size_t offset = 1;
+            if (timed) {
+                uint32_t sequence;
+                uint32_t deviceTime;
+                memcpy(&sequence, packet + 1, 4);
+                memcpy(&deviceTime, packet + 5, 4);
+                data.sequence = sequence;
+                data.deviceTimestamp = unwrapDeviceTime(deviceTime);
+                offset = 9;
+            }
+
+            // Extract accelerometer data
+            float accel[3];
+            memcpy(accel, packet + offset, 12);
+            data.acceleration = Vector3d(accel[0], accel[1], accel[2]);
+
+            // Extract gyroscope data
+            float gyro[3];
+            memcpy(gyro, packet + offset + 12, 12);
+            data.gyroscope = Vector3d(gyro[0], gyro[1], gyro[2]);
+
+            // About once a second from the stock 100 Hz firmware, per packet console output capped ingest
+            IMU_LOG_EVERY_N(DEBUG, 100, "Received IMU data: Accel: {} {} {} Gyro: {} {} {}",
+                            accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2]);
+
+            data.decodeTimeNs = steadyNowNs();
+            return true;
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_PACKET_DECODER_H
@@ -48,8 +48,12 @@ namespace imu_viz {
             return false;
         }
 
-        buffer.clear();
+        decoder.reset();
         timeoutTimer.start();
+
+        if (connectionCallback) {
+            connectionCallback(sensorId());
+        }
         return true;
     }
 
@@ -57,7 +61,7 @@ namespace imu_viz {
         if (!port->isOpen()) return true;
 
         port->close();
-        buffer.clear();
+        decoder.reset();
         timeoutTimer.stop();
         return true;
     }
@@ -66,60 +70,23 @@ namespace imu_viz {
         return port->isOpen();
     }
 
-    void SerialTransport::handleReadyRead() {
-        timeoutTimer.start();  // Reset timeout
-        buffer.append(port->readAll());
-
-        // Process complete packets
-        while (buffer.size() >= PACKET_SIZE) {
-            int start = buffer.indexOf(PACKET_START);
-            if (start < 0) {
-                buffer.clear();
-                break;
-            }
-
-            if (start > 0) {
-                buffer.remove(0, start);
-            }
-
-            if (buffer.size() >= PACKET_SIZE) {
-                QByteArray packet = buffer.left(PACKET_SIZE);
-                if (processPacket(packet)) {
-                    buffer.remove(0, PACKET_SIZE);
-                } else {
-                    buffer.remove(0, 1);
-                }
-            }
-        }
+    std::string SerialTransport::sensorId() const {
+        return "serial-" + portName.toStdString();
     }
 
-    bool SerialTransport::processPacket(const QByteArray& packet) {
-        // Verify packet markers
-        if (packet[0] != PACKET_START || packet[PACKET_SIZE-1] != PACKET_END) {
-            return false;
-        }
-
-        // Create IMU data struct
-        IMUData data;
-        data.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::system_clock::now().time_since_epoch()
-        ).count();
-
-        // Extract accelerometer data
-        float accel[3];
-        memcpy(accel, packet.data() + 1, 12);
-        data.acceleration = Vector3d(accel[0], accel[1], accel[2]);
-
-        // Extract gyroscope data
-        float gyro[3];
-        memcpy(gyro, packet.data() + 13, 12);
-        data.gyroscope = Vector3d(gyro[0], gyro[1], gyro[2]);
-
-        if (dataCallback) {
-            dataCallback(data);
-        }
+    void SerialTransport::handleReadyRead() {
+        IMU_PROFILE_ZONE("SerialTransport::handleReadyRead");
+        timeoutTimer.start();  // Reset timeout
 
-        return true;
+        // Every packet in this read shares the read time
+        const int64_t readTimeNs = steadyNowNs();
+        const QByteArray data = port->readAll();
+        decoder.feed(data.constData(), static_cast<size_t>(data.size()), readTimeNs,
+                     [this](const IMUData& sample) {
+                         if (dataCallback) {
+                             dataCallback(sample);
+                         }
+                     });
     }
 
     void SerialTransport::handleError(QSerialPort::SerialPortError error) {
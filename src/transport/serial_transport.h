@@ -7,6 +7,7 @@
 #pragma once
 
 #include "transport_interface.h"
+#include "packet_decoder.h"
 #include "core/imu_data.h"
 #include <QTimer>
 #include <memory>
@@ -23,6 +24,7 @@ namespace imu_viz {
         bool connect() override;
         bool disconnect() override;
         bool isConnected() const override;
+        std::string sensorId() const override;
 
         // Config
         void setPort(const QString& portName);
@@ -39,34 +41,13 @@ namespace imu_viz {
     private:
         std::unique_ptr<QSerialPort> port;
         QTimer timeoutTimer;
-        QByteArray buffer;
+        PacketDecoder decoder{counters, false}; // This firmware only sends untimed packets
 
         // Config
         QString portName;
         qint32 baudRate{115200};
 
-        /**
-         * Packets
-         * 0: start marker
-         * 1-12: 3 floats from accelerometer
-         * 13-24: 3 floats from gyroscope
-         * 25: End marker
-         */
-
-        // Constants
-        static constexpr uint8_t PACKET_START = 0xAA;
-        static constexpr uint8_t PACKET_END = 0x55;
-        static constexpr  size_t PACKET_SIZE = 26; // 24 bytes, 2 markers
-
-        // Packet processing
-        bool processPacket(const QByteArray& packet);
         uint8_t calculateChecksum(const uint8_t* data, size_t length) const;
-
-
-
-
-
-
     };
 }
 
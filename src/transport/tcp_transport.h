@@ -5,6 +5,8 @@
 #ifndef IMU_VISUALIZER_TCP_TRANSPORT_H
 #define IMU_VISUALIZER_TCP_TRANSPORT_H
 #include "transport_interface.h"
+#include "packet_decoder.h"
+#include "core/logger.h"
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QHostAddress>
@@ -38,7 +40,7 @@ namespace imu_viz {
                 return false;
             }
 
-            qDebug() << "Server listening on port" << port;
+            IMU_LOG_INFO("Server listening on port {}", port);
             return true;
         }
 
@@ -57,6 +59,21 @@ namespace imu_viz {
                    clientSocket->state() == QAbstractSocket::ConnectedState;
         }
 
+        // Keyed on the board's address, the source port changes every connection
+        std::string sensorId() const override {
+            if (!clientSocket) return "tcp";
+            return "tcp-" + clientSocket->peerAddress().toString().toStdString();
+        }
+
+        bool isNetworked() const override {
+            return true;
+        }
+
+        // Pico board is mounted with x inverted (found in testing)
+        Matrix3d axisMapping() const override {
+            return Vector3d(-1.0, 1.0, 1.0).asDiagonal();
+        }
+
         void setPort(quint16 newPort) {
             if (!server->isListening()) {
                 port = newPort;
@@ -88,8 +105,7 @@ namespace imu_viz {
             clientSocket = server->nextPendingConnection();
             if (!clientSocket) return;
 
-            qDebug() << "New client connected from" <<
-                     clientSocket->peerAddress().toString();
+            IMU_LOG_INFO("New client connected from {}", clientSocket->peerAddress().toString().toStdString());
 
             QObject::connect(clientSocket, &QTcpSocket::disconnected,
                     this, &TCPTransport::handleClientDisconnected);
@@ -98,11 +114,15 @@ namespace imu_viz {
             QObject::connect(clientSocket, &QTcpSocket::readyRead,
                     this, &TCPTransport::handleReadyRead);
 
-            buffer.clear();
+            decoder.reset();
+
+            if (connectionCallback) {
+                connectionCallback(sensorId());
+            }
         }
 
         void handleClientDisconnected() {
-            qDebug() << "Client disconnected";
+            IMU_LOG_INFO("Client disconnected");
             if (clientSocket) {
                 clientSocket->deleteLater();
                 clientSocket = nullptr;
@@ -119,78 +139,25 @@ namespace imu_viz {
         }
 
         void handleReadyRead() {
+            IMU_PROFILE_ZONE("TCPTransport::handleReadyRead");
             if (!clientSocket) return;
 
-            buffer.append(clientSocket->readAll());
-
-            // Process complete packets
-            while (buffer.size() >= PACKET_SIZE) {
-                int start = buffer.indexOf(PACKET_START);
-                if (start < 0) {
-                    buffer.clear();
-                    break;
-                }
-
-                if (start > 0) {
-                    buffer.remove(0, start);
-                }
-
-                if (buffer.size() >= PACKET_SIZE) {
-                    QByteArray packet = buffer.left(PACKET_SIZE);
-                    if (processPacket(packet)) {
-                        buffer.remove(0, PACKET_SIZE);
-                    } else {
-                        buffer.remove(0, 1);
-                    }
-                }
-            }
+            // Every packet in this read shares the read time
+            const int64_t readTimeNs = steadyNowNs();
+            const QByteArray data = clientSocket->readAll();
+            decoder.feed(data.constData(), static_cast<size_t>(data.size()), readTimeNs,
+                         [this](const IMUData& sample) {
+                             if (dataCallback) {
+                                 dataCallback(sample);
+                             }
+                         });
         }
 
     private:
-        static constexpr char PACKET_START = 0xAA;
-        static constexpr char PACKET_END = 0x55;
-        static constexpr int PACKET_SIZE = 26;  // 1 start + 24 data + 1 end
-
         QTcpServer* server;
         QTcpSocket* clientSocket;
         quint16 port;
-        QByteArray buffer;
-
-        bool processPacket(const QByteArray& packet) {
-            // Verify packet markers
-            if (packet[0] != PACKET_START || packet[PACKET_SIZE-1] != PACKET_END) {
-                qDebug() << "Invalid packet markers:"
-                         << QString("0x%1").arg(packet[0], 2, 16, QChar('0'))
-                         << QString("0x%1").arg(packet[PACKET_SIZE-1], 2, 16, QChar('0'));
-                return false;
-            }
-
-            // Create IMU data struct
-            IMUData data;
-            data.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-                    std::chrono::system_clock::now().time_since_epoch()
-            ).count();
-
-            // Extract accelerometer data
-            float accel[3];
-            memcpy(accel, packet.data() + 1, 12);
-            data.acceleration = Vector3d(-accel[0], accel[1], accel[2]); // Invert x after testing
-
-            // Extract gyroscope data
-            float gyro[3];
-            memcpy(gyro, packet.data() + 13, 12);
-            data.gyroscope = Vector3d(-gyro[0], gyro[1], gyro[2]);
-
-            qDebug() << "Received IMU data:"
-                     << "Accel:" << data.acceleration.x() << data.acceleration.y() << data.acceleration.z()
-                     << "Gyro:" << data.gyroscope.x() << data.gyroscope.y() << data.gyroscope.z();
-
-            if (dataCallback) {
-                dataCallback(data);
-            }
-
-            return true;
-        }
+        PacketDecoder decoder{counters};
     };
 
 } // namespace imu_viz
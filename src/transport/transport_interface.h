@@ -6,28 +6,60 @@
 #define IMU_VISUALIZER_TRANSPORT_INTERFACE_H
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <functional>
 #include "core/imu_data.h"
+#include "core/clock.h"
+#include "core/profiler.h"
 
 namespace imu_viz {
+    // Written by the thread reading the transport only, read by the metrics scrape from anywhere
+    struct TransportCounters {
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> framingErrors{0}; // Start marker found but the packet didn't end right
+        std::atomic<uint64_t> resyncs{0};       // Times bytes were skipped to find the next start marker
+
+        // Single writer, so no locked read-modify-write
+        static void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    };
+
     class ITransport {
     public:
         virtual ~ITransport() = default;
 
         using DataCallback = std::function<void(const IMUData&)>;
         using ErrorCallback = std::function<void(const std::string&)>;
+        using ConnectionCallback = std::function<void(const std::string& sensorId)>;
 
         virtual bool connect() = 0;
         virtual bool disconnect() = 0;
         virtual bool isConnected() const = 0;
 
+        // Remap from the sensor's axes to the body frame, folded into the calibration transform
+        virtual Matrix3d axisMapping() const { return Matrix3d::Identity(); }
+
+        // Arrives over a network with bursty delivery, the processor buffers these to smooth the cadence
+        virtual bool isNetworked() const { return false; }
+
+        // Identifies the physical sensor so per sensor state (calibration profiles) can follow it
+        virtual std::string sensorId() const = 0;
+
         void setDataCallback(DataCallback cb) { dataCallback = std::move(cb); }
         void setErrorCallback(ErrorCallback cb) { errorCallback = std::move(cb); }
+        void setConnectionCallback(ConnectionCallback cb) { connectionCallback = std::move(cb); }
+
+        const TransportCounters& getCounters() const { return counters; }
 
     protected:
         DataCallback dataCallback;
         ErrorCallback errorCallback;
+        ConnectionCallback connectionCallback; // Called once a sensor is actually streaming
+        TransportCounters counters;
     };
 }
 
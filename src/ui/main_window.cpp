@@ -16,8 +16,23 @@
 #include <QSlider>
 #include <QFormLayout>
 #include <QComboBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QFontDatabase>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QFileDialog>
+#include "core/logger.h"
+#include "core/profiler.h"
 #include "transport/tcp_transport.h"
+#include "monitoring/engine_metrics.h"
+#include "visualization/signal_plot_widget.h"
 #include <QTimer>
+#include <QStandardPaths>
+#include <QListWidget>
+#include <QTime>
 
 namespace imu_viz {
 
@@ -26,41 +41,89 @@ namespace imu_viz {
             , transport(std::make_unique<MockTransport>())
             , dataProcessor(new DataProcessor(this))
             , glWidget(new GLWidget(this))
+            , calibrationStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                                       .append("/calibration").toStdString())
     {
         setCentralWidget(glWidget);
         setupUI();
         setupMenus();
         setupDockWidgets();
         setupDataPipeline();
-
+        setupMetrics();
 
         statusBar()->showMessage("Ready");
+
+        // Start with whatever profile the default transport's sensor had last time
+        loadCalibrationFor(transport->sensorId());
     }
 
     void MainWindow::setupDataPipeline() {
         // Connect transport to data processor
         transport->setDataCallback([this](const IMUData& data) {
-            // QueuedConnection for thread safety since transport runs in separate thread
-            QMetaObject::invokeMethod(this->dataProcessor, "processIMUData",
-                                      Qt::QueuedConnection,
-                                      Q_ARG(IMUData, data));
+            // Lock free hand off, the transport may run on its own thread
+            dataProcessor->submitIMUData(data);
+        });
+
+        transport->setConnectionCallback([this](const std::string& sensorId) {
+            // New stream, possibly on a new clock. Takes the engine's lock, so fine from any thread
+            dataProcessor->resetStream();
+            QMetaObject::invokeMethod(this, [this, sensorId]() {
+                loadCalibrationFor(sensorId);
+            }, Qt::QueuedConnection);
         });
 
+        // Counted and summarised with the processing faults, a flapping link can't flood the GUI
         transport->setErrorCallback([this](const std::string& error) {
-            QMetaObject::invokeMethod(this, "handleError",
-                                      Qt::QueuedConnection,
-                                      Q_ARG(std::string, error));
+            dataProcessor->getErrorAggregator().record(ErrorCategory::TRANSPORT, error);
         });
 
-        // Connect data processor to GL widget
-        connect(dataProcessor, &DataProcessor::newOrientation,
-                glWidget, &GLWidget::updateOrientation);
+        // Transport specific axis remap is applied along with calibration
+        dataProcessor->setAxisMapping(transport->axisMapping());
 
-        connect(dataProcessor, &DataProcessor::errorOccurred,
-                this, [this](const QString& error) {
-                    statusBar()->showMessage("Error: " + error, 3000);
-                });
+        // Smooth out WiFi clumping, local transports deliver evenly and skip the delay
+        dataProcessor->setJitterBufferEnabled(transport->isNetworked());
+
+        // Nothing timed against the previous transport's clock carries over, and nothing streams until connect
+        dataProcessor->stopStream();
+
+        // GL widget reads the newest orientation each frame rather than handling every sample
+        glWidget->setOrientationSource(&dataProcessor->getLatestOrientation());
+        glWidget->setOrientationHistory(&dataProcessor->getOrientationHistory(FusionEngine::HistoryTap::TRAIL));
+        glWidget->setLatencyMonitor(&dataProcessor->getLatencyMonitor());
+    }
 
+    void MainWindow::setupMetrics() {
+        // Everything here reads atomics, the scrape runs on the GUI thread next to the transport swap
+        metrics.addCollector(this, [this](MetricsRegistry::Writer& out) {
+            const char* kind = "mock";
+            if (transportType == TransportType::TCP) kind = "tcp";
+            if (transportType == TransportType::SERIAL) kind = "serial";
+            writeTransportMetrics(out, kind, transport->getCounters());
+            writeEngineMetrics(out, *dataProcessor);
+            out.summary("imu_viz_frame_time_seconds", "Time between paints", {}, glWidget->getFrameTimes().snapshot());
+            out.summary("imu_viz_frame_cpu_seconds", "Time spent in paintGL", {}, glWidget->getCpuFrameTimes().snapshot());
+            if (glWidget->hasGpuTiming()) {
+                out.summary("imu_viz_frame_gpu_seconds", "GPU time per frame", {}, glWidget->getGpuFrameTimes().snapshot());
+            }
+            out.counter("imu_viz_frames_total", "Frames painted", {}, static_cast<double>(glWidget->getFramesPainted()));
+            out.gauge("imu_viz_shader_setup_seconds", "Shader compile or cached binary load at startup",
+                      {}, glWidget->getShaderSetupNs() * 1e-9);
+            out.gauge("imu_viz_time_to_first_frame_seconds", "Window construction to the first buffer swap",
+                      {}, glWidget->getTimeToFirstFrameNs() * 1e-9);
+        });
+    }
+
+    bool MainWindow::startMetricsServer(quint16 port) {
+        if (!metricsServer) {
+            metricsServer = new MetricsServer(metrics, this);
+        }
+        if (!metricsServer->start(port)) {
+            appendError("Metrics endpoint failed to listen on localhost:" + QString::number(port) + ": "
+                        + metricsServer->errorString());
+            return false;
+        }
+        IMU_LOG_INFO("Metrics at http://localhost:{}/metrics", metricsServer->serverPort());
+        return true;
     }
 
     void MainWindow::setupUI() {
@@ -98,6 +161,7 @@ namespace imu_viz {
                     }
 
                     auto type = transportCombo->currentData().value<TransportType>();
+                    transportType = type;
                     switch (type) {
                         case TransportType::MOCK:
                             transport = std::make_unique<MockTransport>();
@@ -134,6 +198,7 @@ namespace imu_viz {
                 }
             } else {
                 transport->disconnect();
+                dataProcessor->stopStream();
                 if (tcpTransport) {
                     connectButton->setText("Start Server");
                     infoLabel->clear();
@@ -149,6 +214,16 @@ namespace imu_viz {
         toolbar->addSeparator();
 
         // Calibration control
+        auto calibrationModeCombo = new QComboBox(this);
+        calibrationModeCombo->addItem("Stationary", QVariant::fromValue(DataProcessor::CalibrationMode::STATIONARY));
+        calibrationModeCombo->addItem("Multi-pose", QVariant::fromValue(DataProcessor::CalibrationMode::MULTI_POSE));
+        toolbar->addWidget(calibrationModeCombo);
+        connect(calibrationModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+                this, [this, calibrationModeCombo](int) {
+                    dataProcessor->setCalibrationMode(
+                            calibrationModeCombo->currentData().value<DataProcessor::CalibrationMode>());
+                });
+
         auto calibrateButton = new QPushButton("Calibrate", this);
         calibrateButton->setCheckable(true);
         toolbar->addWidget(calibrateButton);
@@ -162,10 +237,43 @@ namespace imu_viz {
             }
         });
 
+        // Persist every new calibration for the sensor it was captured on
+        connect(dataProcessor, &DataProcessor::newCalibrationData,
+                this, [this](const CalibrationData& calibration) {
+                    if (!calibrationStore.save(currentSensorId, calibration)) {
+                        statusBar()->showMessage("Could not save calibration profile", 3000);
+                    }
+                });
+
+        // Live convergence while calibrating
+        connect(dataProcessor, &DataProcessor::calibrationProgress,
+                this, [this](quint64 samples, double accelStdError, double gyroStdError, bool converged) {
+                    statusBar()->showMessage(QString("Calibrating: %1 samples, accel ±%2 m/s², gyro ±%3 rad/s%4")
+                                                     .arg(samples)
+                                                     .arg(accelStdError, 0, 'g', 2)
+                                                     .arg(gyroStdError, 0, 'g', 2)
+                                                     .arg(converged ? " - converged, stop when ready" : ""));
+                });
+
+        connect(dataProcessor, &DataProcessor::calibrationPoseProgress,
+                this, [this](int poses, int requiredPoses, bool stationary) {
+                    statusBar()->showMessage(QString("Calibrating: %1/%2 poses captured, %3")
+                                                     .arg(poses)
+                                                     .arg(requiredPoses)
+                                                     .arg(stationary ? "hold still..." : "move to a new orientation"));
+                });
+
+        connect(dataProcessor, &DataProcessor::calibrationFitQuality,
+                this, [this](double rmsResidual, bool fullFit) {
+                    statusBar()->showMessage(QString("Calibration updated (%1), residual %2 m/s²")
+                                                     .arg(fullFit ? "full ellipsoid" : "per axis scale")
+                                                     .arg(rmsResidual, 0, 'g', 3), 5000);
+                });
+
 
         auto resetButton = new QPushButton("Reset Orientation", this);
         toolbar->addWidget(resetButton);
-        connect(resetButton, &QPushButton::clicked, dataProcessor, &DataProcessor::resetOrientation);
+        connect(resetButton, &QPushButton::clicked, this, [this]() { dataProcessor->resetOrientation(); });
 
         // Add visualization controls
         toolbar->addSeparator();
@@ -189,6 +297,21 @@ namespace imu_viz {
         auto connectAction = fileMenu->addAction("&Connect");
         connect(connectAction, &QAction::triggered, this, &MainWindow::handleConnect);
 
+#ifdef IMU_VIZ_PROFILING
+        // Whatever the per-thread rings still hold, open in chrome://tracing or ui.perfetto.dev
+        auto traceAction = fileMenu->addAction("Export Profile &Trace...");
+        connect(traceAction, &QAction::triggered, this, [this]() {
+            const QString path = QFileDialog::getSaveFileName(this, "Export Profile Trace",
+                                                              "imu_trace.json", "Trace files (*.json)");
+            if (path.isEmpty()) return;
+            if (Profiler::dumpChromeTrace(path.toStdString())) {
+                statusBar()->showMessage("Profile trace written to " + path, 3000);
+            } else {
+                appendError("Could not write profile trace to " + path);
+            }
+        });
+#endif
+
         fileMenu->addSeparator();
 
         auto exitAction = fileMenu->addAction("E&xit");
@@ -235,15 +358,351 @@ namespace imu_viz {
         cameraLayout->addLayout(speedLayout);
 
         layout->addWidget(cameraGroup);
+
+        // Input resampling, fast sensors are averaged down instead of dropped
+        auto samplingGroup = new QGroupBox("Sampling", controlWidget);
+        auto samplingLayout = new QFormLayout(samplingGroup);
+
+        auto filterRateSpin = new QSpinBox(samplingGroup);
+        filterRateSpin->setRange(0, 10000);
+        filterRateSpin->setSingleStep(50);
+        filterRateSpin->setSuffix(" Hz");
+        filterRateSpin->setSpecialValueText("Every sample");
+        samplingLayout->addRow("Filter Rate:", filterRateSpin);
+        connect(filterRateSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+                this, [this](int value) { dataProcessor->setFilterRate(value); });
+
+        auto mergedLabel = new QLabel(samplingGroup);
+        samplingLayout->addRow("Merged:", mergedLabel);
+
+        auto jitterLabel = new QLabel(samplingGroup);
+        samplingLayout->addRow("Jitter Buffer:", jitterLabel);
+
+        auto gapLabel = new QLabel(samplingGroup);
+        samplingLayout->addRow("Gaps:", gapLabel);
+
+        layout->addWidget(samplingGroup);
+
+        // Output smoothing, jitter against added lag
+        auto smoothingGroup = new QGroupBox("Output Smoothing", controlWidget);
+        auto smoothingLayout = new QFormLayout(smoothingGroup);
+
+        using SmootherType = OutputSmootherFactory::SmootherType;
+        auto smootherCombo = new QComboBox(smoothingGroup);
+        smootherCombo->addItem("None", QVariant::fromValue(SmootherType::NONE));
+        smootherCombo->addItem("Fixed Slerp", QVariant::fromValue(SmootherType::FIXED_SLERP));
+        smootherCombo->addItem("One Euro", QVariant::fromValue(SmootherType::ONE_EURO));
+        smootherCombo->addItem("Critically Damped", QVariant::fromValue(SmootherType::CRITICALLY_DAMPED));
+        smootherCombo->setCurrentIndex(1); // Matches the processor's default
+        smoothingLayout->addRow("Smoother:", smootherCombo);
+
+        auto latencyLabel = new QLabel(smoothingGroup);
+        smoothingLayout->addRow("Added Latency:", latencyLabel);
+
+        connect(smootherCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+                this, [this, smootherCombo](int) {
+                    dataProcessor->setSmootherType(smootherCombo->currentData().value<SmootherType>());
+                });
+
+        layout->addWidget(smoothingGroup);
+
+        // Render time prediction, hides sample age + smoothing lag + frame time
+        auto predictionGroup = new QGroupBox("Prediction", controlWidget);
+        auto predictionLayout = new QFormLayout(predictionGroup);
+
+        auto horizonSpin = new QSpinBox(predictionGroup);
+        horizonSpin->setRange(0, 200);
+        horizonSpin->setSuffix(" ms");
+        horizonSpin->setSpecialValueText("Off");
+        horizonSpin->setValue(static_cast<int>(OrientationPredictor::DEFAULT_HORIZON_MS));
+        predictionLayout->addRow("Horizon:", horizonSpin);
+        connect(horizonSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+                glWidget, [this](int value) { glWidget->setPredictionHorizon(value); });
+
+        auto residualLabel = new QLabel(predictionGroup);
+        predictionLayout->addRow("Residual Error:", residualLabel);
+
+        // Samples the renderer never drew because a newer one replaced them first
+        auto coalescedLabel = new QLabel(predictionGroup);
+        predictionLayout->addRow("Coalesced:", coalescedLabel);
+
+        layout->addWidget(predictionGroup);
+
+        // Frames are drawn only when something changed, capped here
+        auto renderingGroup = new QGroupBox("Rendering", controlWidget);
+        auto renderingLayout = new QFormLayout(renderingGroup);
+
+        auto fpsCapSpin = new QSpinBox(renderingGroup);
+        fpsCapSpin->setRange(0, 240);
+        fpsCapSpin->setSuffix(" fps");
+        fpsCapSpin->setSpecialValueText("Display");
+        fpsCapSpin->setValue(glWidget->getFrameRateCap());
+        renderingLayout->addRow("Frame Cap:", fpsCapSpin);
+        connect(fpsCapSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+                glWidget, [this](int value) { glWidget->setFrameRateCap(value); });
+
+        auto idleCheck = new QCheckBox("Slow down when nothing changes", renderingGroup);
+        idleCheck->setChecked(true);
+        renderingLayout->addRow(idleCheck);
+        connect(idleCheck, &QCheckBox::toggled, glWidget, [this](bool checked) { glWidget->setIdleEnabled(checked); });
+
+        // The old always-repaint loop, to compare frame cost against
+        auto continuousCheck = new QCheckBox("Redraw every vsync", renderingGroup);
+        renderingLayout->addRow(continuousCheck);
+        connect(continuousCheck, &QCheckBox::toggled,
+                glWidget, [this](bool checked) { glWidget->setContinuousRendering(checked); });
+
+        // One instanced draw for all of them, see GLWidget::setBodyCount
+        auto bodyCountSpin = new QSpinBox(renderingGroup);
+        bodyCountSpin->setRange(1, GLWidget::MAX_BODIES);
+        bodyCountSpin->setValue(glWidget->getBodyCount());
+        renderingLayout->addRow("Bodies:", bodyCountSpin);
+        connect(bodyCountSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+                glWidget, [this](int value) { glWidget->setBodyCount(value); });
+
+        // Axis tip history, every sample goes into the trail so the engine only queues them while it's shown
+        auto trailSpin = new QSpinBox(renderingGroup);
+        trailSpin->setRange(0, static_cast<int>(GLWidget::MAX_TRAIL_SECONDS));
+        trailSpin->setSuffix(" s");
+        trailSpin->setSpecialValueText("Off");
+        trailSpin->setValue(static_cast<int>(glWidget->getTrailLength()));
+        renderingLayout->addRow("Trail:", trailSpin);
+        connect(trailSpin, QOverload<int>::of(&QSpinBox::valueChanged), glWidget, [this](int value) {
+            dataProcessor->setHistoryEnabled(FusionEngine::HistoryTap::TRAIL, value > 0);
+            glWidget->setTrailLength(value);
+        });
+
+        auto frameRateLabel = new QLabel(renderingGroup);
+        renderingLayout->addRow("Frame Rate:", frameRateLabel);
+        auto frameCostLabel = new QLabel(renderingGroup);
+        renderingLayout->addRow("CPU / GPU:", frameCostLabel);
+
+        auto resetFrameStatsButton = new QPushButton("Reset Frame Stats", renderingGroup);
+        renderingLayout->addRow(resetFrameStatsButton);
+        connect(resetFrameStatsButton, &QPushButton::clicked, glWidget, [this]() { glWidget->resetFrameStats(); });
+
+        layout->addWidget(renderingGroup);
+
+        // Stage list, per stage threading and queue sizes, see DataProcessor::setPipelineConfig
+        auto pipelineGroup = new QGroupBox("Pipeline", controlWidget);
+        auto pipelineLayout = new QVBoxLayout(pipelineGroup);
+
+        auto pipelineEdit = new QLineEdit(QString::fromStdString(dataProcessor->getPipelineConfig()), pipelineGroup);
+        pipelineEdit->setToolTip("stage[@inline|thread|pool][/queue capacity], comma separated");
+        pipelineLayout->addWidget(pipelineEdit);
+
+        auto applyPipelineButton = new QPushButton("Apply", pipelineGroup);
+        pipelineLayout->addWidget(applyPipelineButton);
+        connect(applyPipelineButton, &QPushButton::clicked, this, [this, pipelineEdit]() {
+            // A rejected config is reported in the error dock and the running one kept
+            if (!dataProcessor->setPipelineConfig(pipelineEdit->text().toStdString())) {
+                pipelineEdit->setText(QString::fromStdString(dataProcessor->getPipelineConfig()));
+            }
+        });
+        connect(pipelineEdit, &QLineEdit::returnPressed, applyPipelineButton, &QPushButton::click);
+
+        auto pipelineStatsLabel = new QLabel(pipelineGroup);
+        pipelineStatsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        pipelineLayout->addWidget(pipelineStatsLabel);
+
+        layout->addWidget(pipelineGroup);
+
+        // These change every sample (adaptive smoother lag included), poll rather than signal
+        auto statsTimer = new QTimer(controlWidget);
+        connect(statsTimer, &QTimer::timeout, this, [this, mergedLabel, jitterLabel, gapLabel, latencyLabel, residualLabel,
+                                                     coalescedLabel, pipelineStatsLabel, frameRateLabel, frameCostLabel,
+                                                     lastFrames = uint64_t{0}, lastFramesNs = steadyNowNs()]() mutable {
+            const ResamplerStats stats = dataProcessor->getResamplerStats();
+            mergedLabel->setText(QString("%1 of %2 samples").arg(stats.mergedSamples).arg(stats.inputSamples));
+
+            const JitterBuffer::Stats jitter = dataProcessor->getJitterBufferStats();
+            jitterLabel->setText(QString("%1 ms delay, %2 late")
+                                         .arg(jitter.targetDelayMs, 0, 'f', 1)
+                                         .arg(jitter.lateDrops));
+
+            const GapConcealer::Stats gaps = dataProcessor->getGapStats();
+            gapLabel->setText(QString("%1, %2 samples concealed%3")
+                                      .arg(gaps.gaps)
+                                      .arg(gaps.concealedSamples)
+                                      .arg(gaps.concealing ? " (now)" : ""));
+            latencyLabel->setText(QString("%1 ms").arg(dataProcessor->smoothingLatencyMs(), 0, 'f', 1));
+            residualLabel->setText(QString("%1°").arg(glWidget->getPredictionError(), 0, 'f', 2));
+            coalescedLabel->setText(QString::number(dataProcessor->getLatestOrientation().getCoalescedCount()));
+
+            const uint64_t frames = glWidget->getFramesPainted();
+            const int64_t now = steadyNowNs();
+            frameRateLabel->setText(QString("%1 fps").arg(static_cast<double>(frames - lastFrames) * 1e9 / (now - lastFramesNs),
+                                                          0, 'f', 1));
+            lastFrames = frames;
+            lastFramesNs = now;
+
+            // p50 per frame since the last reset
+            const auto cpu = glWidget->getCpuFrameTimes().snapshot();
+            const QString gpu = glWidget->hasGpuTiming()
+                                ? QString("%1 ms").arg(glWidget->getGpuFrameTimes().snapshot().percentileNs(50.0) * 1e-6, 0, 'f', 2)
+                                : QString("n/a");
+            frameCostLabel->setText(QString("%1 ms / %2").arg(cpu.percentileNs(50.0) * 1e-6, 0, 'f', 2).arg(gpu));
+
+            // One row per stage: queue depth (peak) / capacity, mean service time, frames lost to a full queue
+            QStringList rows;
+            for (const auto& stage : dataProcessor->getPipelineStats()) {
+                QString row = QString("%1 %2").arg(QString::fromStdString(stage.name), -10)
+                                              .arg(Pipeline::modeName(stage.mode), -7);
+                if (stage.queueCapacity > 0) {
+                    row += QString(" q %1(%2)/%3").arg(stage.queueDepth).arg(stage.maxQueueDepth).arg(stage.queueCapacity);
+                }
+                row += QString(" %1 us").arg(stage.meanServiceNs * 1e-3, 0, 'f', 2);
+                if (stage.queueDrops > 0) {
+                    row += QString(" %1 dropped").arg(stage.queueDrops);
+                }
+                rows << row;
+            }
+            pipelineStatsLabel->setText(rows.join('\n'));
+        });
+        statsTimer->start(250);
         layout->addStretch();
 
         controlDock->setWidget(controlWidget);
         addDockWidget(Qt::RightDockWidgetArea, controlDock);
+
+        // Errors, non-modal so a noisy sensor never blocks the window
+        auto errorDock = new QDockWidget("Errors", this);
+        errorDock->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+
+        auto errorWidget = new QWidget(errorDock);
+        auto errorLayout = new QVBoxLayout(errorWidget);
+        errorList = new QListWidget(errorWidget);
+        errorLayout->addWidget(errorList);
+
+        auto clearErrorsButton = new QPushButton("Clear", errorWidget);
+        connect(clearErrorsButton, &QPushButton::clicked, errorList, &QListWidget::clear);
+        errorLayout->addWidget(clearErrorsButton);
+
+        errorDock->setWidget(errorWidget);
+        addDockWidget(Qt::BottomDockWidgetArea, errorDock);
+
+        connect(dataProcessor, &DataProcessor::errorOccurred, this, &MainWindow::appendError);
+        connect(dataProcessor, &DataProcessor::errorSummary, this, &MainWindow::appendError);
+
+        // Latency per segment from transport read to buffer swap
+        auto latencyDock = new QDockWidget("Latency", this);
+        latencyDock->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+
+        auto latencyWidget = new QWidget(latencyDock);
+        auto latencyLayout = new QVBoxLayout(latencyWidget);
+
+        auto latencyTable = new QTableWidget(static_cast<int>(LatencyMonitor::STAGE_COUNT), 5, latencyWidget);
+        latencyTable->setHorizontalHeaderLabels({"Samples", "p50 (ms)", "p99 (ms)", "p99.9 (ms)", "Max (ms)"});
+        latencyTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        latencyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        for (int row = 0; row < latencyTable->rowCount(); ++row) {
+            latencyTable->setVerticalHeaderItem(
+                    row, new QTableWidgetItem(LatencyMonitor::describe(static_cast<LatencyStage>(row))));
+            for (int column = 0; column < latencyTable->columnCount(); ++column) {
+                auto item = new QTableWidgetItem;
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                latencyTable->setItem(row, column, item);
+            }
+        }
+        latencyLayout->addWidget(latencyTable);
+
+        auto latencyButtons = new QHBoxLayout;
+        auto resetLatencyButton = new QPushButton("Reset", latencyWidget);
+        connect(resetLatencyButton, &QPushButton::clicked, this, [this]() {
+            dataProcessor->getLatencyMonitor().reset();
+        });
+        latencyButtons->addWidget(resetLatencyButton);
+
+        auto dumpLatencyButton = new QPushButton("Dump...", latencyWidget);
+        connect(dumpLatencyButton, &QPushButton::clicked, this, [this]() {
+            const QString path = QFileDialog::getSaveFileName(this, "Dump Latency Histograms",
+                                                              "latency.txt", "Text files (*.txt)");
+            if (path.isEmpty()) return;
+            if (dataProcessor->getLatencyMonitor().dumpToFile(path.toStdString())) {
+                statusBar()->showMessage("Latency histograms written to " + path, 3000);
+            } else {
+                appendError("Could not write latency histograms to " + path);
+            }
+        });
+        latencyButtons->addWidget(dumpLatencyButton);
+        latencyLayout->addLayout(latencyButtons);
+
+        latencyDock->setWidget(latencyWidget);
+        addDockWidget(Qt::BottomDockWidgetArea, latencyDock);
+        tabifyDockWidget(errorDock, latencyDock);
+
+        auto latencyTimer = new QTimer(latencyWidget);
+        connect(latencyTimer, &QTimer::timeout, this, [this, latencyTable]() {
+            for (int row = 0; row < latencyTable->rowCount(); ++row) {
+                const auto snapshot = dataProcessor->getLatencyMonitor().snapshot(static_cast<LatencyStage>(row));
+                const double values[] = {snapshot.percentileNs(50.0) * 1e-6, snapshot.percentileNs(99.0) * 1e-6,
+                                         snapshot.percentileNs(99.9) * 1e-6, snapshot.maxNs * 1e-6};
+                latencyTable->item(row, 0)->setText(QString::number(snapshot.count));
+                for (int column = 1; column < latencyTable->columnCount(); ++column) {
+                    latencyTable->item(row, column)->setText(QString::number(values[column - 1], 'f', 3));
+                }
+            }
+        });
+        latencyTimer->start(500);
+
+        // Raw channels and filter output over time, the engine only queues samples for it while it's visible
+        auto signalDock = new QDockWidget("Signals", this);
+        signalDock->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
+
+        auto signalWidget = new QWidget(signalDock);
+        auto signalLayout = new QVBoxLayout(signalWidget);
+
+        auto signalPlot = new SignalPlotWidget(signalWidget);
+        signalPlot->setMinimumHeight(240);
+        signalPlot->setSources(&dataProcessor->getSampleHistory(),
+                               &dataProcessor->getOrientationHistory(FusionEngine::HistoryTap::PLOT));
+        signalLayout->addWidget(signalPlot);
+
+        auto signalButtons = new QHBoxLayout;
+        auto spanSpin = new QDoubleSpinBox(signalWidget);
+        spanSpin->setRange(SignalPlotWidget::MIN_SPAN_SECONDS, SignalPlotWidget::MAX_SPAN_SECONDS);
+        spanSpin->setDecimals(1);
+        spanSpin->setSuffix(" s");
+        spanSpin->setValue(signalPlot->getSpan());
+        spanSpin->setToolTip("Time shown, the mouse wheel over the plot zooms too");
+        signalButtons->addWidget(new QLabel("Span:", signalWidget));
+        signalButtons->addWidget(spanSpin);
+        connect(spanSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), signalPlot, &SignalPlotWidget::setSpan);
+        connect(signalPlot, &SignalPlotWidget::spanChanged, spanSpin, &QDoubleSpinBox::setValue);
+
+        auto clearSignalsButton = new QPushButton("Clear", signalWidget);
+        connect(clearSignalsButton, &QPushButton::clicked, signalPlot, &SignalPlotWidget::clear);
+        signalButtons->addStretch();
+        signalButtons->addWidget(clearSignalsButton);
+        signalLayout->addLayout(signalButtons);
+
+        signalDock->setWidget(signalWidget);
+        addDockWidget(Qt::BottomDockWidgetArea, signalDock);
+        tabifyDockWidget(latencyDock, signalDock);
+        connect(signalDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+            dataProcessor->setHistoryEnabled(FusionEngine::HistoryTap::PLOT, visible);
+        });
+        signalDock->raise();
+    }
+
+    void MainWindow::loadCalibrationFor(const std::string& sensorId) {
+        currentSensorId = sensorId;
+
+        CalibrationData calibration;
+        const bool found = calibrationStore.load(sensorId, calibration);
+
+        // Without a profile fall back to identity rather than keeping the previous sensor's
+        dataProcessor->setCalibrationData(calibration);
+        statusBar()->showMessage(found
+                                 ? QString("Loaded calibration for %1").arg(QString::fromStdString(sensorId))
+                                 : QString("No stored calibration for %1").arg(QString::fromStdString(sensorId)),
+                                 3000);
     }
 
     void MainWindow::handleConnect() {
         if (transport->isConnected()) {
             transport->disconnect();
+            dataProcessor->stopStream();
             statusBar()->showMessage("Disconnected");
         } else {
             if (transport->connect()) {
@@ -269,7 +728,16 @@ namespace imu_viz {
     }
 
     void MainWindow::handleError(const std::string& error) {
-        QMessageBox::warning(this, "Error", QString::fromStdString(error));
+        appendError(QString::fromStdString(error));
+    }
+
+    void MainWindow::appendError(const QString& error) {
+        errorList->addItem(QTime::currentTime().toString("HH:mm:ss ") + error);
+        while (errorList->count() > MAX_ERROR_ROWS) {
+            delete errorList->takeItem(0);
+        }
+        errorList->scrollToBottom();
+        statusBar()->showMessage("Error: " + error, 3000);
     }
 
 }
\ No newline at end of file
@@ -9,9 +9,13 @@
 #include <QMainWindow>
 #include <memory>
 #include <QPushButton>
+#include <QListWidget>
 #include "visualization/gl_widget.h"
 #include "transport/transport_interface.h"
 #include "processing/data_processor.h"
+#include "processing/calibration/calibration_store.h"
+#include "monitoring/metrics_server.h"
+#include "core/metrics.h"
 
 namespace imu_viz {
     enum class TransportType {
@@ -25,27 +29,46 @@ namespace imu_viz {
     public:
         explicit MainWindow(QWidget *parent = nullptr);
 
+        // Serves /metrics on localhost, off unless started
+        bool startMetricsServer(quint16 port);
+
     private slots:
         void handleConnect();
         void handleIMUData(const IMUData& data);
         void handleError(const std::string& error);
+        void appendError(const QString& error);
 
     private:
         std::unique_ptr<ITransport> transport;
+        TransportType transportType{TransportType::MOCK};
         GLWidget* glWidget;
 
         void setupUI();
         void setupMenus();
         void setupDockWidgets();
         void setupDataPipeline();
+        void setupMetrics();
+        void loadCalibrationFor(const std::string& sensorId);
 
         DataProcessor* dataProcessor;
         QPushButton* connectButton;
+
+        static constexpr int MAX_ERROR_ROWS = 500;
+        QListWidget* errorList;
+
+        // Calibration profiles follow the sensor, saved on calibrate and loaded on connect
+        CalibrationStore calibrationStore;
+        std::string currentSensorId;
+
+        MetricsRegistry metrics;
+        MetricsServer* metricsServer{nullptr};
     };
 
 }
 
 Q_DECLARE_METATYPE(imu_viz::TransportType)
+Q_DECLARE_METATYPE(imu_viz::DataProcessor::CalibrationMode)
+Q_DECLARE_METATYPE(imu_viz::OutputSmootherFactory::SmootherType)
 
 
 #endif //IMU_VISUALIZER_MAIN_WINDOW_H
@@ -0,0 +1,129 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#include "body_renderer.h"
+#include "shaders.h"
+#include "cube_mesh.h"
+#include "core/logger.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <algorithm>
+#include <cmath>
+
+namespace imu_viz {
+    BodyRenderer::BodyRenderer()
+            : instanceBuffer(QOpenGLBuffer::VertexBuffer)
+    {
+        instanceBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    }
+
+    bool BodyRenderer::initialize(QOpenGLBuffer& mesh, int vertexCount) {
+        QOpenGLContext* ctx = QOpenGLContext::currentContext();
+        if (!ctx || ctx->isOpenGLES() || ctx->format().version() < qMakePair(3, 3)) {
+            return false;
+        }
+        gl = ctx->extraFunctions();
+
+        if (!program.addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, shaders::BODY_INSTANCED_VERTEX_330) ||
+            !program.addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, shaders::BODY_FRAGMENT_330) ||
+            !program.link()) {
+            IMU_LOG_ERROR("Instanced body program failed: {}", program.log().toStdString());
+            return false;
+        }
+
+        vao.create();
+        vao.bind();
+
+        mesh.bind();
+        program.enableAttributeArray(0);
+        program.setAttributeBuffer(0, GL_FLOAT, 0, 3, CUBE_VERTEX_STRIDE);
+        program.enableAttributeArray(1);
+        program.setAttributeBuffer(1, GL_FLOAT, 3 * sizeof(float), 3, CUBE_VERTEX_STRIDE);
+        program.enableAttributeArray(2);
+        program.setAttributeBuffer(2, GL_FLOAT, 6 * sizeof(float), 3, CUBE_VERTEX_STRIDE);
+
+        instanceBuffer.create();
+        instanceBuffer.bind();
+        capacity = INITIAL_CAPACITY;
+        instanceBuffer.allocate(static_cast<int>(capacity * sizeof(BodyInstance)));
+
+        constexpr int stride = sizeof(BodyInstance);
+        program.enableAttributeArray(3);
+        program.setAttributeBuffer(3, GL_FLOAT, static_cast<int>(offsetof(BodyInstance, rotation)), 4, stride);
+        program.enableAttributeArray(4);
+        program.setAttributeBuffer(4, GL_FLOAT, static_cast<int>(offsetof(BodyInstance, offset)), 4, stride); // offset + scale
+        program.enableAttributeArray(5);
+        program.setAttributeBuffer(5, GL_FLOAT, static_cast<int>(offsetof(BodyInstance, tint)), 3, stride);
+        gl->glVertexAttribDivisor(3, 1);
+        gl->glVertexAttribDivisor(4, 1);
+        gl->glVertexAttribDivisor(5, 1);
+
+        vao.release();
+        instanceBuffer.release();
+        mesh.release();
+
+        meshVertexCount = vertexCount;
+        ready = true;
+        return true;
+    }
+
+    void BodyRenderer::destroy() {
+        instanceBuffer.destroy();
+        vao.destroy();
+        program.removeAllShaders();
+        ready = false;
+    }
+
+    void BodyRenderer::draw(const BodyInstance* instances, size_t count, const QMatrix4x4& projection,
+                            const QMatrix4x4& view, const QVector3D& viewPos, const QVector3D& lightPos) {
+        if (!ready || count == 0) return;
+
+        instanceBuffer.bind();
+        if (count > capacity) {
+            while (capacity < count) capacity *= 2;
+        }
+        // Orphan then fill, the driver hands back fresh storage instead of syncing with the last draw
+        instanceBuffer.allocate(static_cast<int>(capacity * sizeof(BodyInstance)));
+        instanceBuffer.write(0, instances, static_cast<int>(count * sizeof(BodyInstance)));
+        instanceBuffer.release();
+
+        program.bind();
+        program.setUniformValue("projection", projection);
+        program.setUniformValue("view", view);
+        program.setUniformValue("viewPos", viewPos);
+        program.setUniformValue("lightPos", lightPos);
+
+        vao.bind();
+        gl->glDrawArraysInstanced(GL_TRIANGLES, 0, meshVertexCount, static_cast<GLsizei>(count));
+        vao.release();
+
+        program.release();
+    }
+
+    void BodyRenderer::layoutGrid(BodyInstance* instances, size_t count) {
+        if (count == 0) return;
+        const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+        const float spacing = side > 1 ? 3.0f / static_cast<float>(side - 1) : 0.0f;
+        const float scale = side > 1 ? std::min(1.0f, 0.6f * spacing) : 1.0f;
+        const float origin = -0.5f * spacing * static_cast<float>(side - 1);
+
+        for (size_t i = 0; i < count; ++i) {
+            BodyInstance& body = instances[i];
+            body.offset[0] = origin + spacing * static_cast<float>(i % side);
+            body.offset[1] = 0.0f;
+            body.offset[2] = origin + spacing * static_cast<float>(i / side);
+            body.scale = scale;
+
+            // Spread hues so neighbouring sensors are easy to tell apart, the first keeps the plain faces
+            if (i == 0) {
+                body.tint[0] = body.tint[1] = body.tint[2] = 1.0f;
+            } else {
+                const double hue = std::fmod(static_cast<double>(i) * 0.618033988749895, 1.0) * 2.0 * M_PI;
+                body.tint[0] = static_cast<float>(0.75 + 0.25 * std::cos(hue));
+                body.tint[1] = static_cast<float>(0.75 + 0.25 * std::cos(hue - 2.0 * M_PI / 3.0));
+                body.tint[2] = static_cast<float>(0.75 + 0.25 * std::cos(hue + 2.0 * M_PI / 3.0));
+            }
+        }
+    }
+}
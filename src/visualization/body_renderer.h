@@ -0,0 +1,71 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_BODY_RENDERER_H
+#define IMU_VISUALIZER_BODY_RENDERER_H
+#pragma once
+
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include "core/imu_data.h"
+#include <cstddef>
+
+class QOpenGLExtraFunctions;
+
+namespace imu_viz {
+
+    // One body's per instance attributes, in the order BODY_INSTANCED_VERTEX_330 reads them
+    struct BodyInstance {
+        float rotation[4]{0.0f, 0.0f, 0.0f, 1.0f}; // Quaternion x, y, z, w
+        float offset[3]{0.0f, 0.0f, 0.0f};         // Position in the layout
+        float scale{1.0f};
+        float tint[3]{1.0f, 1.0f, 1.0f};           // Multiplies the face colours
+        float padding{0.0f};
+
+        void setRotation(const Quaterniond& q) {
+            rotation[0] = static_cast<float>(q.x());
+            rotation[1] = static_cast<float>(q.y());
+            rotation[2] = static_cast<float>(q.z());
+            rotation[3] = static_cast<float>(q.w());
+        }
+    };
+    static_assert(sizeof(BodyInstance) == 12 * sizeof(float), "Instance buffer stride");
+
+    /**
+     * Draws every body in one glDrawArraysInstanced call. The instances are uploaded once per frame
+     * into an orphaned stream buffer, so the driver never waits on last frame's copy.
+     * Needs desktop GL 3.3, elsewhere initialize() fails and the caller draws bodies one at a time.
+     */
+    class BodyRenderer {
+    public:
+        BodyRenderer();
+
+        // Context current. mesh holds position/colour/normal vertices, see cube_mesh.h
+        bool initialize(QOpenGLBuffer& mesh, int vertexCount);
+        void destroy();
+        bool isReady() const { return ready; }
+
+        void draw(const BodyInstance* instances, size_t count, const QMatrix4x4& projection,
+                  const QMatrix4x4& view, const QVector3D& viewPos, const QVector3D& lightPos);
+
+        // Square grid centred on the origin, bodies shrink so the whole grid stays about 3 units across
+        static void layoutGrid(BodyInstance* instances, size_t count);
+
+    private:
+        static constexpr size_t INITIAL_CAPACITY = 64;
+
+        QOpenGLExtraFunctions* gl{nullptr};
+        QOpenGLShaderProgram program;
+        QOpenGLVertexArrayObject vao;
+        QOpenGLBuffer instanceBuffer;
+        size_t capacity{0};
+        int meshVertexCount{0};
+        bool ready{false};
+    };
+}
+
+#endif //IMU_VISUALIZER_BODY_RENDERER_H
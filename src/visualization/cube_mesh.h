@@ -0,0 +1,79 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_CUBE_MESH_H
+#define IMU_VISUALIZER_CUBE_MESH_H
+#pragma once
+
+namespace imu_viz {
+
+    // Unit cube as 36 non-indexed vertices, one colour per face
+    inline constexpr int CUBE_VERTEX_COUNT = 36;
+    inline constexpr int CUBE_VERTEX_STRIDE = 9 * sizeof(float);
+
+    inline constexpr float CUBE_VERTICES[] = {
+        // Positions, colors, normals
+        // Front face (red)
+        // First triangle
+        -0.5f, -0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Bottom-left
+        +0.5f, -0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Bottom-right
+        +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Top-right
+        // Second triangle
+        -0.5f, -0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Bottom-left
+        +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Top-right
+        -0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Top-left
+
+        // Back face (green)
+        // First triangle
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Bottom-left
+        +0.5f, +0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Top-right
+        +0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Bottom-right
+        // Second triangle
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Bottom-left
+        -0.5f, +0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Top-left
+        +0.5f, +0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Top-right
+
+        // Left face (blue)
+        // First triangle
+        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Back-bottom
+        -0.5f, +0.5f, +0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Front-top
+        -0.5f, +0.5f, -0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Back-top
+        // Second triangle
+        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Back-bottom
+        -0.5f, -0.5f, +0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Front-bottom
+        -0.5f, +0.5f, +0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Front-top
+
+        // Right face (yellow)
+        // First triangle
+        +0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Back-bottom
+        +0.5f, +0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Back-top
+        +0.5f, +0.5f, +0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Front-top
+        // Second triangle
+        +0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Back-bottom
+        +0.5f, +0.5f, +0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Front-top
+        +0.5f, -0.5f, +0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Front-bottom
+
+        // Top face (magenta)
+        // First triangle
+        -0.5f, +0.5f, -0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Back-left
+        +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Front-right
+        +0.5f, +0.5f, -0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Back-right
+        // Second triangle
+        -0.5f, +0.5f, -0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Back-left
+        -0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Front-left
+        +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Front-right
+
+        // Bottom face (cyan)
+        // First triangle
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Back-left
+        +0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Back-right
+        +0.5f, -0.5f, +0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Front-right
+        // Second triangle
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Back-left
+        +0.5f, -0.5f, +0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Front-right
+        -0.5f, -0.5f, +0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Front-left
+    };
+}
+
+#endif //IMU_VISUALIZER_CUBE_MESH_H
@@ -0,0 +1,64 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_FRAME_PACER_H
+#define IMU_VISUALIZER_FRAME_PACER_H
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace imu_viz {
+
+    /**
+     * Decides when the renderer next looks for work. Frames land on whole refresh periods so a cap
+     * below the display rate shows every 2nd, 3rd, ... vsync rather than beating against it. After
+     * IDLE_AFTER_NS without anything to draw the check backs off to IDLE_POLL_MS.
+     * The ReadMe's rendering section describes how to measure idle CPU/GPU against continuous redraw.
+     */
+    class FramePacer {
+    public:
+        static constexpr double DEFAULT_REFRESH_HZ = 60.0;
+        static constexpr int64_t IDLE_AFTER_NS = 1000000000;
+        static constexpr int IDLE_POLL_MS = 100;
+        static constexpr int64_t VSYNC_SLACK_NS = 2000000; // Ask a little early so the paint makes its vsync
+
+        void setRefreshRate(double hz) { refreshHz = hz > 1.0 ? hz : DEFAULT_REFRESH_HZ; }
+        double getRefreshRate() const { return refreshHz; }
+
+        // 0 draws at most once per refresh
+        void setMaxFps(int fps) { maxFps = std::max(0, fps); }
+        int getMaxFps() const { return maxFps; }
+
+        void setIdleEnabled(bool enabled) { idleEnabled = enabled; }
+        bool isIdleEnabled() const { return idleEnabled; }
+
+        int64_t frameIntervalNs() const {
+            const double periods = maxFps > 0 ? std::max(1.0, std::round(refreshHz / maxFps)) : 1.0;
+            return static_cast<int64_t>(periods * 1e9 / refreshHz);
+        }
+
+        // Something changed on screen at nowNs
+        void markActivity(int64_t nowNs) { lastActivityNs = nowNs; }
+
+        bool isIdle(int64_t nowNs) const { return idleEnabled && nowNs - lastActivityNs > IDLE_AFTER_NS; }
+
+        // Until the frame slot after fromNs (the last paint, or now after a check that found nothing),
+        // or the idle poll once nothing has changed for a while
+        int delayMs(int64_t nowNs, int64_t fromNs) const {
+            if (isIdle(nowNs)) return IDLE_POLL_MS;
+            const int64_t due = fromNs + frameIntervalNs() - VSYNC_SLACK_NS - nowNs;
+            return due > 0 ? static_cast<int>((due + 999999) / 1000000) : 0;
+        }
+
+    private:
+        double refreshHz{DEFAULT_REFRESH_HZ};
+        int maxFps{0};
+        bool idleEnabled{true};
+        int64_t lastActivityNs{0};
+    };
+}
+
+#endif //IMU_VISUALIZER_FRAME_PACER_H
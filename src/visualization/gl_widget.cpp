@@ -1,10 +1,30 @@
 #include "gl_widget.h"
+#include "shaders.h"
+#include "cube_mesh.h"
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QScreen>
+#include <QOpenGLContext>
+#include <QTimer>
+#include "core/clock.h"
+#include "core/logger.h"
+#include "core/profiler.h"
 
 namespace imu_viz {
+    namespace {
+        QMatrix4x4 toMatrix(const Quaterniond& orientation) {
+            Eigen::Matrix3d rotMat = orientation.toRotationMatrix();
+            QMatrix4x4 rotationMatrix;
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    rotationMatrix(i, j) = rotMat(i, j);
+                }
+            }
+            return rotationMatrix;
+        }
+    }
 
     GLWidget::GLWidget(QWidget* parent)
             : QOpenGLWidget(parent)
@@ -12,10 +32,12 @@ namespace imu_viz {
             , vbo(QOpenGLBuffer::VertexBuffer)
             , axesVBO(QOpenGLBuffer::VertexBuffer)
             , gridVBO(QOpenGLBuffer::VertexBuffer)
+            , frameTimer(new QTimer(this))
             , rotationSpeed(0.5f)
             , panSpeed(0.01f)
             , zoomSpeed(0.1f)
     {
+        constructedNs = steadyNowNs();
         setMouseTracking(true);
         setFocusPolicy(Qt::StrongFocus);
 
@@ -30,16 +52,110 @@ namespace imu_viz {
         projection.setToIdentity();
 
         updateCamera();  // Set initial view matrix
+
+        // Looks for new work at the next frame slot, see checkForFrame
+        frameTimer->setSingleShot(true);
+        frameTimer->setTimerType(Qt::PreciseTimer);
+        connect(frameTimer, &QTimer::timeout, this, &GLWidget::checkForFrame);
+
+        connect(this, &QOpenGLWidget::frameSwapped, this, [this]() {
+            const int64_t now = steadyNowNs();
+            framePending = false;
+
+            if (timeToFirstFrameNs == 0) {
+                timeToFirstFrameNs = now - constructedNs;
+                IMU_LOG_INFO("First frame {} ms after start, shaders took {} ms",
+                             timeToFirstFrameNs * 1e-6, shaderSetupNs * 1e-6);
+            }
+
+            // Closes the latency stamps of the sample paintGL last picked up
+            if (latencyMonitor && pendingArrivalNs != 0) {
+                latencyMonitor->record(LatencyStage::PRESENT, now - pendingPaintNs);
+                latencyMonitor->record(LatencyStage::END_TO_END, now - pendingArrivalNs);
+                pendingArrivalNs = 0;
+            }
+
+            if (continuousRendering) {
+                framePending = true;
+                update();
+                return;
+            }
+            armFrameTimer(pacer.delayMs(now, lastPaintNs));
+        });
     }
 
     GLWidget::~GLWidget() {
         makeCurrent();
+        bodyRenderer.destroy();
+        trail.destroy();
         vbo.destroy();
         axesVBO.destroy();
         gridVBO.destroy();
+        gpuTimers[0].destroy();
+        gpuTimers[1].destroy();
         doneCurrent();
     }
 
+    void GLWidget::requestFrame() {
+        const int64_t now = steadyNowNs();
+        frameDirty = true;
+        pacer.markActivity(now);
+        if (!framePending) armFrameTimer(pacer.delayMs(now, lastPaintNs));
+    }
+
+    void GLWidget::checkForFrame() {
+        // frameSwapped re-arms the timer. A hidden widget paints on its next expose, which clears this too
+        if (framePending) return;
+
+        const int64_t now = steadyNowNs();
+        const bool fresh = orientationSource && orientationSource->hasFresh();
+        // The trail keeps fading after the last sample until its newest vertex is trailSeconds old
+        const bool trailFading = trailSeconds > 0.0 && trail.size() > 0 &&
+                                 now - trail.newestTimeNs() < static_cast<int64_t>(trailSeconds * 1e9);
+        if (continuousRendering || frameDirty || fresh || trailFading || predictor.isExtrapolating(now)) {
+            pacer.markActivity(now);
+            frameDirty = false;
+            framePending = true;
+            update();
+            return;
+        }
+
+        // Nothing new, look again one frame from now (or at the idle poll)
+        armFrameTimer(pacer.delayMs(now, now));
+    }
+
+    void GLWidget::armFrameTimer(int delayMs) {
+        if (frameTimer->isActive() && frameTimer->remainingTime() <= delayMs) return;
+        frameTimer->start(delayMs);
+    }
+
+    void GLWidget::setFrameRateCap(int fps) {
+        pacer.setMaxFps(fps);
+        requestFrame();
+    }
+
+    void GLWidget::setIdleEnabled(bool enabled) {
+        pacer.setIdleEnabled(enabled);
+        requestFrame();
+    }
+
+    void GLWidget::setContinuousRendering(bool continuous) {
+        continuousRendering = continuous;
+        requestFrame();
+    }
+
+    void GLWidget::resetFrameStats() {
+        frameTimes.reset();
+        cpuFrameTimes.reset();
+        gpuFrameTimes.reset();
+    }
+
+    void GLWidget::collectGpuTime(int index) {
+        if (!gpuTimerPending[index] || !gpuTimers[index].isResultAvailable()) return;
+        gpuFrameTimes.record(static_cast<int64_t>(gpuTimers[index].waitForResult()));
+        gpuTimerPending[index] = false;
+    }
+
     void GLWidget::updateCamera() {
         // Store current distance and offset before updating
         float currentDistance = (cameraPosition - cameraTarget).length();
@@ -69,19 +185,12 @@ namespace imu_viz {
         view.setToIdentity();
         view.lookAt(cameraPosition, cameraTarget, cameraUp);
 
-        // Debug output
-        static int frameCount = 0;
-        if (frameCount++ % 60 == 0) {
-            qDebug() << "Camera State:"
-                     << "\nPosition:" << cameraPosition
-                     << "\nTarget:" << cameraTarget
-                     << "\nDistance:" << currentDistance
-                     << "\nOffset:" << currentOffset
-                     << "\nYaw:" << yaw
-                     << "\nPitch:" << pitch;
-        }
+        // Called on every drag event, so only a sample of them
+        IMU_LOG_EVERY_N(TRACE, 60, "Camera state: position {} {} {} target {} {} {} yaw {} pitch {}",
+                        cameraPosition.x(), cameraPosition.y(), cameraPosition.z(),
+                        cameraTarget.x(), cameraTarget.y(), cameraTarget.z(), yaw, pitch);
 
-        update();
+        requestFrame();
     }
 
     void GLWidget::mouseMoveEvent(QMouseEvent* event) {
@@ -111,7 +220,7 @@ namespace imu_viz {
             // Update view matrix without changing orientation
             view.setToIdentity();
             view.lookAt(cameraPosition, cameraTarget, cameraUp);
-            update();
+            requestFrame();
         }
 
         lastMousePos = event->pos();
@@ -136,7 +245,7 @@ namespace imu_viz {
         // Update view matrix without changing orientation
         view.setToIdentity();
         view.lookAt(cameraPosition, cameraTarget, cameraUp);
-        update();
+        requestFrame();
     }
 
     void GLWidget::resetCamera() {
@@ -149,19 +258,19 @@ namespace imu_viz {
 
         view.setToIdentity();
         view.lookAt(cameraPosition, cameraTarget, cameraUp);
-        update();
+        requestFrame();
     }
 
     void GLWidget::mousePressEvent(QMouseEvent* event) {
         lastMousePos = event->pos();
-        qDebug() << "Mouse pressed:" << event->button() << "at" << event->pos();
+        IMU_LOG_TRACE("Mouse pressed: {} at {} {}", event->button(), event->pos().x(), event->pos().y());
 
         if (event->button() == Qt::LeftButton) {
             isRotating = true;
-            qDebug() << "Rotation started";
+            IMU_LOG_TRACE("Rotation started");
         } else if (event->button() == Qt::RightButton) {
             isPanning = true;
-            qDebug() << "Panning started";
+            IMU_LOG_TRACE("Panning started");
         }
 
         setCursor(Qt::ClosedHandCursor);
@@ -216,11 +325,27 @@ namespace imu_viz {
         glEnable(GL_MULTISAMPLE);
 
         // Print OpenGL debug info
-        qDebug() << "OpenGL Version:" << QString((const char*)glGetString(GL_VERSION));
-        qDebug() << "GLSL Version:" << QString((const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
+        IMU_LOG_INFO("OpenGL Version: {}", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        IMU_LOG_INFO("GLSL Version: {}", reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION)));
+
+        // Needs GL 3.3 or ARB_timer_query, GLES (the Pi) reports CPU time only
+        gpuTimingSupported = gpuTimers[0].create() && gpuTimers[1].create();
+        if (screen()) pacer.setRefreshRate(screen()->refreshRate());
+        IMU_LOG_INFO("Display refresh {} Hz, GPU frame timing {}", pacer.getRefreshRate(),
+                     gpuTimingSupported ? "on" : "unavailable");
 
+        const int64_t shaderStartNs = steadyNowNs();
         setupShaders();
+        shaderSetupNs = steadyNowNs() - shaderStartNs;
         setupBuffers();
+
+        // Shares the cube's vertex buffer, only the instance data is its own
+        if (bodyRenderer.initialize(vbo, CUBE_VERTEX_COUNT)) {
+            IMU_LOG_INFO("Bodies drawn instanced");
+        } else {
+            IMU_LOG_INFO("Instancing unavailable, bodies drawn one call each");
+        }
+        trail.initialize(trailProgram.get(), static_cast<size_t>(std::max(trailSeconds, 1.0) * TRAIL_RATE_HZ));
         updateProjectionMatrix();
     }
 
@@ -236,42 +361,60 @@ namespace imu_viz {
     }
 
     void GLWidget::paintGL() {
+        IMU_PROFILE_ZONE("GLWidget::paintGL");
+        const int64_t paintStartNs = steadyNowNs();
+
+        // Results from earlier frames, a query still in flight is left alone and this frame goes untimed
+        bool gpuTimed = false;
+        if (gpuTimingSupported) {
+            collectGpuTime(0);
+            collectGpuTime(1);
+            if (!gpuTimerPending[gpuTimerIndex]) {
+                gpuTimers[gpuTimerIndex].begin();
+                gpuTimed = true;
+            }
+        }
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         static bool firstFrame = true;
         if (firstFrame) {
-            qDebug() << "OpenGL State:";
-            qDebug() << "Depth test enabled:" << glIsEnabled(GL_DEPTH_TEST);
-            qDebug() << "Face culling enabled:" << glIsEnabled(GL_CULL_FACE);
-            qDebug() << "Main program linked:" << program->isLinked();
-            qDebug() << "Simple program linked:" << simpleProgram->isLinked();
-            qDebug() << "VAO created:" << vao.isCreated();
-            qDebug() << "Axes VAO created:" << axesVAO.isCreated();
-            qDebug() << "Grid VAO created:" << gridVAO.isCreated();
+            IMU_LOG_DEBUG("OpenGL State: depth test {}, face culling {}",
+                          glIsEnabled(GL_DEPTH_TEST) == GL_TRUE, glIsEnabled(GL_CULL_FACE) == GL_TRUE);
+            IMU_LOG_DEBUG("Main program linked: {}, simple program linked: {}",
+                          program->isLinked(), simpleProgram->isLinked());
+            IMU_LOG_DEBUG("VAO created: {}, axes VAO created: {}, grid VAO created: {}",
+                          vao.isCreated(), axesVAO.isCreated(), gridVAO.isCreated());
             firstFrame = false;
         }
 
-        // Draw cube
-        if (program->isLinked()) {
-            program->bind();
-
-
-            QMatrix4x4 modelMatrix = model;
-            program->setUniformValue("projection", projection);
-            program->setUniformValue("view", view);
-            program->setUniformValue("model", modelMatrix);
-            program->setUniformValue("normalMatrix", modelMatrix.normalMatrix());
-            program->setUniformValue("viewPos", cameraPosition);
-            program->setUniformValue("lightPos", QVector3D(5.0f, 0.0f, 5.0f));
+        // Frame will be seen roughly one interval from now, extrapolate the model to then
+        const int64_t now = steadyNowNs();
+        if (lastPaintNs != 0) {
+            frameTimes.record(now - lastPaintNs);
+            // A paint after an idle stretch says nothing about the presentation delay
+            const double interval = static_cast<double>(now - lastPaintNs) * 1e-6;
+            if (interval < 2e-6 * static_cast<double>(pacer.frameIntervalNs())) {
+                frameIntervalMs += 0.1 * (interval - frameIntervalMs);
+            }
+        }
+        lastPaintNs = now;
 
-            vao.bind();
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            vao.release();
+        OrientationSample latest;
+        if (orientationSource && orientationSource->read(latest)) {
+            predictor.update(latest);
 
-            program->release();
-        } else {
-            qDebug() << "Main program not linked!";
+            // First frame this sample is drawn in, concealed output has no transport stamps of its own
+            if (latencyMonitor && !latest.concealed && latest.arrivalTimeNs != 0) {
+                latencyMonitor->record(LatencyStage::RENDER_WAIT, now - latest.publishTimeNs);
+                pendingArrivalNs = latest.arrivalTimeNs;
+                pendingPaintNs = now;
+            }
         }
+        const Quaterniond displayed = predictor.predict(now, frameIntervalMs);
+        model = toMatrix(displayed);
+        drawBodies(displayed);
+        drawTrail(now);
 
         // Draw axes and grid
         if (showAxes) drawAxes();
@@ -280,10 +423,95 @@ namespace imu_viz {
         // Check for OpenGL errors
         GLenum err;
         while ((err = glGetError()) != GL_NO_ERROR) {
-            qDebug() << "OpenGL error:" << err;
+            IMU_LOG_RATE_LIMITED(WARN, 1000, "OpenGL error: {}", LogHex{err});
+        }
+
+        if (gpuTimed) {
+            gpuTimers[gpuTimerIndex].end();
+            gpuTimerPending[gpuTimerIndex] = true;
+            gpuTimerIndex ^= 1;
+        }
+        cpuFrameTimes.record(steadyNowNs() - paintStartNs);
+        ++framesPainted;
+
+        // No update() here, the next frame is scheduled from frameSwapped
+    }
+
+    void GLWidget::drawBodies(const Quaterniond& orientation) {
+        IMU_PROFILE_ZONE("GLWidget::drawBodies");
+        for (auto& body : bodies) {
+            body.setRotation(orientation);
+        }
+        const QVector3D lightPos(5.0f, 0.0f, 5.0f);
+
+        if (bodyRenderer.isReady()) {
+            bodyRenderer.draw(bodies.data(), bodies.size(), projection, view, cameraPosition, lightPos);
+            return;
+        }
+
+        if (!program->isLinked()) {
+            IMU_LOG_RATE_LIMITED(ERROR, 1000, "Main program not linked!");
+            return;
+        }
+
+        // GLES 2 and old desktop contexts: one draw per body, without the tint
+        program->bind();
+        program->setUniformValue("projection", projection);
+        program->setUniformValue("view", view);
+        program->setUniformValue("viewPos", cameraPosition);
+        program->setUniformValue("lightPos", lightPos);
+
+        vao.bind();
+        const QMatrix4x4 rotation = toMatrix(orientation);
+        for (const auto& body : bodies) {
+            QMatrix4x4 bodyModel;
+            bodyModel.translate(body.offset[0], body.offset[1], body.offset[2]);
+            bodyModel *= rotation;
+            bodyModel.scale(body.scale);
+            program->setUniformValue("model", bodyModel);
+            program->setUniformValue("normalMatrix", bodyModel.normalMatrix());
+            glDrawArrays(GL_TRIANGLES, 0, CUBE_VERTEX_COUNT);
+        }
+        vao.release();
+
+        program->release();
+    }
+
+    void GLWidget::drawTrail(int64_t nowNs) {
+        IMU_PROFILE_ZONE("GLWidget::drawTrail");
+        if (!orientationHistory) return;
+
+        // Only what arrived since the last frame is touched here, however long the trail is
+        const bool visible = trailSeconds > 0.0 && trail.isReady();
+        OrientationSample sample;
+        while (orientationHistory->tryPop(sample)) {
+            if (visible) trail.append(sample.orientation, sample.publishTimeNs);
         }
+        if (!visible) return;
+
+        // Follows the first body around the layout
+        const BodyInstance& body = bodies.front();
+        QMatrix4x4 trailModel;
+        trailModel.translate(body.offset[0], body.offset[1], body.offset[2]);
+        trailModel.scale(body.scale);
+        trail.draw(projection, view, trailModel, nowNs, trailSeconds);
+    }
 
-        update();
+    void GLWidget::setTrailLength(double seconds) {
+        trailSeconds = std::clamp(seconds, 0.0, MAX_TRAIL_SECONDS);
+        if (trailSeconds > 0.0 && trail.isReady()) {
+            // Buffer reallocation needs the context, this can be called from anywhere
+            makeCurrent();
+            trail.setCapacity(static_cast<size_t>(trailSeconds * TRAIL_RATE_HZ));
+            doneCurrent();
+        }
+        requestFrame();
+    }
+
+    void GLWidget::setBodyCount(int count) {
+        bodies.assign(static_cast<size_t>(std::clamp(count, 1, MAX_BODIES)), BodyInstance{});
+        BodyRenderer::layoutGrid(bodies.data(), bodies.size());
+        requestFrame();
     }
 
     void GLWidget::drawCamera() {
@@ -321,216 +549,44 @@ namespace imu_viz {
     }
 
     void GLWidget::updateOrientation(const Quaterniond& orientation) {
-        // Convert Eigen quaternion to QMatrix
-        Eigen::Matrix3d rotMat = orientation.toRotationMatrix();
-        QMatrix4x4 rotationMatrix;
-        for (int i = 0; i < 3; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                rotationMatrix(i, j) = rotMat(i, j);
-            }
-        }
+        // No rate known, nothing to extrapolate
+        OrientationSample sample;
+        sample.orientation = orientation;
+        sample.publishTimeNs = steadyNowNs();
+        predictor.reset();
+        predictor.update(sample);
+        requestFrame();
+    }
+
+    void GLWidget::updateOrientationSample(const OrientationSample& sample) {
+        predictor.update(sample);
+        requestFrame();
+    }
 
-        model = rotationMatrix;
-        update(); // Request a redraw
+    void GLWidget::setPredictionHorizon(double ms) {
+        predictor.setHorizonMs(ms);
+        requestFrame();
     }
 
     void GLWidget::setShowAxes(bool show) {
         showAxes = show;
-        update(); // Redraw
+        requestFrame();
     }
 
     void GLWidget::setShowGrid(bool show) {
         showGrid = show;
-        update(); // Redraw
+        requestFrame();
     }
 
     void GLWidget::setupShaders() {
-        // Desktop for mac testing vertex shader
-        const char* vertexShaderDesktop = R"(
-    #version 330 core
-    layout(location = 0) in vec3 position;
-    layout(location = 1) in vec3 color;
-    layout(location = 2) in vec3 normal;
-
-    uniform mat4 projection;
-    uniform mat4 view;
-    uniform mat4 model;
-    uniform mat3 normalMatrix;
-
-    out vec3 fragPos;
-    out vec3 vertexColor;
-    out vec3 fragNormal;
-
-    void main() {
-        vertexColor = color;
-        fragPos = vec3(model * vec4(position, 1.0));
-
-        // Transform normal to world space maintaining correct orientation
-        fragNormal = normalize(normalMatrix * normal);
-
-        gl_Position = projection * view * model * vec4(position, 1.0);
-    }
-)";
-
-        const char* fragmentShaderDesktop = R"(
-    #version 330 core
-    in vec3 fragPos;
-    in vec3 vertexColor;
-    in vec3 fragNormal;
-
-    out vec4 fragColor;
-
-    uniform vec3 lightPos;    // Main light
-    uniform vec3 viewPos;
-
-    // Material properties
-    const float ambientStrength = 0.15;
-    const float diffuseStrength = 0.7;
-    const float specularStrength = 0.8;
-    const float shininess = 64.0;
-
-    // Secondary light sources for better illumination
-    const vec3 fillLightPos = vec3(-5.0, 3.0, -5.0);
-    const vec3 fillLightColor = vec3(0.2, 0.2, 0.3);
-    const float fillLightIntensity = 0.3;
-
-    const vec3 rimLightDir = vec3(0.0, 0.0, -1.0);
-    const vec3 rimLightColor = vec3(0.1, 0.1, 0.15);
-    const float rimLightIntensity = 0.2;
-
-    vec3 calculateLight(vec3 lightPosition, vec3 lightColor, float intensity) {
-        vec3 normal = normalize(fragNormal);
-        vec3 lightDir = normalize(lightPosition - fragPos);
-        vec3 viewDir = normalize(viewPos - fragPos);
-        vec3 halfwayDir = normalize(lightDir + viewDir);
-
-        // Ambient
-        vec3 ambient = ambientStrength * lightColor;
-
-        // Diffuse
-        float diff = max(dot(normal, lightDir), 0.0);
-        vec3 diffuse = diffuseStrength * diff * lightColor;
-
-        // Specular (Blinn-Phong)
-        float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
-        vec3 specular = specularStrength * spec * lightColor;
-
-        // Edge highlighting (rim lighting)
-        float rim = 1.0 - max(dot(viewDir, normal), 0.0);
-        rim = smoothstep(0.6, 1.0, rim);
-
-        return intensity * (ambient + diffuse + specular);
-    }
-
-    void main() {
-        // Main light (warm white)
-        vec3 mainLight = calculateLight(lightPos, vec3(1.0, 0.95, 0.8), 1.0);
-
-        // Fill light (cool blue)
-        vec3 fillLight = calculateLight(fillLightPos, fillLightColor, fillLightIntensity);
-
-        // Rim light
-        vec3 normal = normalize(fragNormal);
-        vec3 viewDir = normalize(viewPos - fragPos);
-        float rim = 1.0 - max(dot(viewDir, normal), 0.0);
-        rim = smoothstep(0.6, 1.0, rim);
-        vec3 rimLight = rim * rimLightColor * rimLightIntensity;
-
-        // Combine all lighting
-        vec3 result = (mainLight + fillLight + rimLight) * vertexColor;
-
-        // Tone mapping then gamma correction
-        result = result / (result + vec3(1.0));
-        result = pow(result, vec3(1.0/2.2));
-
-        fragColor = vec4(result, 1.0);
-    }
-)";
-
-        // Raspberry Pi (using OpenGL ES) vertex shader
-        const char* vertexShaderES = R"(
-        #version 100
-        attribute vec3 position;
-        attribute vec3 color;
-        attribute vec3 normal;
-
-        uniform mat4 projection;
-        uniform mat4 view;
-        uniform mat4 model;
-        uniform mat3 normalMatrix;
-
-        varying vec3 fragPos;
-        varying vec3 vertexColor;
-        varying vec3 fragNormal;
-
-        void main() {
-            vertexColor = color;
-            fragPos = vec3(model * vec4(position, 1.0));
-            // Transform normal to world space
-            fragNormal = normalMatrix * normal;
-            gl_Position = projection * view * model * vec4(position, 1.0);
-        }
-    )";
-
-        const char* fragmentShaderES = R"(
-        precision mediump float;
-        varying vec3 fragPos;
-        varying vec3 vertexColor;
-        varying vec3 fragNormal;
-
-        uniform vec3 lightPos;
-        uniform vec3 viewPos;
-
-        void main() {
-            // Ambient
-            float ambientStrength = 0.1;
-            vec3 ambient = ambientStrength * vertexColor;
-
-            // Diffuse
-            vec3 norm = normalize(fragNormal);
-            vec3 lightDir = normalize(lightPos - fragPos);
-            float diff = max(dot(norm, lightDir), 0.0);
-            vec3 diffuse = diff * vertexColor;
-
-            // Specular
-            float specularStrength = 0.5;
-            vec3 viewDir = normalize(viewPos - fragPos);
-            vec3 reflectDir = reflect(-lightDir, norm);
-            float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-            vec3 specular = specularStrength * spec * vec3(1.0);
-
-            vec3 result = ambient + diffuse + specular;
-            gl_FragColor = vec4(result, 1.0);
-        }
-    )";
-
-        // Choose shader version based on platform
-        const char* vertexSource;
-        const char* fragmentSource;
-
-#ifdef __APPLE__
-        vertexSource = vertexShaderDesktop;
-        fragmentSource = fragmentShaderDesktop;
-        qDebug() << "Using Desktop OpenGL shaders";
-#else
-        vertexSource = vertexShaderES;
-        fragmentSource = fragmentShaderES;
-        qDebug() << "Using OpenGL ES shaders";
-#endif
-
-        // Compile shaders and check for any errors
-        if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource)) {
-            qDebug() << "Vertex shader compilation failed:" << program->log();
-            return;
-        }
-
-        if (!program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource)) {
-            qDebug() << "Fragment shader compilation failed:" << program->log();
-            return;
-        }
-
-        if (!program->link()) {
-            qDebug() << "Shader program linking failed:" << program->log();
+        // Picked from what the context actually is, not the platform we were built for
+        shaderVariant = detectShaderVariant();
+        IMU_LOG_INFO("Using {} shaders", shaderVariantName(shaderVariant));
+
+        const bool desktop330 = shaderVariant == ShaderVariant::GLSL_330;
+        if (!buildProgram(*program, "Main",
+                          desktop330 ? shaders::BODY_VERTEX_330 : shaders::BODY_VERTEX_ES,
+                          desktop330 ? shaders::BODY_FRAGMENT_330 : shaders::BODY_FRAGMENT_ES)) {
             return;
         }
 
@@ -593,7 +649,9 @@ namespace imu_viz {
         )";
 
         const char* simpleFragmentShaderES = R"(
+            #ifdef GL_ES
             precision mediump float;
+            #endif
             varying vec3 vertexColor;
 
             void main() {
@@ -601,107 +659,71 @@ namespace imu_viz {
             }
         )";
 
-        // Choose shader source based on platform
-        const char* simpleVertexSource;
-        const char* simpleFragmentSource;
-
-#ifdef __APPLE__
-        simpleVertexSource = simpleVertexShaderDesktop;
-        simpleFragmentSource = simpleFragmentShaderDesktop;
-        qDebug() << "Using Desktop OpenGL shaders for simpleProgram";
-#else
-        simpleVertexSource = simpleVertexShaderES;
-        simpleFragmentSource = simpleFragmentShaderES;
-        qDebug() << "Using OpenGL ES shaders for simpleProgram";
-#endif
-
-        if (!simpleProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, simpleVertexSource)) {
-            qDebug() << "Simple vertex shader compilation failed:" << simpleProgram->log();
-            return;
+        buildProgram(*simpleProgram, "Simple",
+                     desktop330 ? simpleVertexShaderDesktop : simpleVertexShaderES,
+                     desktop330 ? simpleFragmentShaderDesktop : simpleFragmentShaderES);
+
+        trailProgram = std::make_unique<QOpenGLShaderProgram>();
+        buildProgram(*trailProgram, "Trail",
+                     desktop330 ? shaders::TRAIL_VERTEX_330 : shaders::TRAIL_VERTEX_ES,
+                     desktop330 ? shaders::TRAIL_FRAGMENT_330 : shaders::TRAIL_FRAGMENT_ES);
+    }
+
+    GLWidget::ShaderVariant GLWidget::detectShaderVariant() const {
+        const QOpenGLContext* ctx = context();
+        if (ctx->isOpenGLES()) return ShaderVariant::GLSL_ES_100;
+        if (ctx->format().version() >= qMakePair(3, 3)) return ShaderVariant::GLSL_330;
+        return ShaderVariant::GLSL_110; // Old desktop driver, the ES sources with a desktop version line
+    }
+
+    const char* GLWidget::shaderVariantName(ShaderVariant variant) {
+        switch (variant) {
+            case ShaderVariant::GLSL_330: return "GLSL 3.30";
+            case ShaderVariant::GLSL_ES_100: return "GLSL ES 1.00";
+            case ShaderVariant::GLSL_110: return "GLSL 1.10";
         }
+        return "?";
+    }
 
-        if (!simpleProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, simpleFragmentSource)) {
-            qDebug() << "Simple fragment shader compilation failed:" << simpleProgram->log();
-            return;
+    bool GLWidget::buildProgram(QOpenGLShaderProgram& target, const char* name,
+                                const char* vertexSource, const char* fragmentSource) {
+        QByteArray vertex(vertexSource);
+        if (shaderVariant == ShaderVariant::GLSL_110) {
+            vertex.replace("#version 100", "#version 110");
         }
 
-        if (!simpleProgram->link()) {
-            qDebug() << "Simple shader program linking failed:" << simpleProgram->log();
-            return;
+        // Cacheable: Qt stores the linked binary on disk keyed by the sources and GL vendor/renderer/version,
+        // a warm start loads it instead of compiling. Falls back to compiling where binaries aren't supported
+        if (!target.addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertex)) {
+            IMU_LOG_ERROR("{} vertex shader compilation failed: {}", name, target.log().toStdString());
+            return false;
+        }
+
+        if (!target.addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource)) {
+            IMU_LOG_ERROR("{} fragment shader compilation failed: {}", name, target.log().toStdString());
+            return false;
         }
 
+        // GLSL 3.30 fixes these with layout qualifiers, the ES sources need them bound before linking
+        target.bindAttributeLocation("position", 0);
+        target.bindAttributeLocation("color", 1);
+        target.bindAttributeLocation("normal", 2);
+        target.bindAttributeLocation("sampleTime", 1); // Trail, in place of color
+
+        if (!target.link()) {
+            IMU_LOG_ERROR("{} shader program linking failed: {}", name, target.log().toStdString());
+            return false;
+        }
+        return true;
     }
 
     void GLWidget::setupBuffers() {
         vao.create();
         vao.bind();
-        static const float vertices[] = {
-                // Positions, colors, normals
-                // Front face (red)
-                // First triangle
-                -0.5f, -0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Bottom-left
-                +0.5f, -0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Bottom-right
-                +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Top-right
-                // Second triangle
-                -0.5f, -0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Bottom-left
-                +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Top-right
-                -0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 0.0f,   0.0f,  0.0f, +1.0f,  // Top-left
-
-                // Back face (green)
-                // First triangle
-                -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Bottom-left
-                +0.5f, +0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Top-right
-                +0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Bottom-right
-                // Second triangle
-                -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Bottom-left
-                -0.5f, +0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Top-left
-                +0.5f, +0.5f, -0.5f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f, -1.0f,  // Top-right
-
-                // Left face (blue)
-                // First triangle
-                -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Back-bottom
-                -0.5f, +0.5f, +0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Front-top
-                -0.5f, +0.5f, -0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Back-top
-                // Second triangle
-                -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Back-bottom
-                -0.5f, -0.5f, +0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Front-bottom
-                -0.5f, +0.5f, +0.5f,  0.0f, 0.0f, 1.0f,  -1.0f,  0.0f,  0.0f,  // Front-top
-
-                // Right face (yellow)
-                // First triangle
-                +0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Back-bottom
-                +0.5f, +0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Back-top
-                +0.5f, +0.5f, +0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Front-top
-                // Second triangle
-                +0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Back-bottom
-                +0.5f, +0.5f, +0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Front-top
-                +0.5f, -0.5f, +0.5f,  1.0f, 1.0f, 0.0f,  +1.0f,  0.0f,  0.0f,  // Front-bottom
-
-                // Top face (magenta)
-                // First triangle
-                -0.5f, +0.5f, -0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Back-left
-                +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Front-right
-                +0.5f, +0.5f, -0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Back-right
-                // Second triangle
-                -0.5f, +0.5f, -0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Back-left
-                -0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Front-left
-                +0.5f, +0.5f, +0.5f,  1.0f, 0.0f, 1.0f,   0.0f, +1.0f,  0.0f,  // Front-right
-
-                // Bottom face (cyan)
-                // First triangle
-                -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Back-left
-                +0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Back-right
-                +0.5f, -0.5f, +0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Front-right
-                // Second triangle
-                -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Back-left
-                +0.5f, -0.5f, +0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Front-right
-                -0.5f, -0.5f, +0.5f,  0.0f, 1.0f, 1.0f,   0.0f, -1.0f,  0.0f,  // Front-left
-        };
-
 
         vbo.create();
         vbo.bind();
-        vbo.allocate(vertices, sizeof(vertices));
+        vbo.allocate(CUBE_VERTICES, sizeof(CUBE_VERTICES));
 
         program->bind();
 
@@ -756,6 +778,7 @@ namespace imu_viz {
     }
 
     void GLWidget::drawAxes() {
+        IMU_PROFILE_ZONE("GLWidget::drawAxes");
         if (!axesVAO.isCreated()) return;
 
         simpleProgram->bind();
@@ -775,6 +798,7 @@ namespace imu_viz {
     }
 
     void GLWidget::drawGrid() {
+        IMU_PROFILE_ZONE("GLWidget::drawGrid");
         if (!gridVAO.isCreated()) return;
 
         simpleProgram->bind();
@@ -10,8 +10,19 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
+#include <QOpenGLTimerQuery>
 #include <QMatrix4x4>
-#include "imu_visualizer/common.h"
+#include "imu_visualizer/metatypes.h"
+#include "orientation_predictor.h"
+#include "frame_pacer.h"
+#include "body_renderer.h"
+#include "trail_renderer.h"
+#include "core/logger.h"
+#include "core/triple_buffer.h"
+#include "processing/latency_monitor.h"
+#include "processing/fusion_engine.h"
+
+class QTimer;
 
 namespace imu_viz {
     class GLWidget : public QOpenGLWidget, protected QOpenGLFunctions {
@@ -27,18 +38,71 @@ namespace imu_viz {
         void resetCamera();
         void setRotationSpeed(float speed) {
             rotationSpeed = speed;
-            qDebug() << "Rotation speed set to:" << speed;
+            IMU_LOG_DEBUG("Rotation speed set to: {}", speed);
         }
         void setPanSpeed(float speed) {
             panSpeed = speed;
-            qDebug() << "Pan speed set to:" << speed;
+            IMU_LOG_DEBUG("Pan speed set to: {}", speed);
         }
         void setZoomSpeed(float speed) {
             zoomSpeed = speed;
-            qDebug() << "Zoom speed set to:" << speed;
+            IMU_LOG_DEBUG("Zoom speed set to: {}", speed);
         }
+
+        // Polled once per frame, however fast the sensor publishes into it
+        void setOrientationSource(TripleBuffer<OrientationSample>* source) { orientationSource = source; }
+
+        // Receives the publish -> paint -> swap segments of each sample's latency
+        void setLatencyMonitor(LatencyMonitor* monitor) { latencyMonitor = monitor; }
+
+        // Max extrapolation ahead of the latest sample, 0 shows samples as they arrive
+        void setPredictionHorizon(double ms);
+        double getPredictionError() const { return predictor.getResidualErrorDeg(); }
+
+        // paintGL to paintGL, for the metrics endpoint
+        const LatencyHistogram& getFrameTimes() const { return frameTimes; }
+
+        // Time spent in paintGL, and on the GPU where timer queries exist (not on GLES)
+        const LatencyHistogram& getCpuFrameTimes() const { return cpuFrameTimes; }
+        const LatencyHistogram& getGpuFrameTimes() const { return gpuFrameTimes; }
+        bool hasGpuTiming() const { return gpuTimingSupported; }
+        uint64_t getFramesPainted() const { return framesPainted; }
+        void resetFrameStats();
+
+        // Frames are only drawn when a sample, camera move or overlay change is pending.
+        // 0 caps at the display refresh, lower caps land on every 2nd, 3rd, ... vsync
+        void setFrameRateCap(int fps);
+        int getFrameRateCap() const { return pacer.getMaxFps(); }
+        void setIdleEnabled(bool enabled);
+
+        // Redraw every vsync whether or not anything changed, the old behaviour, for comparison
+        void setContinuousRendering(bool continuous);
+        bool isContinuousRendering() const { return continuousRendering; }
+
+        // Anything that changes what is on screen calls this instead of update()
+        void requestFrame();
+
+        // Bodies laid out in a grid, one instanced draw for all of them. Until several sensors are
+        // ingested every body shows the live orientation
+        static constexpr int MAX_BODIES = 4096;
+        void setBodyCount(int count);
+        int getBodyCount() const { return static_cast<int>(bodies.size()); }
+        bool isInstancedRendering() const { return bodyRenderer.isReady(); }
+
+        // Axis tip trail of the first body, fed from every published sample rather than once per frame.
+        // The ring is sized for TRAIL_RATE_HZ, faster input shortens the trail. 0 seconds hides it
+        static constexpr double MAX_TRAIL_SECONDS = 60.0;
+        static constexpr double TRAIL_RATE_HZ = 1000.0;
+        void setOrientationHistory(FusionEngine::OrientationHistory* history) { orientationHistory = history; }
+        void setTrailLength(double seconds);
+        double getTrailLength() const { return trailSeconds; }
+
+        // Startup cost: shader build (compile, or a cached binary load) and construction to first swap. 0 until known
+        int64_t getShaderSetupNs() const { return shaderSetupNs; }
+        int64_t getTimeToFirstFrameNs() const { return timeToFirstFrameNs; }
     public slots:
         void updateOrientation(const imu_viz::Quaterniond& orientation);
+        void updateOrientationSample(const imu_viz::OrientationSample& sample);
     signals:
         void cameraChanged();
 
@@ -81,6 +145,19 @@ namespace imu_viz {
         // Shader program
         std::unique_ptr<QOpenGLShaderProgram> program;
         std::unique_ptr<QOpenGLShaderProgram> simpleProgram;
+        std::unique_ptr<QOpenGLShaderProgram> trailProgram;
+
+        // Desktop GL 3.3+, GLES 2 (the Pi), or an older desktop context running the ES sources
+        enum class ShaderVariant { GLSL_330, GLSL_ES_100, GLSL_110 };
+        ShaderVariant shaderVariant{ShaderVariant::GLSL_330};
+        ShaderVariant detectShaderVariant() const;
+        static const char* shaderVariantName(ShaderVariant variant);
+        bool buildProgram(QOpenGLShaderProgram& target, const char* name,
+                          const char* vertexSource, const char* fragmentSource);
+
+        int64_t constructedNs{0};
+        int64_t shaderSetupNs{0};
+        int64_t timeToFirstFrameNs{0};
 
         // Matrices
         QMatrix4x4 projection;
@@ -91,6 +168,46 @@ namespace imu_viz {
         QOpenGLVertexArrayObject vao;
         QOpenGLBuffer vbo;
 
+        // Per body orientation, layout position and tint, uploaded once per frame
+        std::vector<BodyInstance> bodies = std::vector<BodyInstance>(1);
+        BodyRenderer bodyRenderer;
+        void drawBodies(const Quaterniond& orientation);
+
+        FusionEngine::OrientationHistory* orientationHistory{nullptr};
+        TrailRenderer trail;
+        double trailSeconds{0.0};
+        void drawTrail(int64_t nowNs);
+
+        // Render time prediction, the model matrix is set in paintGL from this
+        OrientationPredictor predictor;
+        TripleBuffer<OrientationSample>* orientationSource{nullptr};
+        int64_t lastPaintNs{0};
+        double frameIntervalMs{16.7}; // Smoothed paint interval, stands in for the presentation delay
+        LatencyHistogram frameTimes;
+
+        LatencyMonitor* latencyMonitor{nullptr};
+        int64_t pendingArrivalNs{0}; // Sample drawn by the last paintGL, waiting for frameSwapped
+        int64_t pendingPaintNs{0};
+
+        // Frame scheduling, replaces an update() at the end of every paintGL
+        FramePacer pacer;
+        QTimer* frameTimer;
+        bool continuousRendering{false};
+        bool frameDirty{true};     // Camera or overlay changed since the last paint
+        bool framePending{false};  // update() issued, waiting for frameSwapped
+        void checkForFrame();
+        void armFrameTimer(int delayMs);
+
+        // Per frame cost, the GPU query is read a frame later so it never stalls the pipeline
+        LatencyHistogram cpuFrameTimes;
+        LatencyHistogram gpuFrameTimes;
+        uint64_t framesPainted{0};
+        QOpenGLTimerQuery gpuTimers[2];
+        bool gpuTimerPending[2]{false, false};
+        int gpuTimerIndex{0};
+        bool gpuTimingSupported{false};
+        void collectGpuTime(int index);
+
         // Display flags
         bool showAxes{true};
         bool showGrid{true};
@@ -0,0 +1,83 @@
+//
+// Created by Raphael Russo on 12/10/24.
+//
+
+#ifndef IMU_VISUALIZER_ORIENTATION_PREDICTOR_H
+#define IMU_VISUALIZER_ORIENTATION_PREDICTOR_H
+#pragma once
+
+#include "core/imu_data.h"
+#include <algorithm>
+#include <cmath>
+
+namespace imu_viz {
+
+    /**
+     * Extrapolates the latest published orientation to when the frame will actually be seen.
+     * Lead = sample age + smoothing lag + presentation delay, capped by the horizon so a stalled
+     * stream doesn't spin the model off on its last gyro reading.
+     */
+    class OrientationPredictor {
+    public:
+        static constexpr double DEFAULT_HORIZON_MS = 50.0;
+
+        void setHorizonMs(double horizon) { horizonMs = std::max(0.0, horizon); }
+        double getHorizonMs() const { return horizonMs; }
+
+        void update(const OrientationSample& sample) {
+            // Residual: how far extrapolating the previous sample misses this one
+            if (hasSample && sample.timestamp > latest.timestamp) {
+                const double dt = static_cast<double>(sample.timestamp - latest.timestamp) * 1e-6;
+                if (dt < MAX_RESIDUAL_INTERVAL) {
+                    const double error = extrapolate(latest, dt).angularDistance(sample.orientation) * 180.0 / M_PI;
+                    residualSq += RESIDUAL_SMOOTHING * (error * error - residualSq);
+                }
+            }
+            latest = sample;
+            hasSample = true;
+        }
+
+        // nowNs on the same steady clock as OrientationSample::publishTimeNs
+        Quaterniond predict(int64_t nowNs, double presentationDelayMs) const {
+            if (!hasSample) return Quaterniond::Identity();
+            if (horizonMs <= 0.0) return latest.orientation;
+
+            const double ageMs = static_cast<double>(nowNs - latest.publishTimeNs) * 1e-6;
+            const double leadMs = std::clamp(ageMs + latest.smoothingLatencyMs + presentationDelayMs, 0.0, horizonMs);
+            return extrapolate(latest, leadMs * 1e-3);
+        }
+
+        // Whether predict() still moves at nowNs, once the lead hits the horizon the model holds still
+        bool isExtrapolating(int64_t nowNs) const {
+            if (!hasSample || horizonMs <= 0.0 || latest.angularVelocity.isZero()) return false;
+            return static_cast<double>(nowNs - latest.publishTimeNs) * 1e-6 < horizonMs;
+        }
+
+        // RMS over roughly the last 50 samples, degrees
+        double getResidualErrorDeg() const { return std::sqrt(residualSq); }
+
+        void reset() {
+            hasSample = false;
+            residualSq = 0.0;
+        }
+
+    private:
+        static constexpr double RESIDUAL_SMOOTHING = 0.02;
+        static constexpr double MAX_RESIDUAL_INTERVAL = 0.5; // s, longer gaps say nothing about the model
+
+        double horizonMs{DEFAULT_HORIZON_MS};
+        OrientationSample latest;
+        bool hasSample{false};
+        double residualSq{0.0};
+
+        // Constant body rate over dt
+        static Quaterniond extrapolate(const OrientationSample& sample, double dt) {
+            const Vector3d rotation = sample.angularVelocity * dt;
+            const double angle = rotation.norm();
+            if (angle < 1e-12) return sample.orientation;
+            return (sample.orientation * Quaterniond(Eigen::AngleAxisd(angle, rotation / angle))).normalized();
+        }
+    };
+}
+
+#endif //IMU_VISUALIZER_ORIENTATION_PREDICTOR_H
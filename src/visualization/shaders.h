@@ -0,0 +1,314 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_SHADERS_H
+#define IMU_VISUALIZER_SHADERS_H
+#pragma once
+
+// Body (cube) shader sources, shared by GLWidget, BodyRenderer and the render benchmark.
+// Vertex layout: 0 position, 1 color, 2 normal. The trail and plot shaders at the end are TrailRenderer's
+// and SignalPlotWidget's
+
+namespace imu_viz::shaders {
+
+    // Desktop GL 3.3+
+    inline constexpr const char* BODY_VERTEX_330 = R"(
+    #version 330 core
+    layout(location = 0) in vec3 position;
+    layout(location = 1) in vec3 color;
+    layout(location = 2) in vec3 normal;
+
+    uniform mat4 projection;
+    uniform mat4 view;
+    uniform mat4 model;
+    uniform mat3 normalMatrix;
+
+    out vec3 fragPos;
+    out vec3 vertexColor;
+    out vec3 fragNormal;
+
+    void main() {
+        vertexColor = color;
+        fragPos = vec3(model * vec4(position, 1.0));
+
+        // Transform normal to world space maintaining correct orientation
+        fragNormal = normalize(normalMatrix * normal);
+
+        gl_Position = projection * view * model * vec4(position, 1.0);
+    }
+)";
+
+    inline constexpr const char* BODY_FRAGMENT_330 = R"(
+    #version 330 core
+    in vec3 fragPos;
+    in vec3 vertexColor;
+    in vec3 fragNormal;
+
+    out vec4 fragColor;
+
+    uniform vec3 lightPos;    // Main light
+    uniform vec3 viewPos;
+
+    // Material properties
+    const float ambientStrength = 0.15;
+    const float diffuseStrength = 0.7;
+    const float specularStrength = 0.8;
+    const float shininess = 64.0;
+
+    // Secondary light sources for better illumination
+    const vec3 fillLightPos = vec3(-5.0, 3.0, -5.0);
+    const vec3 fillLightColor = vec3(0.2, 0.2, 0.3);
+    const float fillLightIntensity = 0.3;
+
+    const vec3 rimLightDir = vec3(0.0, 0.0, -1.0);
+    const vec3 rimLightColor = vec3(0.1, 0.1, 0.15);
+    const float rimLightIntensity = 0.2;
+
+    vec3 calculateLight(vec3 lightPosition, vec3 lightColor, float intensity) {
+        vec3 normal = normalize(fragNormal);
+        vec3 lightDir = normalize(lightPosition - fragPos);
+        vec3 viewDir = normalize(viewPos - fragPos);
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+
+        // Ambient
+        vec3 ambient = ambientStrength * lightColor;
+
+        // Diffuse
+        float diff = max(dot(normal, lightDir), 0.0);
+        vec3 diffuse = diffuseStrength * diff * lightColor;
+
+        // Specular (Blinn-Phong)
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+        vec3 specular = specularStrength * spec * lightColor;
+
+        // Edge highlighting (rim lighting)
+        float rim = 1.0 - max(dot(viewDir, normal), 0.0);
+        rim = smoothstep(0.6, 1.0, rim);
+
+        return intensity * (ambient + diffuse + specular);
+    }
+
+    void main() {
+        // Main light (warm white)
+        vec3 mainLight = calculateLight(lightPos, vec3(1.0, 0.95, 0.8), 1.0);
+
+        // Fill light (cool blue)
+        vec3 fillLight = calculateLight(fillLightPos, fillLightColor, fillLightIntensity);
+
+        // Rim light
+        vec3 normal = normalize(fragNormal);
+        vec3 viewDir = normalize(viewPos - fragPos);
+        float rim = 1.0 - max(dot(viewDir, normal), 0.0);
+        rim = smoothstep(0.6, 1.0, rim);
+        vec3 rimLight = rim * rimLightColor * rimLightIntensity;
+
+        // Combine all lighting
+        vec3 result = (mainLight + fillLight + rimLight) * vertexColor;
+
+        // Tone mapping then gamma correction
+        result = result / (result + vec3(1.0));
+        result = pow(result, vec3(1.0/2.2));
+
+        fragColor = vec4(result, 1.0);
+    }
+)";
+
+    // Instanced variant of BODY_VERTEX_330, per instance: 3 rotation quaternion (x, y, z, w),
+    // 4 offset (xyz) and uniform scale (w), 5 tint. Same outputs, so it pairs with BODY_FRAGMENT_330
+    inline constexpr const char* BODY_INSTANCED_VERTEX_330 = R"(
+    #version 330 core
+    layout(location = 0) in vec3 position;
+    layout(location = 1) in vec3 color;
+    layout(location = 2) in vec3 normal;
+    layout(location = 3) in vec4 instanceRotation;
+    layout(location = 4) in vec4 instanceOffsetScale;
+    layout(location = 5) in vec3 instanceTint;
+
+    uniform mat4 projection;
+    uniform mat4 view;
+
+    out vec3 fragPos;
+    out vec3 vertexColor;
+    out vec3 fragNormal;
+
+    // Rotates v by the unit quaternion q
+    vec3 rotate(vec4 q, vec3 v) {
+        return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+    }
+
+    void main() {
+        vertexColor = color * instanceTint;
+        fragPos = rotate(instanceRotation, position * instanceOffsetScale.w) + instanceOffsetScale.xyz;
+        fragNormal = rotate(instanceRotation, normal);
+        gl_Position = projection * view * vec4(fragPos, 1.0);
+    }
+)";
+
+    // Raspberry Pi (OpenGL ES 2), also run on desktop contexts older than 3.3
+    inline constexpr const char* BODY_VERTEX_ES = R"(
+        #version 100
+        attribute vec3 position;
+        attribute vec3 color;
+        attribute vec3 normal;
+
+        uniform mat4 projection;
+        uniform mat4 view;
+        uniform mat4 model;
+        uniform mat3 normalMatrix;
+
+        varying vec3 fragPos;
+        varying vec3 vertexColor;
+        varying vec3 fragNormal;
+
+        void main() {
+            vertexColor = color;
+            fragPos = vec3(model * vec4(position, 1.0));
+            // Transform normal to world space
+            fragNormal = normalMatrix * normal;
+            gl_Position = projection * view * model * vec4(position, 1.0);
+        }
+    )";
+
+    inline constexpr const char* BODY_FRAGMENT_ES = R"(
+        #ifdef GL_ES
+        precision mediump float;
+        #endif
+        varying vec3 fragPos;
+        varying vec3 vertexColor;
+        varying vec3 fragNormal;
+
+        uniform vec3 lightPos;
+        uniform vec3 viewPos;
+
+        void main() {
+            // Ambient
+            float ambientStrength = 0.1;
+            vec3 ambient = ambientStrength * vertexColor;
+
+            // Diffuse
+            vec3 norm = normalize(fragNormal);
+            vec3 lightDir = normalize(lightPos - fragPos);
+            float diff = max(dot(norm, lightDir), 0.0);
+            vec3 diffuse = diff * vertexColor;
+
+            // Specular
+            float specularStrength = 0.5;
+            vec3 viewDir = normalize(viewPos - fragPos);
+            vec3 reflectDir = reflect(-lightDir, norm);
+            float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+            vec3 specular = specularStrength * spec * vec3(1.0);
+
+            vec3 result = ambient + diffuse + specular;
+            gl_FragColor = vec4(result, 1.0);
+        }
+    )";
+
+    // Orientation trail, vertex layout: 0 position, 1 sampleTime (seconds on the trail's clock).
+    // Fades out by age, so nothing on the CPU touches old vertices as they get older
+    inline constexpr const char* TRAIL_VERTEX_330 = R"(
+    #version 330 core
+    layout(location = 0) in vec3 position;
+    layout(location = 1) in float sampleTime;
+
+    uniform mat4 projection;
+    uniform mat4 view;
+    uniform mat4 model;
+    uniform float now;
+    uniform float duration;
+
+    out float fade;
+
+    void main() {
+        fade = clamp(1.0 - (now - sampleTime) / duration, 0.0, 1.0);
+        gl_Position = projection * view * model * vec4(position, 1.0);
+    }
+)";
+
+    inline constexpr const char* TRAIL_FRAGMENT_330 = R"(
+    #version 330 core
+    in float fade;
+    uniform vec3 trailColor;
+    out vec4 fragColor;
+
+    void main() {
+        fragColor = vec4(trailColor, fade);
+    }
+)";
+
+    inline constexpr const char* TRAIL_VERTEX_ES = R"(
+        #version 100
+        attribute vec3 position;
+        attribute float sampleTime;
+
+        uniform mat4 projection;
+        uniform mat4 view;
+        uniform mat4 model;
+        uniform float now;
+        uniform float duration;
+
+        varying float fade;
+
+        void main() {
+            fade = clamp(1.0 - (now - sampleTime) / duration, 0.0, 1.0);
+            gl_Position = projection * view * model * vec4(position, 1.0);
+        }
+    )";
+
+    inline constexpr const char* TRAIL_FRAGMENT_ES = R"(
+        #ifdef GL_ES
+        precision mediump float;
+        #endif
+        varying float fade;
+        uniform vec3 trailColor;
+
+        void main() {
+            gl_FragColor = vec4(trailColor, fade);
+        }
+    )";
+
+    // Signal plots, vertex layout: 0 point (column, value). transform maps both into the pane's
+    // viewport as scale xy, offset zw
+    inline constexpr const char* PLOT_VERTEX_330 = R"(
+    #version 330 core
+    layout(location = 0) in vec2 point;
+    uniform vec4 transform;
+
+    void main() {
+        gl_Position = vec4(point * transform.xy + transform.zw, 0.0, 1.0);
+    }
+)";
+
+    inline constexpr const char* PLOT_FRAGMENT_330 = R"(
+    #version 330 core
+    uniform vec3 lineColor;
+    out vec4 fragColor;
+
+    void main() {
+        fragColor = vec4(lineColor, 1.0);
+    }
+)";
+
+    inline constexpr const char* PLOT_VERTEX_ES = R"(
+        #version 100
+        attribute vec2 point;
+        uniform vec4 transform;
+
+        void main() {
+            gl_Position = vec4(point * transform.xy + transform.zw, 0.0, 1.0);
+        }
+    )";
+
+    inline constexpr const char* PLOT_FRAGMENT_ES = R"(
+        #ifdef GL_ES
+        precision mediump float;
+        #endif
+        uniform vec3 lineColor;
+
+        void main() {
+            gl_FragColor = vec4(lineColor, 1.0);
+        }
+    )";
+}
+
+#endif //IMU_VISUALIZER_SHADERS_H
@@ -0,0 +1,330 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#include "signal_plot_widget.h"
+#include "shaders.h"
+#include <QOpenGLContext>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QTimer>
+#include <QVector3D>
+#include <QVector4D>
+#include <QWheelEvent>
+#include "core/clock.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace imu_viz {
+    namespace {
+        // x, y, z (and roll, pitch, yaw) in the axes' colours, lightened to read on the dark background
+        const float CHANNEL_COLORS[3][3] = {
+                {1.0f, 0.35f, 0.35f},
+                {0.35f, 1.0f, 0.35f},
+                {0.45f, 0.6f, 1.0f}
+        };
+
+        std::array<float, 3> toEulerDegrees(const Quaterniond& q) {
+            const double w = q.w(), x = q.x(), y = q.y(), z = q.z();
+            const double roll = std::atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
+            const double pitch = std::asin(std::clamp(2.0 * (w * y - z * x), -1.0, 1.0));
+            const double yaw = std::atan2(2.0 * (w * z + x * y), 1.0 - 2.0 * (y * y + z * z));
+            constexpr double degrees = 180.0 / M_PI;
+            return {static_cast<float>(roll * degrees), static_cast<float>(pitch * degrees),
+                    static_cast<float>(yaw * degrees)};
+        }
+    }
+
+    SignalPlotWidget::SignalPlotWidget(QWidget* parent)
+            : QOpenGLWidget(parent)
+            , refreshTimer(new QTimer(this))
+            , vbo(QOpenGLBuffer::VertexBuffer)
+    {
+        panes[0] = Pane{"Accel", {"x", "y", "z"}, false, 0};
+        panes[1] = Pane{"Gyro", {"x", "y", "z"}, false, 3};
+        panes[2] = Pane{"Orientation (deg)", {"roll", "pitch", "yaw"}, true, 0};
+
+        imuColumns.resize(MAX_COLUMNS);
+        orientationColumns.resize(MAX_COLUMNS);
+        vertices.reserve(static_cast<size_t>(PANE_COUNT) * 3 * MAX_COLUMNS * 4);
+        vbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
+        // Samples go into the pyramids at this rate whether or not a paint follows, the queues never fill.
+        // The time axis follows the clock, so anything still in view repaints even without new samples,
+        // with one interval of margin for the paint that scrolls it out
+        connect(refreshTimer, &QTimer::timeout, this, [this]() {
+            drain();
+            const int64_t newestNs = std::max(imuHistory.newestTimeNs(), orientationHistory.newestTimeNs());
+            const int64_t viewStartNs = steadyNowNs() - static_cast<int64_t>(spanSeconds * 1e9)
+                                        - static_cast<int64_t>(REFRESH_INTERVAL_MS) * 1000000;
+            if (dirty || (isVisible() && newestNs > viewStartNs)) update();
+        });
+        refreshTimer->start(REFRESH_INTERVAL_MS);
+    }
+
+    SignalPlotWidget::~SignalPlotWidget() {
+        makeCurrent();
+        vbo.destroy();
+        vao.destroy();
+        program.reset();
+        doneCurrent();
+    }
+
+    void SignalPlotWidget::setSources(FusionEngine::SampleHistory* samples,
+                                      FusionEngine::OrientationHistory* orientations) {
+        sampleSource = samples;
+        orientationSource = orientations;
+    }
+
+    void SignalPlotWidget::setSpan(double seconds) {
+        seconds = std::clamp(seconds, MIN_SPAN_SECONDS, MAX_SPAN_SECONDS);
+        if (seconds == spanSeconds) return;
+        spanSeconds = seconds;
+        dirty = true;
+        update();
+        emit spanChanged(spanSeconds);
+    }
+
+    void SignalPlotWidget::clear() {
+        imuHistory.clear();
+        orientationHistory.clear();
+        hasAngles = false;
+        dirty = true;
+        update();
+    }
+
+    void SignalPlotWidget::drain() {
+        IMU_PROFILE_ZONE("SignalPlotWidget::drain");
+        bool any = false;
+
+        IMUData sample;
+        while (sampleSource && sampleSource->tryPop(sample)) {
+            const int64_t timeNs = sample.arrivalTimeNs != 0 ? sample.arrivalTimeNs : steadyNowNs();
+            imuHistory.append(timeNs, {static_cast<float>(sample.acceleration.x()),
+                                       static_cast<float>(sample.acceleration.y()),
+                                       static_cast<float>(sample.acceleration.z()),
+                                       static_cast<float>(sample.gyroscope.x()),
+                                       static_cast<float>(sample.gyroscope.y()),
+                                       static_cast<float>(sample.gyroscope.z())});
+            any = true;
+        }
+
+        OrientationSample orientation;
+        while (orientationSource && orientationSource->tryPop(orientation)) {
+            orientationHistory.append(orientation.publishTimeNs, unwrapAngles(toEulerDegrees(orientation.orientation)));
+            any = true;
+        }
+
+        if (any) dirty = true;
+    }
+
+    std::array<float, 3> SignalPlotWidget::unwrapAngles(const std::array<float, 3>& angles) {
+        // Roll and yaw come from atan2 and wrap at +-180, a turn through it would fill the pane with one
+        // full range column. Pitch stays within +-90. Continuous from the first sample, so they can pass 180
+        std::array<float, 3> out = angles;
+        for (size_t ch : {size_t{0}, size_t{2}}) {
+            if (hasAngles) {
+                const double step = angles[ch] + unwrapOffsets[ch] - lastAngles[ch];
+                if (step > 180.0) unwrapOffsets[ch] -= 360.0;
+                else if (step < -180.0) unwrapOffsets[ch] += 360.0;
+            } else {
+                unwrapOffsets[ch] = 0.0;
+            }
+            out[ch] = static_cast<float>(angles[ch] + unwrapOffsets[ch]);
+        }
+        lastAngles = out;
+        hasAngles = true;
+        return out;
+    }
+
+    void SignalPlotWidget::wheelEvent(QWheelEvent* event) {
+        // Up zooms in
+        const double notches = event->angleDelta().y() / 120.0;
+        setSpan(spanSeconds * std::pow(WHEEL_ZOOM, -notches));
+        event->accept();
+    }
+
+    void SignalPlotWidget::initializeGL() {
+        initializeOpenGLFunctions();
+        glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
+
+        // Same choice as GLWidget: GLSL 3.30 on desktop 3.3+, otherwise the ES sources, with a desktop
+        // version line on old desktop drivers
+        const QOpenGLContext* ctx = context();
+        const bool desktop330 = !ctx->isOpenGLES() && ctx->format().version() >= qMakePair(3, 3);
+        QByteArray vertex(desktop330 ? shaders::PLOT_VERTEX_330 : shaders::PLOT_VERTEX_ES);
+        if (!desktop330 && !ctx->isOpenGLES()) {
+            vertex.replace("#version 100", "#version 110");
+        }
+
+        program = std::make_unique<QOpenGLShaderProgram>();
+        program->bindAttributeLocation("point", 0);
+        if (!program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertex) ||
+            !program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment,
+                                                       desktop330 ? shaders::PLOT_FRAGMENT_330
+                                                                  : shaders::PLOT_FRAGMENT_ES) ||
+            !program->link()) {
+            IMU_LOG_ERROR("Plot shader program failed: {}", program->log().toStdString());
+            program.reset();
+            return;
+        }
+
+        vao.create();
+        vao.bind();
+        vbo.create();
+        vbo.bind();
+        vbo.allocate(static_cast<int>(vertices.capacity() * sizeof(float)));
+        program->enableAttributeArray(0);
+        program->setAttributeBuffer(0, GL_FLOAT, 0, 2, 2 * sizeof(float));
+        vao.release();
+        vbo.release();
+    }
+
+    void SignalPlotWidget::resizeGL(int, int) {
+        dirty = true;
+    }
+
+    QRect SignalPlotWidget::paneRect(int index) const {
+        const int paneHeight = std::max(1, (height() - (PANE_COUNT - 1) * PANE_GAP) / PANE_COUNT);
+        return {0, index * (paneHeight + PANE_GAP), width(), paneHeight};
+    }
+
+    template <typename Column>
+    void SignalPlotWidget::buildPane(Pane& pane, const std::vector<Column>& columns, int columnCount) {
+        // Fit the value axis to what is on screen
+        float low = INFINITY;
+        float high = -INFINITY;
+        for (int c = 0; c < columnCount; ++c) {
+            if (!columns[c].valid) continue;
+            for (size_t ch = pane.firstChannel; ch < pane.firstChannel + 3; ++ch) {
+                low = std::min(low, columns[c].min[ch]);
+                high = std::max(high, columns[c].max[ch]);
+            }
+        }
+        if (low > high) {
+            low = -1.0f;
+            high = 1.0f;
+        }
+        const float padding = std::max((high - low) * 0.05f, 1e-3f);
+        pane.low = low - padding;
+        pane.high = high + padding;
+
+        // Down to the column's min then up to its max, the strip traces the envelope at any zoom
+        for (size_t i = 0; i < 3; ++i) {
+            const size_t ch = pane.firstChannel + i;
+            Strip& strip = pane.strips[i];
+            strip.first = static_cast<int>(vertices.size() / 2);
+            for (int c = 0; c < columnCount; ++c) {
+                if (!columns[c].valid) continue;
+                const float x = static_cast<float>(c) + 0.5f;
+                vertices.insert(vertices.end(), {x, columns[c].min[ch], x, columns[c].max[ch]});
+            }
+            strip.count = static_cast<int>(vertices.size() / 2) - strip.first;
+        }
+    }
+
+    void SignalPlotWidget::paintGL() {
+        IMU_PROFILE_ZONE("SignalPlotWidget::paintGL");
+        dirty = false;
+
+        // QPainter leaves its own state behind from the last paint
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        const qreal ratio = devicePixelRatioF();
+        const int columnCount = std::clamp(static_cast<int>(width() * ratio), 1, MAX_COLUMNS);
+
+        // One pair per column from each pyramid, however much history the span covers
+        const int64_t toNs = steadyNowNs();
+        const int64_t fromNs = toNs - static_cast<int64_t>(spanSeconds * 1e9);
+        const size_t imuLevel = imuHistory.query(fromNs, toNs, imuColumns.data(), columnCount);
+        orientationHistory.query(fromNs, toNs, orientationColumns.data(), columnCount);
+        IMU_LOG_EVERY_N(TRACE, 300, "Plot {} columns over {} s from pyramid level {}",
+                        columnCount, spanSeconds, imuLevel);
+
+        vertices.clear();
+        for (auto& pane : panes) {
+            if (pane.orientation) {
+                buildPane(pane, orientationColumns, columnCount);
+            } else {
+                buildPane(pane, imuColumns, columnCount);
+            }
+        }
+
+        if (program) {
+            // Orphan then fill, same as the body instances
+            vbo.bind();
+            vbo.allocate(static_cast<int>(vertices.capacity() * sizeof(float)));
+            vbo.write(0, vertices.data(), static_cast<int>(vertices.size() * sizeof(float)));
+            vbo.release();
+
+            program->bind();
+            vao.bind();
+            glEnable(GL_SCISSOR_TEST);
+            for (int i = 0; i < PANE_COUNT; ++i) {
+                const Pane& pane = panes[i];
+                const QRect rect = paneRect(i);
+                const int x = static_cast<int>(rect.x() * ratio);
+                const int y = static_cast<int>((height() - rect.bottom() - 1) * ratio);
+                const int w = static_cast<int>(rect.width() * ratio);
+                const int h = static_cast<int>(rect.height() * ratio);
+                glViewport(x, y, w, h);
+                glScissor(x, y, w, h);
+                glClearColor(0.18f, 0.18f, 0.18f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+
+                // Columns 0..columnCount and low..high onto -1..1
+                const float scaleX = 2.0f / static_cast<float>(columnCount);
+                const float scaleY = 2.0f / (pane.high - pane.low);
+                program->setUniformValue("transform", QVector4D(scaleX, scaleY, -1.0f, -1.0f - pane.low * scaleY));
+
+                for (int ch = 0; ch < 3; ++ch) {
+                    const Strip& strip = pane.strips[ch];
+                    if (strip.count < 2) continue;
+                    program->setUniformValue("lineColor", QVector3D(CHANNEL_COLORS[ch][0], CHANNEL_COLORS[ch][1],
+                                                                    CHANNEL_COLORS[ch][2]));
+                    glDrawArrays(GL_LINE_STRIP, strip.first, strip.count);
+                }
+            }
+            glDisable(GL_SCISSOR_TEST);
+            vao.release();
+            program->release();
+            glViewport(0, 0, static_cast<int>(width() * ratio), static_cast<int>(height() * ratio));
+        }
+
+        drawLabels();
+    }
+
+    void SignalPlotWidget::drawLabels() {
+        QPainter painter(this);
+        const QFontMetrics metrics(painter.font());
+
+        for (int i = 0; i < PANE_COUNT; ++i) {
+            const Pane& pane = panes[i];
+            const QRect rect = paneRect(i).adjusted(4, 2, -4, -2);
+
+            painter.setPen(QColor(220, 220, 220));
+            painter.drawText(rect, Qt::AlignTop | Qt::AlignLeft,
+                             QString("%1  %2").arg(pane.title).arg(pane.high, 0, 'g', 4));
+            painter.drawText(rect, Qt::AlignBottom | Qt::AlignLeft, QString::number(pane.low, 'g', 4));
+
+            // Legend in the line colours, right aligned
+            int right = rect.right();
+            for (int ch = 2; ch >= 0; --ch) {
+                const QString name(pane.channelNames[ch]);
+                const int textWidth = metrics.horizontalAdvance(name);
+                painter.setPen(QColor::fromRgbF(CHANNEL_COLORS[ch][0], CHANNEL_COLORS[ch][1], CHANNEL_COLORS[ch][2]));
+                painter.drawText(right - textWidth, rect.top() + metrics.ascent(), name);
+                right -= textWidth + metrics.horizontalAdvance("  ");
+            }
+        }
+
+        const QRect last = paneRect(PANE_COUNT - 1).adjusted(4, 2, -4, -2);
+        painter.setPen(QColor(160, 160, 160));
+        painter.drawText(last, Qt::AlignBottom | Qt::AlignRight, QString("last %1 s").arg(spanSeconds, 0, 'g', 4));
+    }
+}
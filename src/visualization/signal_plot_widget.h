@@ -0,0 +1,127 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_SIGNAL_PLOT_WIDGET_H
+#define IMU_VISUALIZER_SIGNAL_PLOT_WIDGET_H
+#pragma once
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include "core/minmax_pyramid.h"
+#include "processing/fusion_engine.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+namespace imu_viz {
+
+    /**
+     * Scrolling plots of the raw accelerometer and gyroscope channels and the filter output as
+     * roll/pitch/yaw, newest sample at the right edge.
+     *
+     * Samples are drained from the engine's history queues into min/max pyramids as they arrive. Each
+     * paint asks the pyramids for one min/max pair per pixel column and draws them as a line strip per
+     * channel, so the vertices uploaded and drawn follow the plot width whether it shows a second or
+     * an hour of history.
+     */
+    class SignalPlotWidget : public QOpenGLWidget, protected QOpenGLFunctions {
+    Q_OBJECT
+
+    public:
+        static constexpr double MIN_SPAN_SECONDS = 0.1;
+        static constexpr double MAX_SPAN_SECONDS = 3600.0;
+        static constexpr double DEFAULT_SPAN_SECONDS = 10.0;
+        static constexpr int REFRESH_INTERVAL_MS = 33; // Drain and repaint when there's something new
+        static constexpr int MAX_COLUMNS = 4096;
+
+        explicit SignalPlotWidget(QWidget* parent = nullptr);
+        ~SignalPlotWidget() override;
+
+        // Both queues are single consumer, nothing else may pop them
+        void setSources(FusionEngine::SampleHistory* samples, FusionEngine::OrientationHistory* orientations);
+
+        // Time shown across the width, the mouse wheel zooms it too
+        void setSpan(double seconds);
+        double getSpan() const { return spanSeconds; }
+
+        void clear();
+
+    signals:
+        void spanChanged(double seconds);
+
+    protected:
+        void initializeGL() override;
+        void paintGL() override;
+        void resizeGL(int w, int h) override;
+        void wheelEvent(QWheelEvent* event) override;
+
+    private:
+        static constexpr size_t IMU_CHANNELS = 6;         // Accel x/y/z, gyro x/y/z
+        static constexpr size_t ORIENTATION_CHANNELS = 3; // Roll, pitch, yaw in degrees
+        static constexpr int PANE_COUNT = 3;
+        static constexpr int PANE_GAP = 6;                // Logical pixels between panes
+        static constexpr double WHEEL_ZOOM = 1.25;        // Span factor per wheel notch
+
+        using ImuPyramid = MinMaxPyramid<IMU_CHANNELS>;
+        using OrientationPyramid = MinMaxPyramid<ORIENTATION_CHANNELS>;
+
+        FusionEngine::SampleHistory* sampleSource{nullptr};
+        FusionEngine::OrientationHistory* orientationSource{nullptr};
+
+        // ~17 MB of fixed rings together, allocated once
+        ImuPyramid imuHistory;
+        OrientationPyramid orientationHistory;
+
+        // Roll/yaw unwrapping across the +-180 seam, reset by clear()
+        bool hasAngles{false};
+        std::array<float, 3> lastAngles{};
+        std::array<double, 3> unwrapOffsets{};
+
+        double spanSeconds{DEFAULT_SPAN_SECONDS};
+        bool dirty{true}; // Something to show that the last paint didn't
+        QTimer* refreshTimer;
+
+        // Per paint scratch, sized to MAX_COLUMNS up front
+        std::vector<ImuPyramid::Column> imuColumns;
+        std::vector<OrientationPyramid::Column> orientationColumns;
+        std::vector<float> vertices;
+
+        std::unique_ptr<QOpenGLShaderProgram> program;
+        QOpenGLVertexArrayObject vao;
+        QOpenGLBuffer vbo;
+
+        // Strip of one channel in this paint's vertex upload
+        struct Strip {
+            int first{0};
+            int count{0};
+        };
+
+        // One stacked plot, a channel range of one of the pyramids
+        struct Pane {
+            const char* title{""};
+            const char* channelNames[3]{};
+            bool orientation{false}; // Channels from orientationHistory, otherwise imuHistory
+            size_t firstChannel{0};
+            float low{-1.0f};        // Value range this paint, from the visible columns
+            float high{1.0f};
+            Strip strips[3];
+        };
+        Pane panes[PANE_COUNT];
+
+        void drain();
+        std::array<float, 3> unwrapAngles(const std::array<float, 3>& angles);
+
+        template <typename Column>
+        void buildPane(Pane& pane, const std::vector<Column>& columns, int columnCount);
+        void drawLabels();
+        QRect paneRect(int index) const;
+    };
+}
+
+#endif //IMU_VISUALIZER_SIGNAL_PLOT_WIDGET_H
@@ -0,0 +1,186 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#include "trail_renderer.h"
+#include "core/logger.h"
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QVector3D>
+#include <algorithm>
+
+namespace imu_viz {
+    namespace {
+        // Same colours as the world axes
+        const QVector3D AXIS_COLORS[TrailRenderer::AXIS_COUNT] = {
+                {1.0f, 0.0f, 0.0f},
+                {0.0f, 1.0f, 0.0f},
+                {0.0f, 0.0f, 1.0f}
+        };
+    }
+
+    TrailRenderer::TrailRenderer()
+            : buffer(QOpenGLBuffer::VertexBuffer)
+    {
+        buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    }
+
+    bool TrailRenderer::initialize(QOpenGLShaderProgram* trailProgram, size_t samples) {
+        QOpenGLContext* ctx = QOpenGLContext::currentContext();
+        if (!ctx || !trailProgram || !trailProgram->isLinked()) {
+            return false;
+        }
+        gl = ctx->functions();
+        program = trailProgram;
+
+        vao.create();
+        vao.bind();
+        buffer.create();
+        buffer.bind();
+
+        constexpr int stride = sizeof(Vertex);
+        program->enableAttributeArray(0);
+        program->setAttributeBuffer(0, GL_FLOAT, static_cast<int>(offsetof(Vertex, position)), 3, stride);
+        program->enableAttributeArray(1);
+        program->setAttributeBuffer(1, GL_FLOAT, static_cast<int>(offsetof(Vertex, time)), 1, stride);
+
+        vao.release();
+        buffer.release();
+
+        ready = true;
+        setCapacity(samples);
+        return true;
+    }
+
+    void TrailRenderer::destroy() {
+        buffer.destroy();
+        vao.destroy();
+        ready = false;
+    }
+
+    void TrailRenderer::setCapacity(size_t samples) {
+        capacity = std::max<size_t>(samples, 2);
+        for (auto& axis : ring) {
+            axis.assign(capacity, Vertex{});
+        }
+        clear();
+        if (!ready) return;
+
+        // Allocated once per length change, never during drawing
+        buffer.bind();
+        buffer.allocate(static_cast<int>(AXIS_COUNT * (capacity + 1) * sizeof(Vertex)));
+        buffer.release();
+        IMU_LOG_DEBUG("Trail ring {} samples per axis, {} KiB", capacity,
+                      AXIS_COUNT * (capacity + 1) * sizeof(Vertex) / 1024);
+    }
+
+    void TrailRenderer::clear() {
+        head = 0;
+        count = 0;
+        pending = 0;
+    }
+
+    void TrailRenderer::append(const Quaterniond& orientation, int64_t timeNs) {
+        if (count == 0) {
+            epochNs = timeNs;
+        } else if (timeNs - epochNs > REBASE_AFTER_NS) {
+            rebase(timeNs);
+        }
+        newestNs = timeNs;
+
+        // Columns of the rotation are the body axes in world coordinates
+        const Eigen::Matrix3d rotation = orientation.toRotationMatrix();
+        const float time = static_cast<float>(static_cast<double>(timeNs - epochNs) * 1e-9);
+        for (int axis = 0; axis < AXIS_COUNT; ++axis) {
+            Vertex& vertex = ring[axis][head];
+            vertex.position[0] = static_cast<float>(rotation(0, axis)) * TIP_LENGTH;
+            vertex.position[1] = static_cast<float>(rotation(1, axis)) * TIP_LENGTH;
+            vertex.position[2] = static_cast<float>(rotation(2, axis)) * TIP_LENGTH;
+            vertex.time = time;
+        }
+
+        head = (head + 1) % capacity;
+        count = std::min(count + 1, capacity);
+        pending = std::min(pending + 1, capacity);
+    }
+
+    void TrailRenderer::rebase(int64_t newEpochNs) {
+        // Old times go negative, still exact enough for the visible last minute. Everything goes up again
+        const double shift = static_cast<double>(newEpochNs - epochNs) * 1e-9;
+        for (auto& axis : ring) {
+            for (Vertex& vertex : axis) {
+                vertex.time = static_cast<float>(static_cast<double>(vertex.time) - shift);
+            }
+        }
+        epochNs = newEpochNs;
+        pending = count;
+    }
+
+    void TrailRenderer::upload() {
+        if (pending == 0) return;
+
+        // The pending slots end at head, wrapping at most once
+        const size_t slot = (head + capacity - pending) % capacity;
+        const size_t firstRun = std::min(pending, capacity - slot);
+
+        buffer.bind();
+        for (int axis = 0; axis < AXIS_COUNT; ++axis) {
+            const Vertex* vertices = ring[axis].data();
+            write(axis, slot, vertices + slot, firstRun);
+            if (pending > firstRun) write(axis, 0, vertices, pending - firstRun);
+        }
+        buffer.release();
+        pending = 0;
+    }
+
+    void TrailRenderer::write(int axis, size_t slot, const Vertex* vertices, size_t n) {
+        buffer.write(static_cast<int>((base(axis) + slot) * sizeof(Vertex)), vertices,
+                     static_cast<int>(n * sizeof(Vertex)));
+        if (slot == 0) {
+            // Mirror of slot 0, closes the gap between the two range draws
+            buffer.write(static_cast<int>((base(axis) + capacity) * sizeof(Vertex)), vertices,
+                         static_cast<int>(sizeof(Vertex)));
+        }
+    }
+
+    void TrailRenderer::draw(const QMatrix4x4& projection, const QMatrix4x4& view, const QMatrix4x4& model,
+                             int64_t nowNs, double durationSeconds) {
+        if (!ready) return;
+        upload();
+        if (count < 2) return;
+
+        program->bind();
+        program->setUniformValue("projection", projection);
+        program->setUniformValue("view", view);
+        program->setUniformValue("model", model);
+        program->setUniformValue("now", static_cast<float>(static_cast<double>(nowNs - epochNs) * 1e-9));
+        program->setUniformValue("duration", static_cast<float>(std::max(durationSeconds, 1e-3)));
+
+        // Faded lines blend over the scene without hiding each other
+        gl->glEnable(GL_BLEND);
+        gl->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        gl->glDepthMask(GL_FALSE);
+
+        vao.bind();
+        for (int axis = 0; axis < AXIS_COUNT; ++axis) {
+            program->setUniformValue("trailColor", AXIS_COLORS[axis]);
+            const auto first = static_cast<GLint>(base(axis));
+            if (count < capacity) {
+                // Not wrapped yet, slots 0 .. head - 1 oldest to newest
+                gl->glDrawArrays(GL_LINE_STRIP, first, static_cast<GLsizei>(count));
+            } else if (head == 0) {
+                gl->glDrawArrays(GL_LINE_STRIP, first, static_cast<GLsizei>(capacity));
+            } else {
+                // Oldest at head through the mirrored slot 0, then slot 0 up to the newest
+                gl->glDrawArrays(GL_LINE_STRIP, first + static_cast<GLint>(head),
+                                 static_cast<GLsizei>(capacity - head + 1));
+                gl->glDrawArrays(GL_LINE_STRIP, first, static_cast<GLsizei>(head));
+            }
+        }
+        vao.release();
+
+        gl->glDepthMask(GL_TRUE);
+        gl->glDisable(GL_BLEND);
+        program->release();
+    }
+}
@@ -0,0 +1,95 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_TRAIL_RENDERER_H
+#define IMU_VISUALIZER_TRAIL_RENDERER_H
+#pragma once
+
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QMatrix4x4>
+#include "core/imu_data.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class QOpenGLFunctions;
+
+namespace imu_viz {
+
+    /**
+     * Path of each body axis tip over the last few seconds, one line strip per axis.
+     *
+     * Each axis has a fixed ring of capacity vertices in one GPU buffer, with a CPU copy. New samples
+     * are written into the copy and the slots written since the last draw go up with glBufferSubData,
+     * and the ring is drawn as two ranges (oldest slot to the end, start to newest). Slot 0 is mirrored
+     * into one extra slot past the end so the two strips meet. Ageing is done in the shader, so a frame
+     * costs the new samples plus a fixed number of calls whatever the capacity.
+     *
+     * Vertex times are float seconds since epochNs. Floats lose resolution as they grow (1 ms steps
+     * past ~2.3 h, ~8 ms after a day), so once the newest is REBASE_AFTER_NS past the epoch the epoch
+     * moves up to it and the whole ring is shifted and uploaded again, every ~17 minutes of streaming.
+     */
+    class TrailRenderer {
+    public:
+        static constexpr int AXIS_COUNT = 3;
+        static constexpr float TIP_LENGTH = 1.0f; // Model units from the centre, the cube's faces are at 0.5
+
+        TrailRenderer();
+
+        // Context current. program is linked from the TRAIL_* sources in shaders.h, the caller owns it
+        bool initialize(QOpenGLShaderProgram* trailProgram, size_t samples);
+        void destroy();
+        bool isReady() const { return ready; }
+
+        // Samples kept per axis. Reallocates and drops the history, context current
+        void setCapacity(size_t samples);
+        size_t getCapacity() const { return capacity; }
+        size_t size() const { return count; }
+        void clear();
+
+        // CPU only, uploaded by the next draw. timeNs on the steady clock
+        void append(const Quaterniond& orientation, int64_t timeNs);
+
+        // Newest sample's time while size() > 0, the trail is fully faded durationSeconds after it
+        int64_t newestTimeNs() const { return newestNs; }
+
+        // Vertices older than durationSeconds at nowNs are faded out completely
+        void draw(const QMatrix4x4& projection, const QMatrix4x4& view, const QMatrix4x4& model,
+                  int64_t nowNs, double durationSeconds);
+
+    private:
+        static constexpr int64_t REBASE_AFTER_NS = 1024000000000; // 1024 s, float steps stay under 0.1 ms
+
+        struct Vertex {
+            float position[3];
+            float time; // Seconds since epochNs, kept under REBASE_AFTER_NS by rebase()
+        };
+
+        QOpenGLFunctions* gl{nullptr};
+        QOpenGLShaderProgram* program{nullptr};
+        QOpenGLVertexArrayObject vao;
+        QOpenGLBuffer buffer;
+        bool ready{false};
+
+        size_t capacity{0};
+        size_t head{0};   // Next slot written
+        size_t count{0};  // Valid slots, up to capacity
+        int64_t epochNs{0};
+        int64_t newestNs{0};
+
+        // CPU copy of each axis' ring, allocated once per capacity. pending slots before head aren't uploaded yet
+        std::array<std::vector<Vertex>, AXIS_COUNT> ring;
+        size_t pending{0};
+
+        void rebase(int64_t newEpochNs);
+        void upload();
+        void write(int axis, size_t slot, const Vertex* vertices, size_t n);
+        size_t base(int axis) const { return static_cast<size_t>(axis) * (capacity + 1); }
+    };
+}
+
+#endif //IMU_VISUALIZER_TRAIL_RENDERER_H
@@ -0,0 +1,163 @@
+//
+// Created by Raphael Russo on 12/14/24.
+//
+// Streams MockTransport -> FusionEngine and fails if the steady state path touches the heap.
+// Exit code 0 when no allocation happened after warm-up, 1 otherwise, so it can gate CI.
+//
+
+#include "processing/fusion_engine.h"
+#include "transport/mock_transport.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+    std::atomic<bool> counting{false};
+    std::atomic<uint64_t> allocations{0};
+
+    inline void recordAllocation() {
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+#if defined(__GLIBC__)
+// Containers that bypass operator new allocate through malloc, so count at the malloc level.
+// libstdc++'s operator new lands here as well.
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+
+    void* malloc(size_t size) {
+        recordAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) {
+        recordAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size) {
+        recordAllocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        recordAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** ptr, size_t alignment, size_t size) {
+        recordAllocation();
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr ? 0 : ENOMEM;
+    }
+}
+#else
+// Elsewhere only operator new can be replaced portably
+void* operator new(size_t size) {
+    recordAllocation();
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+#endif
+
+using namespace imu_viz;
+
+int main(int argc, char* argv[]) {
+    uint64_t samples = 5000;
+    double rateHz = 2000.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc) {
+            samples = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rateHz = std::atof(argv[++i]);
+        }
+    }
+    constexpr uint64_t WARMUP_SAMPLES = 500;
+
+    // No timers, the loop below pumps the engine by hand
+    FusionEngine processor;
+    std::atomic<uint64_t> published{0};
+    FusionEngine::Callbacks callbacks;
+    callbacks.orientation = [&published](const OrientationSample&) { published.fetch_add(1, std::memory_order_relaxed); };
+    processor.setCallbacks(std::move(callbacks));
+
+    MockTransport transport;
+    transport.setSampleRate(rateHz);
+    transport.setDataCallback([&processor](const IMUData& data) {
+        processor.submitIMUData(data);
+    });
+
+    auto processed = [&processor]() { return processor.getResamplerStats().inputSamples; };
+    auto pumpUntil = [&](uint64_t target) {
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::duration<double>(10.0 + 2.0 * target / rateHz);
+        while (processed() < target) {
+            processor.drainSubmitted();
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return true;
+    };
+
+    transport.connect();
+
+    // First use allocations (thread locals, lazily built state) happen here
+    if (!pumpUntil(WARMUP_SAMPLES)) {
+        std::fprintf(stderr, "allocation_check: mock transport produced no data\n");
+        return 1;
+    }
+
+    const uint64_t start = processed();
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+    Eigen::internal::set_is_malloc_allowed(false); // Dynamic Eigen temporaries abort instead
+#endif
+    counting.store(true);
+    const bool completed = pumpUntil(start + samples);
+    counting.store(false);
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+    Eigen::internal::set_is_malloc_allowed(true);
+#endif
+
+    const uint64_t streamed = processed() - start;
+    transport.disconnect();
+
+    std::printf("allocation_check: %llu samples at %.0f Hz, %llu published, %llu allocations, %llu dropped at hand off\n",
+                static_cast<unsigned long long>(streamed), rateHz,
+                static_cast<unsigned long long>(published.load()),
+                static_cast<unsigned long long>(allocations.load()),
+                static_cast<unsigned long long>(processor.getSubmitOverflows()));
+
+    if (!completed) {
+        std::fprintf(stderr, "allocation_check: timed out before %llu samples\n",
+                     static_cast<unsigned long long>(samples));
+        return 1;
+    }
+    if (allocations.load() != 0) {
+        std::fprintf(stderr, "allocation_check: FAILED, the steady state path allocated\n");
+        return 1;
+    }
+    std::printf("allocation_check: OK\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+// FusionEngine across stream changes: reconnects and transport switches must not stall the output.
+//
+
+#include "test_utils.h"
+#include "processing/fusion_engine.h"
+
+#include <atomic>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace imu_viz;
+
+namespace {
+    struct Output {
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> lastTimestamp{0};
+        std::atomic<uint64_t> concealed{0};
+        std::atomic<int64_t> lastArrivalNs{0};
+    };
+
+    void attach(FusionEngine& engine, Output& output) {
+        FusionEngine::Callbacks callbacks;
+        callbacks.orientation = [&output](const OrientationSample& sample) {
+            output.published.fetch_add(1);
+            output.lastTimestamp.store(sample.timestamp);
+            output.lastArrivalNs.store(sample.arrivalTimeNs);
+            if (sample.concealed) output.concealed.fetch_add(1);
+        };
+        engine.setCallbacks(std::move(callbacks));
+    }
+
+    // 1 kHz still sensor from start, the default pipeline runs inline so it's all published on return
+    void stream(FusionEngine& engine, uint64_t start, int samples) {
+        IMUData data{};
+        data.acceleration = Vector3d(0.0, 0.0, 9.81);
+        data.gyroscope = Vector3d::Zero();
+        for (int i = 0; i < samples; ++i) {
+            data.timestamp = start + static_cast<uint64_t>(i) * 1000;
+            engine.processIMUData(data);
+        }
+    }
+
+    void testMockReconnectKeepsPublishing() {
+        // The mock transport's clock starts over at 0 on every connect
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+
+        stream(engine, 0, 200);
+        IMU_CHECK(output.published.load() == 200);
+
+        stream(engine, 0, 200);
+        IMU_CHECK(output.published.load() == 400);
+        IMU_CHECK(output.lastTimestamp.load() == 199000);
+    }
+
+    void testTransportSwitchWithReset() {
+        // TCP on the system clock, then back to the mock from 0
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+
+        const uint64_t epochUs = 1734700000000000ull;
+        stream(engine, epochUs, 200);
+        engine.resetStream();
+        stream(engine, 0, 200);
+        IMU_CHECK(output.published.load() == 400);
+        IMU_CHECK(output.lastTimestamp.load() == 199000);
+        IMU_CHECK(engine.getResamplerStats().mergedSamples == 0);
+    }
+
+    // Long enough for the concealer to see a gap, short of its MAX_CONCEALMENT_MS
+    void waitPastGapThreshold() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+                static_cast<int>(GapConcealer::MIN_GAP_MS * 3)));
+    }
+
+    void testDropoutIsConcealed() {
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+
+        stream(engine, 0, 200);
+        waitPastGapThreshold();
+        engine.concealGap();
+        IMU_CHECK(output.concealed.load() == 1);
+    }
+
+    void testDeliberateDisconnectIsNotConcealed() {
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+
+        stream(engine, 0, 200);
+        engine.stopStream();
+        stream(engine, 200000, 10); // Still queued at the disconnect
+        waitPastGapThreshold();
+        engine.concealGap();
+        IMU_CHECK(output.concealed.load() == 0);
+
+        // Concealment is back once a new stream starts
+        engine.resetStream();
+        stream(engine, 0, 200);
+        waitPastGapThreshold();
+        engine.concealGap();
+        IMU_CHECK(output.concealed.load() == 1);
+    }
+
+    std::vector<IMUData> batchOf(uint64_t start, size_t samples, int64_t arrivalStartNs) {
+        std::vector<IMUData> batch(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            batch[i].timestamp = start + i * 1000;
+            batch[i].acceleration = Vector3d(0.0, 0.0, 9.81);
+            batch[i].gyroscope = Vector3d::Zero();
+            batch[i].arrivalTimeNs = arrivalStartNs != 0 ? arrivalStartNs + static_cast<int64_t>(i) : 0;
+            batch[i].decodeTimeNs = batch[i].arrivalTimeNs;
+        }
+        return batch;
+    }
+
+    void testBatchCarriesStamps() {
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+
+        // Over one scratch chunk, the last frame's stamps are the last sample's
+        const std::vector<IMUData> stamped = batchOf(0, 100, 5000);
+        engine.processIMUBatch(stamped.data(), stamped.size());
+        IMU_CHECK(output.published.load() == 100);
+        IMU_CHECK(output.lastArrivalNs.load() == 5099);
+
+        // Replayed samples have none, nothing may leak in from the previous batch
+        const std::vector<IMUData> replayed = batchOf(100000, 100, 0);
+        engine.processIMUBatch(replayed.data(), replayed.size());
+        IMU_CHECK(output.published.load() == 200);
+        IMU_CHECK(output.lastArrivalNs.load() == 0);
+    }
+
+    void testBatchFeedsPlotTap() {
+        FusionEngine engine;
+        engine.setHistoryEnabled(FusionEngine::HistoryTap::PLOT, true);
+
+        const std::vector<IMUData> samples = batchOf(0, 100, 5000);
+        engine.processIMUBatch(samples.data(), samples.size());
+
+        size_t tapped = 0;
+        IMUData data;
+        while (engine.getSampleHistory().tryPop(data)) {
+            IMU_CHECK(data.timestamp == tapped * 1000);
+            ++tapped;
+        }
+        IMU_CHECK(tapped == samples.size());
+    }
+
+    void testSubmittedSamplesAreBatched() {
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+
+        for (const IMUData& data : batchOf(0, 150, 5000)) {
+            engine.submitIMUData(data);
+        }
+        engine.drainSubmitted();
+        IMU_CHECK(output.published.load() == 150);
+        IMU_CHECK(output.lastArrivalNs.load() == 5149);
+    }
+
+    void testBatchRunsStagesAheadOfResample() {
+        // metrics first can't be skipped, each sample takes the whole pipeline
+        FusionEngine engine;
+        Output output;
+        attach(engine, output);
+        IMU_CHECK(engine.setPipelineConfig("metrics,validate,calibrate,resample,filter,smooth,publish"));
+
+        const std::vector<IMUData> samples = batchOf(0, 100, 5000);
+        engine.processIMUBatch(samples.data(), samples.size());
+        IMU_CHECK(output.published.load() == 100);
+        for (const StageStats& stage : engine.getPipelineStats()) {
+            IMU_CHECK(stage.processed == samples.size());
+        }
+    }
+
+    void testBadPipelineCapacityKeepsOldPipeline() {
+        FusionEngine engine;
+        int errors = 0;
+        FusionEngine::Callbacks callbacks;
+        callbacks.error = [&errors](const std::string&) { ++errors; };
+        engine.setCallbacks(std::move(callbacks));
+
+        const std::string before = engine.getPipelineConfig();
+        const std::string tooLarge = "validate,calibrate,resample,filter@thread/4000000000,smooth,publish";
+        const std::string overflows = "validate,calibrate,resample,filter@thread/" + std::string(40, '9') + ",smooth,publish";
+        IMU_CHECK(!engine.setPipelineConfig(tooLarge));
+        IMU_CHECK(!engine.setPipelineConfig(overflows));
+        IMU_CHECK(!engine.setPipelineConfig("validate,calibrate,resample,filter@thread/-1,smooth,publish"));
+        IMU_CHECK(errors == 3);
+        IMU_CHECK(engine.getPipelineConfig() == before);
+
+        const std::string largest = "validate,calibrate,resample,filter@thread/" +
+                                    std::to_string(Pipeline::MAX_QUEUE_CAPACITY) + ",smooth,publish";
+        IMU_CHECK(engine.setPipelineConfig(largest));
+        IMU_CHECK(errors == 3);
+    }
+}
+
+int main() {
+    test::run("fusion_engine/mock_reconnect_keeps_publishing", testMockReconnectKeepsPublishing);
+    test::run("fusion_engine/transport_switch_with_reset", testTransportSwitchWithReset);
+    test::run("fusion_engine/dropout_is_concealed", testDropoutIsConcealed);
+    test::run("fusion_engine/deliberate_disconnect_is_not_concealed", testDeliberateDisconnectIsNotConcealed);
+    test::run("fusion_engine/batch_carries_stamps", testBatchCarriesStamps);
+    test::run("fusion_engine/batch_feeds_plot_tap", testBatchFeedsPlotTap);
+    test::run("fusion_engine/submitted_samples_are_batched", testSubmittedSamplesAreBatched);
+    test::run("fusion_engine/batch_runs_stages_ahead_of_resample", testBatchRunsStagesAheadOfResample);
+    test::run("fusion_engine/bad_pipeline_capacity_keeps_old_pipeline", testBadPipelineCapacityKeepsOldPipeline);
+    return test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+// JitterBuffer bookkeeping: every sample pushed is either released, still buffered or counted as a drop.
+//
+
+#include "test_utils.h"
+#include "processing/timing/jitter_buffer.h"
+
+using namespace imu_viz;
+
+namespace {
+    constexpr int64_t PERIOD_NS = 10000000; // 100 Hz
+
+    IMUData sample(uint32_t sequence) {
+        IMUData data{};
+        data.acceleration = Vector3d(0.0, 0.0, 9.81);
+        data.gyroscope = Vector3d::Zero();
+        data.sequence = sequence;
+        return data;
+    }
+
+    uint64_t accounted(const JitterBuffer::Stats& stats) {
+        return stats.released + stats.buffered + stats.lateDrops + stats.duplicateDrops +
+               stats.overflowDrops + stats.restartDrops;
+    }
+
+    void testEvenStreamReleasesEverything() {
+        JitterBuffer buffer;
+        IMUData out;
+        uint64_t released = 0;
+        for (uint32_t i = 0; i < 100; ++i) {
+            buffer.push(sample(i), i * PERIOD_NS);
+            while (buffer.pop(i * PERIOD_NS, out)) ++released;
+        }
+        while (buffer.pop(INT64_MAX, out)) ++released;
+        IMU_CHECK(released == 100);
+        IMU_CHECK(accounted(buffer.getStats()) == 100);
+    }
+
+    void testRestartCountsHeldSamples() {
+        JitterBuffer buffer;
+        for (uint32_t i = 0; i < 10; ++i) {
+            buffer.push(sample(i), i * PERIOD_NS); // Never popped, all still held
+        }
+        IMU_CHECK(buffer.getStats().buffered == 10);
+
+        buffer.restart();
+        const JitterBuffer::Stats stats = buffer.getStats();
+        IMU_CHECK(stats.buffered == 0);
+        IMU_CHECK(stats.restartDrops == 10);
+        IMU_CHECK(accounted(stats) == 10);
+    }
+
+    void testSilenceRestartCountsHeldSamples() {
+        // A long gap in arrivals starts a new stream on its own
+        JitterBuffer buffer;
+        for (uint32_t i = 0; i < 10; ++i) {
+            buffer.push(sample(i), i * PERIOD_NS);
+        }
+        buffer.push(sample(0), 5000000000);
+        const JitterBuffer::Stats stats = buffer.getStats();
+        IMU_CHECK(stats.restartDrops == 10);
+        IMU_CHECK(stats.buffered == 1);
+        IMU_CHECK(accounted(stats) == 11);
+    }
+}
+
+int main() {
+    test::run("jitter_buffer/even_stream_releases_everything", testEvenStreamReleasesEverything);
+    test::run("jitter_buffer/restart_counts_held_samples", testRestartCountsHeldSamples);
+    test::run("jitter_buffer/silence_restart_counts_held_samples", testSilenceRestartCountsHeldSamples);
+    return test::failures() == 0 ? 0 : 1;
+}
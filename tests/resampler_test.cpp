@@ -0,0 +1,116 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+// Resampler windowing across clock steps: reordering, source restarts and reset().
+//
+
+#include "test_utils.h"
+#include "processing/timing/resampler.h"
+
+using namespace imu_viz;
+
+namespace {
+    const Vector3d GRAVITY(0.0, 0.0, 9.81);
+    const Vector3d ROTATION(0.1, 0.0, 0.0);
+
+    bool add(Resampler& resampler, uint64_t timestamp, ResampledSample& out) {
+        return resampler.add(timestamp, GRAVITY, ROTATION, out);
+    }
+
+    // 1 kHz from start, returns how many windows closed
+    int stream(Resampler& resampler, uint64_t start, int samples) {
+        ResampledSample out{};
+        int windows = 0;
+        for (int i = 0; i < samples; ++i) {
+            windows += add(resampler, start + static_cast<uint64_t>(i) * 1000, out) ? 1 : 0;
+        }
+        return windows;
+    }
+
+    void testEveryAdvanceClosesAWindow() {
+        Resampler resampler;
+        IMU_CHECK(stream(resampler, 1000, 100) == 100);
+        IMU_CHECK(resampler.getStats().mergedSamples == 0);
+        IMU_CHECK(resampler.getStats().restarts == 0);
+    }
+
+    void testSmallStepBackMerges() {
+        Resampler resampler;
+        ResampledSample out{};
+        IMU_CHECK(add(resampler, 1000, out));
+        IMU_CHECK(add(resampler, 2000, out));
+        IMU_CHECK(!add(resampler, 1500, out)); // Reordered, folded into the next window
+        IMU_CHECK(add(resampler, 3000, out));
+        IMU_CHECK(out.sourceCount == 2);
+        IMU_CHECK(out.deltaTime > 0.00099 && out.deltaTime < 0.00101);
+        IMU_CHECK(resampler.getStats().restarts == 0);
+    }
+
+    void testClockRestartReanchors() {
+        // Mock transport reconnecting: its clock starts over at 0
+        Resampler resampler;
+        stream(resampler, 5000000, 50);
+
+        ResampledSample out{};
+        IMU_CHECK(add(resampler, 0, out));
+        IMU_CHECK(out.deltaTime == 0.0);
+        IMU_CHECK(resampler.getStats().restarts == 1);
+
+        // And keeps producing windows on the new clock
+        IMU_CHECK(add(resampler, 1000, out));
+        IMU_CHECK(out.deltaTime > 0.00099 && out.deltaTime < 0.00101);
+        IMU_CHECK(stream(resampler, 2000, 100) == 100);
+    }
+
+    void testRestartKeepsHeldSamples() {
+        // Decimating to 100 Hz holds samples back, a restart must not lose them
+        Resampler resampler;
+        resampler.setOutputRate(100.0);
+        stream(resampler, 5000000, 15);
+
+        const uint64_t before = resampler.getStats().outputSamples + resampler.getStats().mergedSamples;
+        ResampledSample out{};
+        IMU_CHECK(add(resampler, 0, out));
+        IMU_CHECK(out.sourceCount > 1);
+        const ResamplerStats& stats = resampler.getStats();
+        IMU_CHECK(stats.outputSamples + stats.mergedSamples == stats.inputSamples);
+        IMU_CHECK(stats.outputSamples + stats.mergedSamples > before);
+    }
+
+    void testResetCountsHeldSamples() {
+        // Decimating to 100 Hz, reset() mid window: every input is output, merged or discarded
+        Resampler resampler;
+        resampler.setOutputRate(100.0);
+        stream(resampler, 0, 15);
+        resampler.reset();
+        IMU_CHECK(resampler.getStats().discardedSamples == 4);
+
+        stream(resampler, 1000000, 21); // Ends on a window boundary, nothing left held
+        const ResamplerStats& stats = resampler.getStats();
+        IMU_CHECK(stats.inputSamples == stats.outputSamples + stats.mergedSamples + stats.discardedSamples);
+    }
+
+    void testResetAfterTransportSwitch() {
+        // Mock from 0, then TCP on the system clock: a jump forward, reset() keeps it out of dt
+        Resampler resampler;
+        stream(resampler, 0, 50);
+        resampler.reset();
+
+        ResampledSample out{};
+        const uint64_t epochUs = 1734700000000000ull;
+        IMU_CHECK(add(resampler, epochUs, out));
+        IMU_CHECK(out.deltaTime == 0.0);
+        IMU_CHECK(add(resampler, epochUs + 1000, out));
+        IMU_CHECK(out.deltaTime > 0.00099 && out.deltaTime < 0.00101);
+    }
+}
+
+int main() {
+    test::run("resampler/every_advance_closes_a_window", testEveryAdvanceClosesAWindow);
+    test::run("resampler/small_step_back_merges", testSmallStepBackMerges);
+    test::run("resampler/clock_restart_reanchors", testClockRestartReanchors);
+    test::run("resampler/restart_keeps_held_samples", testRestartKeepsHeldSamples);
+    test::run("resampler/reset_counts_held_samples", testResetCountsHeldSamples);
+    test::run("resampler/reset_after_transport_switch", testResetAfterTransportSwitch);
+    return test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Raphael Russo on 12/20/24.
+//
+
+#ifndef IMU_VISUALIZER_TEST_UTILS_H
+#define IMU_VISUALIZER_TEST_UTILS_H
+#pragma once
+
+#include <cstdio>
+
+namespace imu_viz::test {
+
+    // Failed checks so far, main() returns non-zero if any
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool check(bool passed, const char* expression, const char* file, int line) {
+        if (!passed) {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+            ++failures();
+        }
+        return passed;
+    }
+
+    // Runs one test function and reports it by name
+    template<typename Fn>
+    inline void run(const char* name, Fn&& fn) {
+        const int before = failures();
+        fn();
+        std::printf("%-48s %s\n", name, failures() == before ? "ok" : "FAILED");
+    }
+}
+
+// Keeps going after a failure so one run shows every broken check
+#define IMU_CHECK(expression) ::imu_viz::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif //IMU_VISUALIZER_TEST_UTILS_H